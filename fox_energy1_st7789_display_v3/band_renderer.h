@@ -0,0 +1,491 @@
+/*
+ * Band Renderer
+ * Layout-independent rendering core: panel setup, dirty region tracking,
+ * band rasterisation through the glyph cache and DMA flushes
+ * A scene is a fixed list of widget rectangles; the renderer decides what
+ * to redraw and the scene only knows how to draw a widget.
+ */
+
+#ifndef BAND_RENDERER_H
+#define BAND_RENDERER_H
+
+#include <Adafruit_GFX.h>
+#include <Adafruit_ST7789.h>
+#include <SPI.h>
+#include "config.h"
+#include "types.h"
+#include "dma_flusher.h"
+#include "buffer_arena.h"
+#include "glyph_cache.h"
+#include "firmware_stats.h"
+#include "profiler.h"
+
+#define SCENE_MAX_WIDGETS  PROFILER_MAX_WIDGETS   // One profiler slot per widget
+
+/**
+ * Band canvas drawing into the static arena instead of a heap buffer
+ * (needs Adafruit GFX 1.11.5 or newer for the non-allocating constructor)
+ */
+class BandCanvas : public GFXcanvas16 {
+public:
+    BandCanvas(uint16_t w, uint16_t h, uint16_t* pixels) : GFXcanvas16(w, h, false) {
+        buffer = pixels;
+    }
+};
+
+/**
+ * Panel seen through one clip rectangle, for rendering without a band
+ * Widgets draw whole, as into a band; only pixels inside the clip reach
+ * the panel, so the direct path redraws exactly the dirty rectangle
+ */
+class ClippedPanel : public Adafruit_GFX {
+public:
+    ClippedPanel(Adafruit_ST7789* panel, const DirtyRegion& clip) :
+        Adafruit_GFX(panel->width(), panel->height()),
+        tft(panel),
+        x0(clip.x), y0(clip.y),
+        x1(clip.x + clip.width), y1(clip.y + clip.height) {}
+    
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override {
+        if (x >= x0 && x < x1 && y >= y0 && y < y1) {
+            tft->drawPixel(x, y, color);
+        }
+    }
+    
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override {
+        int16_t cx0 = max(x, x0);
+        int16_t cy0 = max(y, y0);
+        int16_t cx1 = min((int16_t)(x + w), x1);
+        int16_t cy1 = min((int16_t)(y + h), y1);
+        if (cx0 < cx1 && cy0 < cy1) {
+            tft->fillRect(cx0, cy0, cx1 - cx0, cy1 - cy0, color);
+        }
+    }
+    
+    void writePixel(int16_t x, int16_t y, uint16_t color) override {
+        drawPixel(x, y, color);
+    }
+    
+    void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override {
+        fillRect(x, y, w, h, color);
+    }
+    
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override {
+        fillRect(x, y, w, 1, color);
+    }
+    
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override {
+        fillRect(x, y, 1, h, color);
+    }
+    
+    void writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override {
+        fillRect(x, y, w, 1, color);
+    }
+    
+    void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override {
+        fillRect(x, y, 1, h, color);
+    }
+    
+    void fillScreen(uint16_t color) override {
+        fillRect(0, 0, width(), height(), color);
+    }
+
+private:
+    Adafruit_ST7789* tft;
+    int16_t x0, y0, x1, y1;
+};
+
+/**
+ * What a layout provides to the renderer
+ * Both calls take screen coordinates; y_offset is the screen row mapped
+ * to row 0 of the target (the band's top row, or 0 on the panel)
+ */
+class RenderScene {
+public:
+    virtual ~RenderScene() {}
+    
+    /**
+     * Clear a screen rectangle to the scene background
+     */
+    virtual void fillBackground(Adafruit_GFX* target, int x, int y, int w, int h, int y_offset) = 0;
+    
+    /**
+     * Draw one widget with its current content (clipped by the target)
+     */
+    virtual void drawWidget(Adafruit_GFX* target, int id, int y_offset) = 0;
+};
+
+class BandRenderer {
+public:
+    BandRenderer() :
+        tft(nullptr),
+        band(nullptr),
+        scene(nullptr),
+        buffer_mode(DIRECT),
+        dma_enabled(false),
+        screen_width(0),
+        screen_height(0),
+        widget_count(0),
+        render_clip_x0(0),
+        render_clip_x1(SCREEN_WIDTH),
+        stats(nullptr),
+        flush_us(0) {}
+    
+    ~BandRenderer() {
+        if (band) delete band;
+    }
+    
+    /**
+     * Initialize the panel in DISPLAY_ROTATION and set up the band buffer
+     * and DMA flush
+     */
+    void begin(RenderScene* render_scene) {
+        scene = render_scene;
+        
+        tft = new Adafruit_ST7789(TFT_CS, TFT_DC, TFT_RST);
+        // Initialize with physical dimensions (240, 320) before rotation
+        tft->init(240, 320);
+        tft->setRotation(DISPLAY_ROTATION);
+        screen_width = tft->width();
+        screen_height = tft->height();
+        
+        // Pre-rasterise the dashboard glyphs
+        if (ENABLE_GLYPH_CACHE) {
+            glyphs.begin();
+        }
+        
+        Serial.printf("Display initialized: %dx%d\n", screen_width, screen_height);
+        
+        // Band buffer for tile rendering, from the static arena
+        if (ENABLE_DOUBLE_BUFFER) {
+            // Band canvas (screen width x TILE_HEIGHT, 19.2KB landscape)
+            Serial.printf("Band canvas (%dx%d)... ", screen_width, TILE_HEIGHT);
+            uint16_t* pixels = (uint16_t*)BufferArena::get(ARENA_BAND);
+            
+            if (pixels && screen_width * TILE_HEIGHT <= TILE_BUFFER_SIZE) {
+                band = new BandCanvas(screen_width, TILE_HEIGHT, pixels);
+            }
+            if (!band) {
+                Serial.println("FAILED!");
+            } else {
+                Serial.printf("OK (arena, %d KB heap free)\n", ESP.getFreeHeap() / 1024);
+            }
+            
+            if (band) {
+                buffer_mode = TILE;
+                Serial.println("Tile rendering enabled - flicker-free mode!");
+                
+                // Hand band flushes to the DMA engine
+                if (ENABLE_SPI_DMA) {
+                    dma_enabled = dma.begin();
+                    Serial.println(dma_enabled ? "SPI DMA flush enabled"
+                                               : "SPI DMA unavailable, using blocking flush");
+                }
+            } else {
+                buffer_mode = DIRECT;
+                Serial.println("WARNING: Band allocation failed, using direct rendering");
+            }
+        } else {
+            buffer_mode = DIRECT;
+            Serial.println("Double buffering disabled, using direct rendering");
+        }
+    }
+    
+    Adafruit_ST7789* panel() {
+        return tft;
+    }
+    
+    /**
+     * Band buffer (nullptr in direct mode)
+     */
+    GFXcanvas16* canvas() {
+        return band;
+    }
+    
+    int width() const {
+        return screen_width;
+    }
+    
+    int height() const {
+        return screen_height;
+    }
+    
+    // --- Scene Description ---
+    
+    /**
+     * Place widget id (below SCENE_MAX_WIDGETS) at a screen rectangle
+     */
+    void setWidget(int id, int x, int y, int w, int h) {
+        widgets[id].mark(x, y, w, h);
+        if (id >= widget_count) widget_count = id + 1;
+    }
+    
+    /**
+     * Remove every widget (before describing the scene again)
+     */
+    void clearWidgets() {
+        for (int id = 0; id < widget_count; id++) {
+            widgets[id] = DirtyRegion();
+        }
+        widget_count = 0;
+    }
+    
+    const DirtyRegion& widget(int id) const {
+        return widgets[id];
+    }
+    
+    // --- Dirty Tracking ---
+    
+    /**
+     * Record a screen rectangle that needs re-rasterising
+     */
+    void markDirty(int x, int y, int w, int h) {
+        // Clip to screen bounds
+        if (x < 0) { w += x; x = 0; }
+        if (y < 0) { h += y; y = 0; }
+        if (x + w > screen_width) w = screen_width - x;
+        if (y + h > screen_height) h = screen_height - y;
+        
+        dirty.mark(x, y, w, h);
+    }
+    
+    void markWidgetDirty(int id) {
+        const DirtyRegion& w = widgets[id];
+        markDirty(w.x, w.y, w.width, w.height);
+    }
+    
+    /**
+     * Record text that replaced previously drawn text
+     * Marks the union of old and new bounds and remembers the new bounds
+     */
+    void markTextDirty(DirtyRegion& bounds, int x, int y, int w, int h) {
+        if (bounds.is_dirty) {
+            markDirty(bounds.x, bounds.y, bounds.width, bounds.height);
+        }
+        markDirty(x, y, w, h);
+        bounds.mark(x, y, w, h);
+    }
+    
+    /**
+     * Columns being re-rasterised (widgets may skip drawing outside them)
+     */
+    int clipX0() const {
+        return render_clip_x0;
+    }
+    
+    int clipX1() const {
+        return render_clip_x1;
+    }
+    
+    // --- Rendering ---
+    
+    /**
+     * Re-rasterise the dirty regions, recording the duration and flush
+     * share under target
+     */
+    void render(RenderTarget target) {
+        if (dirty.isEmpty()) return;
+        
+        PROFILE_SCOPE(PROF_RENDER);
+        uint32_t start = micros();
+        flush_us = 0;
+        renderDirty();
+        if (stats) {
+            stats->render[target].record(micros() - start);
+            stats->flush.record(flush_us);
+        }
+    }
+    
+    /**
+     * Draw text at screen position on a band/target
+     * Band targets get the direct-to-buffer glyph blit
+     */
+    void drawText(Adafruit_GFX* target, const char* text, int font_size, uint16_t color,
+                  int x, int y, int y_offset) {
+        if (target == (Adafruit_GFX*)band) {
+            glyphs.drawString(band, x, y - y_offset, text, font_size, color);
+        } else {
+            glyphs.drawString(target, x, y - y_offset, text, font_size, color);
+        }
+    }
+    
+    /**
+     * Push a screen rectangle from the band buffer (band starts at screen row band_y)
+     */
+    void flushBandRect(int band_y, int x, int y, int w, int h) {
+        uint16_t* buffer = band->getBuffer() + (y - band_y) * band->width() + x;
+        int stride = band->width();
+        uint32_t start = micros();
+        PROFILE_SCOPE(PROF_FLUSH);
+        PROFILE_COUNT(PROF_PIXELS_PUSHED, (uint32_t)w * h);
+        
+        // Queue for DMA, the CPU returns as soon as pixels are copied
+        if (dma_enabled && dma.acquire()) {
+            dma.pushRect(buffer, stride, x, y, w, h);
+            flush_us += micros() - start;
+            return;
+        }
+        
+        tft->startWrite();
+        tft->setAddrWindow(x, y, w, h);
+        if (x == 0 && w == stride) {
+            // Full-width rows are contiguous in the band buffer
+            tft->writePixels(buffer, (uint32_t)w * h);
+        } else {
+            for (int row = 0; row < h; row++) {
+                tft->writePixels(buffer + row * stride, w);
+            }
+        }
+        tft->endWrite();
+        flush_us += micros() - start;
+    }
+    
+    /**
+     * Return the SPI bus to Adafruit_ST7789 before drawing directly
+     * The DMA path takes it back on the next band flush
+     */
+    void beginDirectDraw() {
+        if (dma_enabled) {
+            dma.release();
+        }
+    }
+    
+    /**
+     * Record render and flush times (may be nullptr)
+     */
+    void setStats(FirmwareStats* firmware_stats) {
+        stats = firmware_stats;
+    }
+    
+    /**
+     * Register callback fired when a DMA flush of a region completes
+     * Runs in interrupt context
+     */
+    void setFlushCompleteCallback(DmaFlusher::CompletionCallback callback, void* arg) {
+        dma.setCompletionCallback(callback, arg);
+    }
+    
+    /**
+     * Check if pixels are still being transferred in the background
+     */
+    bool isFlushing() {
+        return dma_enabled && dma.isBusy();
+    }
+    
+    /**
+     * Block until queued DMA transfers are on the panel
+     */
+    void waitFlush() {
+        if (dma_enabled) dma.waitIdle();
+    }
+
+private:
+#ifdef HOST_BUILD
+    friend class HostBench;   // host/bench.cpp times the private helpers
+#endif
+    Adafruit_ST7789* tft;
+    BandCanvas* band;
+    RenderScene* scene;
+    BufferMode buffer_mode;
+    DmaFlusher dma;
+    bool dma_enabled;
+    GlyphCache glyphs;
+    int screen_width, screen_height;
+    
+    // Scene description (screen coordinates)
+    DirtyRegion widgets[SCENE_MAX_WIDGETS];
+    int widget_count;
+    
+    // Dirty region tracking (screen coordinates)
+    DirtyRegionList dirty;
+    int render_clip_x0, render_clip_x1;   // Columns being re-rasterised
+    
+    // Render timing
+    FirmwareStats* stats;
+    uint32_t flush_us;                    // Flush time within the current pass
+    
+    /**
+     * Re-rasterise all dirty regions
+     * Each band is cleared, every widget touching a dirty part of it is drawn
+     * (clipped by the band), then only the dirty sub-rectangles are flushed
+     */
+    void renderDirty() {
+        if (dirty.isEmpty()) return;
+        
+        if (!band) {
+            renderDirect();
+            return;
+        }
+        
+        for (int band_y = 0; band_y < screen_height; band_y += TILE_HEIGHT) {
+            int band_h = min(TILE_HEIGHT, screen_height - band_y);
+            
+            // Collect the dirty sub-rectangles inside this band
+            DirtyRegion clips[MAX_DIRTY_REGIONS];
+            uint8_t clip_count = 0;
+            for (uint8_t i = 0; i < dirty.count; i++) {
+                const DirtyRegion& r = dirty.regions[i];
+                int y0 = max((int)r.y, band_y);
+                int y1 = min(r.y + r.height, band_y + band_h);
+                if (y0 < y1) {
+                    clips[clip_count++].mark(r.x, y0, r.width, y1 - y0);
+                }
+            }
+            if (clip_count == 0) continue;
+            
+            render_clip_x0 = screen_width;
+            render_clip_x1 = 0;
+            for (uint8_t i = 0; i < clip_count; i++) {
+                render_clip_x0 = min(render_clip_x0, (int)clips[i].x);
+                render_clip_x1 = max(render_clip_x1, clips[i].x + clips[i].width);
+            }
+            
+            scene->fillBackground(band, 0, band_y, screen_width, band_h, band_y);
+            for (int id = 0; id < widget_count; id++) {
+                const DirtyRegion& w = widgets[id];
+                for (uint8_t i = 0; i < clip_count; i++) {
+                    if (intersects(w, clips[i])) {
+                        PROFILE_SCOPE(PROF_WIDGET_BASE + id);
+                        scene->drawWidget(band, id, band_y);
+                        break;
+                    }
+                }
+            }
+            
+            for (uint8_t i = 0; i < clip_count; i++) {
+                flushBandRect(band_y, clips[i].x, clips[i].y, clips[i].width, clips[i].height);
+            }
+        }
+        
+        dirty.clear();
+    }
+    
+    /**
+     * Fallback without band buffer: the same pass as a band, drawn
+     * straight to the panel through a view clipped to each dirty rectangle
+     */
+    void renderDirect() {
+        beginDirectDraw();
+        for (uint8_t i = 0; i < dirty.count; i++) {
+            const DirtyRegion& r = dirty.regions[i];
+            ClippedPanel target(tft, r);
+            render_clip_x0 = r.x;
+            render_clip_x1 = r.x + r.width;
+            scene->fillBackground(&target, r.x, r.y, r.width, r.height, 0);
+            for (int id = 0; id < widget_count; id++) {
+                if (intersects(widgets[id], r)) {
+                    PROFILE_SCOPE(PROF_WIDGET_BASE + id);
+                    scene->drawWidget(&target, id, 0);
+                }
+            }
+        }
+        dirty.clear();
+    }
+    
+    bool intersects(const DirtyRegion& a, const DirtyRegion& b) {
+        return a.x < b.x + b.width && b.x < a.x + a.width &&
+               a.y < b.y + b.height && b.y < a.y + a.height;
+    }
+};
+
+#endif // BAND_RENDERER_H
@@ -0,0 +1,244 @@
+/*
+ * Render and Fetch Benchmark (development builds)
+ * Repeatable scenarios run at boot when ENABLE_BENCHMARK is true;
+ * results are printed as CSV lines starting with "BENCH,"
+ */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <Arduino.h>
+#include <algorithm>
+#include "config.h"
+#include "types.h"
+#include "display_manager.h"
+#include "data_fetcher.h"
+
+#define BENCHMARK_MAX_SAMPLES  (BENCHMARK_ITERATIONS > BENCHMARK_FETCHES ? BENCHMARK_ITERATIONS : BENCHMARK_FETCHES)
+
+/**
+ * Drives DisplayManager and DataFetcher through fixed scenarios.
+ * Render timings include waiting for the DMA flush, so they measure
+ * time until the pixels are on the panel. Run before the fetch task is
+ * started (the fetcher is used directly).
+ */
+class Benchmark {
+public:
+    Benchmark(DisplayManager* display_manager, DataFetcher* data_fetcher) :
+        display(display_manager),
+        fetcher(data_fetcher),
+        sample_count(0),
+        ok_count(0) {}
+    
+    void run(const char* url) {
+        Serial.println("\n=== Benchmark ===");
+        Serial.println("BENCH,scenario,n,min_us,p50_us,avg_us,max_us,ok");
+        
+        benchFullRedraw();
+        benchDigitChange();
+        benchStatusTick();
+        benchKwSweep();
+        benchGraphColumn();
+        benchFill();
+        benchBlit();
+        benchFetch(url);
+        
+        // Leave the panel as the dashboard expects it
+        display->drawInitialUI();
+        Serial.println("=== Benchmark done ===\n");
+    }
+
+private:
+    DisplayManager* display;
+    DataFetcher* fetcher;
+    uint32_t samples[BENCHMARK_MAX_SAMPLES];
+    int sample_count;
+    int ok_count;
+    uint32_t start_us;
+    
+    void begin() {
+        sample_count = 0;
+        ok_count = 0;
+    }
+    
+    void startSample() {
+        start_us = micros();
+    }
+    
+    void endSample(bool ok = true) {
+        display->waitFlush();
+        if (sample_count < BENCHMARK_MAX_SAMPLES) {
+            samples[sample_count++] = micros() - start_us;
+        }
+        if (ok) ok_count++;
+    }
+    
+    void report(const char* scenario) {
+        if (sample_count == 0) return;
+        
+        std::sort(samples, samples + sample_count);
+        uint64_t sum = 0;
+        for (int i = 0; i < sample_count; i++) sum += samples[i];
+        
+        Serial.printf("BENCH,%s,%d,%lu,%lu,%lu,%lu,%d\n", scenario, sample_count,
+                     (unsigned long)samples[0],
+                     (unsigned long)samples[sample_count / 2],
+                     (unsigned long)(sum / sample_count),
+                     (unsigned long)samples[sample_count - 1],
+                     ok_count);
+    }
+    
+    /**
+     * Whole screen re-rasterised (boot / after reconnect)
+     */
+    void benchFullRedraw() {
+        begin();
+        for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+            startSample();
+            display->drawInitialUI();
+            endSample();
+        }
+        report("full_redraw");
+    }
+    
+    /**
+     * Power changes by 1 W - only the last digit differs
+     */
+    void benchDigitChange() {
+        PowerData power(230.0f, 5.0f, 734.0f);
+        display->drawMainDisplay(power, true);
+        display->waitFlush();
+        
+        begin();
+        for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+            power.power_active = (i % 2) ? 734.0f : 735.0f;
+            startSample();
+            display->drawMainDisplay(power, false);
+            endSample();
+        }
+        report("digit_change");
+    }
+    
+    /**
+     * One second of clock: seconds segment (and sometimes minutes) change
+     */
+    void benchStatusTick() {
+        StatusData status;
+        status.internal_temp = 45.0f;
+        status.rssi = -60;
+        
+        begin();
+        for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+            status.setTime(12, (i / 60) % 60, i % 60);
+            startSample();
+            display->drawStatusBar(status, false);
+            endSample();
+        }
+        report("status_tick");
+    }
+    
+    /**
+     * 900 W .. 1100 W, crossing the W/kW format and unit switch
+     */
+    void benchKwSweep() {
+        PowerData power(230.0f, 4.0f, 900.0f);
+        display->drawMainDisplay(power, true);
+        display->waitFlush();
+        
+        begin();
+        for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+            power.power_active = 900.0f + 200.0f * i / max(BENCHMARK_ITERATIONS - 1, 1);
+            power.current = power.power_active / power.voltage;
+            startSample();
+            display->drawMainDisplay(power, false);
+            endSample();
+        }
+        report("kw_sweep");
+    }
+    
+    /**
+     * One sweep graph column per call
+     */
+    void benchGraphColumn() {
+        begin();
+        for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+            startSample();
+            display->addGraphSample(500.0f + (i * 97) % 3000);
+            endSample();
+        }
+        report("graph_column");
+    }
+    
+    /**
+     * Raw panel fill (Adafruit_ST7789::fillScreen)
+     */
+    void benchFill() {
+        Adafruit_ST7789* tft = display->beginRawDraw();
+        
+        begin();
+        for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+            startSample();
+            tft->fillScreen((i % 2) ? ST77XX_BLUE : ST77XX_BLACK);
+            endSample();
+        }
+        report("fill_screen");
+    }
+    
+    /**
+     * Raw full-screen blit, band by band from one band-sized bitmap
+     */
+    void benchBlit() {
+        Adafruit_ST7789* tft = display->beginRawDraw();
+        int w = tft->width();
+        int h = tft->height();
+        
+        uint16_t* bitmap = (uint16_t*)malloc(w * TILE_HEIGHT * sizeof(uint16_t));
+        if (!bitmap) {
+            Serial.println("BENCH,blit_screen,0,0,0,0,0,0");
+            return;
+        }
+        for (int i = 0; i < w * TILE_HEIGHT; i++) {
+            bitmap[i] = (i & 1) ? ST77XX_WHITE : ST77XX_BLACK;
+        }
+        
+        begin();
+        for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+            startSample();
+            tft->startWrite();
+            for (int y = 0; y < h; y += TILE_HEIGHT) {
+                int band_h = min(TILE_HEIGHT, h - y);
+                tft->setAddrWindow(0, y, w, band_h);
+                tft->writePixels(bitmap, (uint32_t)w * band_h);
+            }
+            tft->endWrite();
+            endSample();
+        }
+        report("blit_screen");
+        
+        free(bitmap);
+    }
+    
+    /**
+     * Sequential fetches (keep-alive applies as configured)
+     */
+    void benchFetch(const char* url) {
+        uint32_t opened = fetcher->getConnectionsOpened();
+        uint32_t reused = fetcher->getConnectionsReused();
+        PowerData data;
+        
+        begin();
+        for (int i = 0; i < BENCHMARK_FETCHES; i++) {
+            startSample();
+            bool ok = fetcher->fetchPowerData(url, data);
+            endSample(ok);
+        }
+        report("fetch");
+        
+        Serial.printf("BENCH_INFO,connections_opened,%lu\n",
+                     (unsigned long)(fetcher->getConnectionsOpened() - opened));
+        Serial.printf("BENCH_INFO,connections_reused,%lu\n",
+                     (unsigned long)(fetcher->getConnectionsReused() - reused));
+    }
+};
+
+#endif // BENCHMARK_H
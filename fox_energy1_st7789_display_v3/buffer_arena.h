@@ -0,0 +1,83 @@
+/*
+ * Static Buffer Arena
+ * One statically allocated block for the large long-lived buffers, laid
+ * out at compile time, so none of them come from the heap and a long
+ * uptime cannot fragment the heap out from under them
+ */
+
+#ifndef BUFFER_ARENA_H
+#define BUFFER_ARENA_H
+
+#include <Arduino.h>
+#include <esp_attr.h>
+#include "config.h"
+
+/**
+ * Regions of the arena, in layout order
+ */
+enum ArenaSlot {
+    ARENA_BAND,         // Band canvas pixels (TILE_BUFFER_SIZE RGB565)
+    ARENA_DMA_CHUNKS,   // Two DMA bounce buffers of DMA_CHUNK_PIXELS
+    ARENA_SLOT_COUNT
+};
+
+/**
+ * Each slot has a fixed offset; get() hands out the same region every
+ * time, so a component that is started again reuses its buffer.
+ * The arena lives in internal DRAM (.bss), which the ESP32-C3 GPSPI DMA
+ * can read, and every slot is 4-byte aligned.
+ *
+ * The history tiers and the metrics text buffer are members of static
+ * objects already and are not part of the arena.
+ */
+class BufferArena {
+public:
+    static constexpr size_t slotSize(ArenaSlot slot) {
+        return slot == ARENA_BAND ?
+                   (ENABLE_DOUBLE_BUFFER ? align(TILE_BUFFER_SIZE * sizeof(uint16_t)) : 0) :
+               slot == ARENA_DMA_CHUNKS ?
+                   (ENABLE_SPI_DMA ? align(2 * DMA_CHUNK_PIXELS * sizeof(uint16_t)) : 0) :
+               0;
+    }
+    
+    static constexpr size_t slotOffset(ArenaSlot slot) {
+        return slot == 0 ? 0 : slotOffset((ArenaSlot)(slot - 1)) + slotSize((ArenaSlot)(slot - 1));
+    }
+    
+    static constexpr size_t capacity() {
+        return slotOffset(ARENA_SLOT_COUNT);
+    }
+    
+    /**
+     * Start of a slot (nullptr if the slot is compiled out)
+     */
+    static void* get(ArenaSlot slot) {
+        if (slotSize(slot) == 0) return nullptr;
+        return pool() + slotOffset(slot);
+    }
+    
+    /**
+     * Print the layout once at boot
+     */
+    static void printLayout() {
+        static const char* const SLOT_NAMES[ARENA_SLOT_COUNT] = { "band", "dma" };
+        Serial.printf("Buffer arena: %u bytes static (", (unsigned)capacity());
+        for (int i = 0; i < ARENA_SLOT_COUNT; i++) {
+            Serial.printf("%s%s %u", i ? ", " : "", SLOT_NAMES[i], (unsigned)slotSize((ArenaSlot)i));
+        }
+        Serial.println(")");
+    }
+
+private:
+    static constexpr size_t align(size_t bytes) {
+        return (bytes + 3) & ~(size_t)3;
+    }
+    
+    static uint8_t* pool() {
+        // At least one word, so the array is valid with every slot compiled out
+        alignas(4) static uint8_t storage[capacity() ? capacity() : 4];
+        return storage;
+    }
+};
+
+#endif // BUFFER_ARENA_H
@@ -14,10 +14,28 @@
 #define TFT_CS        7  // Chip Select
 #define TFT_RST       3  // Reset
 #define TFT_DC        2  // Data/Command
+#define TFT_MOSI      6  // SPI MOSI (board default)
+#define TFT_SCLK      4  // SPI SCK (board default)
+#define TFT_BL        -1 // Backlight via a transistor for PWM dimming (-1 = tied to 3V3)
 
-// --- Display Resolution ---
-#define SCREEN_WIDTH  320
-#define SCREEN_HEIGHT 240
+// --- Display Layout ---
+#define LAYOUT_LANDSCAPE  0   // 320x240, voltage and current side by side (horizontal case)
+#define LAYOUT_PORTRAIT   1   // 240x320, rows stacked, energy totals at the bottom (pivot case)
+
+#ifndef DISPLAY_LAYOUT
+#define DISPLAY_LAYOUT    LAYOUT_LANDSCAPE
+#endif
+
+// --- Display Resolution (after rotation) ---
+#if DISPLAY_LAYOUT == LAYOUT_PORTRAIT
+#define SCREEN_WIDTH      240
+#define SCREEN_HEIGHT     320
+#define DISPLAY_ROTATION  0
+#else
+#define SCREEN_WIDTH      320
+#define SCREEN_HEIGHT     240
+#define DISPLAY_ROTATION  3
+#endif
 
 // =========================================================================
 // ===                     NETWORK CONFIGURATION                         ===
@@ -28,15 +46,105 @@
 #define GMT_OFFSET_SEC       3600      // GMT+1
 #define DAYLIGHT_OFFSET_SEC  3600      // Daylight saving time
 
+// --- Fast Reconnect ---
+#define WIFI_FAST_CONNECT            true   // Join the cached BSSID/channel directly, skipping the scan
+#define WIFI_FAST_REUSE_LEASE        false  // Also borrow the cached DHCP lease until DHCP confirms one
+#define WIFI_LEASE_DROP_FAILURES     5      // Fetch failures in a row with the link up that discard the cached lease
+#define WIFI_FAST_CONNECT_TIMEOUT_MS 1500   // Directed attempt before falling back to a full scan
+
+// --- Static IP (empty WIFI_STATIC_IP = DHCP) ---
+#define WIFI_STATIC_IP       ""              // e.g. "192.168.0.50"
+#define WIFI_STATIC_GATEWAY  "192.168.0.1"
+#define WIFI_STATIC_SUBNET   "255.255.255.0"
+#define WIFI_STATIC_DNS      ""              // Empty = gateway
+
+// =========================================================================
+// ===                      DATA TRANSPORT                               ===
+// =========================================================================
+
+#define TRANSPORT_HTTP_POLL  0   // GET DATA_URL every LOOP_DELAY_MS
+#define TRANSPORT_UDP_PUSH   1   // Listen for JSON datagrams from a relay or the meter
+
+#define DATA_TRANSPORT       TRANSPORT_HTTP_POLL
+#define UDP_LISTEN_PORT      4210      // Datagram payload: same JSON as the meter's API
+#define UDP_POLL_MS          5         // Receive poll interval (bounds added latency)
+#define UDP_STALE_TIMEOUT_MS 5000      // No datagram for this long counts as a failure
+
+// =========================================================================
+// ===                      MULTIPLE METERS                              ===
+// =========================================================================
+
+// List every meter as METER_URLS in secrets.h to poll several (HTTP only),
+// e.g. one energy1 per phase; otherwise only DATA_URL is polled
+#ifndef METER_URLS
+#define METER_URLS           { DATA_URL }
+#endif
+#define METER_MAX            3         // Cells that fit the bottom row
+#define METER_STALE_MS       5000      // No valid sample for this long grays that meter out
+#define METER_LABEL_PREFIX   "L"       // Cell labels L1, L2, ...
+#if DISPLAY_LAYOUT == LAYOUT_PORTRAIT
+#define METER_LABEL_FONT_SIZE 1        // Three 80 px cells
+#define METER_VALUE_FONT_SIZE 2
+#else
+#define METER_LABEL_FONT_SIZE 2        // Label and voltage line
+#define METER_VALUE_FONT_SIZE 3        // Per-meter power
+#endif
+
+// =========================================================================
+// ===                      LOCAL METRICS SERVER                         ===
+// =========================================================================
+
+#define ENABLE_METRICS_SERVER     true   // /api/current and /api/history for desktop clients
+#define METRICS_SERVER_PORT       80
+#define METRICS_TASK_STACK        4096
+#define METRICS_TASK_PRIORITY     1
+#define METRICS_CLIENT_TIMEOUT_MS 1000   // Drop clients that stall mid-request
+#define METRICS_SSE_MAX_CLIENTS   3      // Concurrent /api/stream connections
+#define METRICS_SSE_PING_MS       15000  // Keep-alive comment interval on idle streams
+
+// =========================================================================
+// ===                      HEALTH MONITOR                               ===
+// =========================================================================
+
+#define HEALTH_SAMPLE_MS          10000  // Heap and task stack sampling interval
+#define HEALTH_MAX_TASKS          (METER_MAX + 3)  // loop, metrics, telemetry and one fetch task per meter
+#define HEALTH_LARGEST_BLOCK_WARN 16384  // Log when the largest free heap block drops below this
+#define HEALTH_STACK_WARN_BYTES   512    // Log when a task's unused stack drops below this
+#define HEALTH_LEAK_WINDOW_SAMPLES 30    // Heap samples per leak-check window (5 minutes)
+#define HEALTH_LEAK_WINDOWS       3      // Log when the fewest allocated blocks grew this many windows in a row
+
+// =========================================================================
+// ===                      TELEMETRY UPLINK                             ===
+// =========================================================================
+
+// Diagnostics batched to a collector (set TELEMETRY_URL in secrets.h)
+#define ENABLE_TELEMETRY          false
+#ifndef TELEMETRY_URL
+#define TELEMETRY_URL             ""
+#endif
+#define TELEMETRY_SAMPLE_MS       10000  // One record per interval
+#define TELEMETRY_BATCH_RECORDS   30     // Records per POST (every 5 minutes at 10 s)
+#define TELEMETRY_RING_SIZE       180    // Records kept while the collector is unreachable (30 minutes)
+#define TELEMETRY_BACKOFF_MS      30000  // Retry delay after a failed POST, doubling...
+#define TELEMETRY_BACKOFF_MAX_MS  600000 // ...up to this
+#define TELEMETRY_TASK_STACK      4096
+#define TELEMETRY_TASK_PRIORITY   1
+
 // =========================================================================
 // ===                      TIMING CONFIGURATION                         ===
 // =========================================================================
 
 #define LOOP_DELAY_MS           1000   // API request interval (1 second)
 #define HTTP_TIMEOUT_MS         4000   // Max time to wait for HTTP response
-#define TIME_UPDATE_INTERVAL    1000   // Update time every second
 #define WIFI_CONNECT_TIMEOUT    20     // WiFi connection timeout (20 * 500ms = 10s)
 #define WIFI_RECONNECT_TIMEOUT  10     // WiFi reconnection timeout (10 * 500ms = 5s)
+#define UI_FRAME_INTERVAL_MS    50     // UI loop cadence (clock check + render)
+#define DATA_STALE_MS           15000  // No valid sample for this long: readings grayed, age shown (keep above POLL_IDLE_MS)
+
+// --- Fetch Task ---
+#define FETCH_TASK_STACK        6144   // Stack size in bytes (HTTP + JSON)
+#define FETCH_TASK_PRIORITY     1      // Same as the Arduino loop task
+#define SAMPLE_QUEUE_SIZE       4      // Samples buffered between fetch task and UI
 
 // =========================================================================
 // ===                    UI APPEARANCE CONSTANTS                        ===
@@ -48,10 +156,15 @@
 #define STATUS_BAR_FONT_SIZE  2
 
 // --- Font Sizes ---
+#if DISPLAY_LAYOUT == LAYOUT_PORTRAIT
+#define POWER_VALUE_FONT_SIZE 8        // "12.3kW" across 240 px
+#else
 #define POWER_VALUE_FONT_SIZE 11       // Large power value
+#endif
 #define POWER_UNIT_FONT_SIZE  3        // "W" or "kW" unit
 #define VA_FONT_SIZE          5        // Voltage and Current display
 #define TIME_FONT_SIZE        2        // Time display
+#define DATA_AGE_FONT_SIZE    1        // Sample age under the WiFi icon
 
 // --- Icon Dimensions & Paddings ---
 #define WIFI_ICON_WIDTH       24
@@ -66,6 +179,15 @@
 #define TIME_SEPARATOR_WIDTH   8       // Width for ":" separator
 #define TIME_TOTAL_WIDTH       (3*TIME_SEGMENT_WIDTH + 2*TIME_SEPARATOR_WIDTH)
 
+// --- Energy Display (between time and temperature) ---
+#define ENERGY_FONT_SIZE      1
+#define ENERGY_AREA_GAP       10       // Gap to the time and temperature widgets
+
+// --- Power Graph (sweep sparkline below the status bar) ---
+#define ENABLE_POWER_GRAPH    true
+#define GRAPH_MAX_POWER       4000.0f  // Fixed full-scale value in W
+#define GRAPH_GAP_COLUMNS     4        // Blank columns ahead of the sweep cursor
+
 // =========================================================================
 // ===                         COLOR DEFINITIONS                         ===
 // =========================================================================
@@ -88,6 +210,12 @@
 #define CURRENT_COLOR         ST77XX_MAGENTA
 #define WIFI_ICON_COLOR       ST77XX_WHITE
 #define TIME_COLOR            ST77XX_WHITE
+#define GRAPH_CURSOR_COLOR    ST77XX_DARKGREY
+#define ENERGY_LABEL_COLOR    ST77XX_DARKGREY
+#define ENERGY_VALUE_COLOR    ST77XX_WHITE
+#define METER_LABEL_COLOR     ST77XX_WHITE   // "L1".. in the meter cells
+#define STALE_VALUE_COLOR     0x8410         // Last known readings while WiFi is down
+#define DATA_AGE_COLOR        ST77XX_ORANGE  // "45s" under the WiFi icon once DATA_STALE_MS passed
 
 // --- Temperature Colors (Thresholds) ---
 #define TEMP_COLOR_GREEN      ST77XX_GREEN   // < 60 C
@@ -100,21 +228,110 @@
 // =========================================================================
 
 // --- Tile-Based Buffering ---
-#define ENABLE_DOUBLE_BUFFER  true     // Enabled - canvas approach fixed
+#define ENABLE_DOUBLE_BUFFER  true     // Enabled - band renderer, falls back to direct drawing
 #define TILE_HEIGHT           30       // Height of each tile in pixels
-#define NUM_TILES             (SCREEN_HEIGHT / TILE_HEIGHT)  // 8 tiles for 240px height
-#define TILE_BUFFER_SIZE      (SCREEN_WIDTH * TILE_HEIGHT)   // 9600 pixels = 19.2KB
+#define NUM_TILES             ((SCREEN_HEIGHT + TILE_HEIGHT - 1) / TILE_HEIGHT)  // 8 tiles for 240px height
+#define TILE_BUFFER_SIZE      (SCREEN_WIDTH * TILE_HEIGHT)   // 9600 pixels = 19.2KB (landscape)
+
+// --- Dirty Region Tracking ---
+#define MAX_DIRTY_REGIONS     8        // Rectangles tracked per canvas before merging
+
+// --- SPI DMA Flush ---
+#define ENABLE_SPI_DMA        true     // Flush canvases with GPSPI DMA (falls back to blocking writes)
+#define TFT_SPI_FREQ_HZ       40000000 // 40 MHz; 80 MHz brings a full frame under 20 ms if the panel allows
+#define DMA_CHUNK_PIXELS      2048     // Pixels per bounce buffer (2 buffers = 8KB)
+#define DMA_QUEUE_SIZE        8        // Max queued SPI transactions
+
+// =========================================================================
+// ===                    POWER MANAGEMENT                               ===
+// =========================================================================
+
+// --- Sleep (battery-powered units) ---
+#define ENABLE_POWER_SAVE         false // Modem sleep, lower CPU clock, light sleep between frames
+#define POWER_CPU_FREQ_MHZ        80    // CPU clock while power saving (WiFi needs >= 80)
+#define POWER_LIGHT_SLEEP         true  // esp_light_sleep_start() until the next fetch or clock tick
+#define POWER_LIGHT_SLEEP_MIN_MS  20    // Shorter gaps are waited out awake
+
+// --- Backlight Dimming (needs TFT_BL) ---
+#define BACKLIGHT_PWM_FREQ        5000  // Hz
+#define BACKLIGHT_PWM_BITS        8
+#define BACKLIGHT_LEVEL_ACTIVE    255
+#define BACKLIGHT_LEVEL_IDLE      64    // After BACKLIGHT_IDLE_MS of flat readings
+#define BACKLIGHT_LEVEL_NIGHT     16    // Between the night hours (NTP time)
+#define BACKLIGHT_IDLE_MS         120000
+#define BACKLIGHT_ACTIVITY_W      100.0 // A power step this large counts as activity
+#define BACKLIGHT_NIGHT_START     22    // Hour of day, local time
+#define BACKLIGHT_NIGHT_END       7
+
+// --- Current Estimate (typical figures, mA) ---
+#define POWER_EST_AWAKE_MA        80.0  // CPU awake, radio listening
+#define POWER_EST_MODEM_SLEEP_MA  22.0  // CPU awake, radio asleep between DTIM beacons
+#define POWER_EST_LIGHT_SLEEP_MA  1.0   // Chip in light sleep
+#define POWER_EST_PANEL_MA        4.0   // ST7789 controller
+#define POWER_EST_BACKLIGHT_MA    20.0  // Backlight at full brightness
 
 // =========================================================================
 // ===                    PERFORMANCE TUNING                             ===
 // =========================================================================
 
-// --- Update Thresholds (avoid unnecessary redraws) ---
-#define POWER_CHANGE_THRESHOLD    0.5   // Redraw power if change > 0.5W
-#define CURRENT_CHANGE_THRESHOLD  0.05  // Redraw current if change > 0.05A
+// --- Glyph Cache ---
+#define ENABLE_GLYPH_CACHE        true  // Blit pre-rasterised glyph spans instead of per-pixel font scaling
+
+// --- HTTP ---
+#define HTTP_KEEP_ALIVE           true  // Reuse one TCP connection to the meter across polls
+#define ENABLE_STREAMING_PARSER   true  // Scan the body straight off the socket (no String, no JsonDocument)
+
+// --- Profiler (development builds) ---
+#define ENABLE_PROFILER           false // Cycle-counter timings printed over serial; no code when false
+#define PROFILER_REPORT_MS        5000  // Aggregation window
+#define PROFILER_OVERLAY          true  // Show render avg/p99 in the graph strip
+#define PROFILER_OVERLAY_COLOR    ST77XX_WHITE
+
+// --- Benchmark Mode (development builds) ---
+#define ENABLE_BENCHMARK          false // Run render/fetch scenarios at boot, results as "BENCH," CSV
+#define BENCHMARK_ITERATIONS      50    // Samples per render scenario
+#define BENCHMARK_FETCHES         20    // Sequential fetches
+#define BENCHMARK_URL             DATA_URL  // Point at a canned endpoint for repeatable fetch numbers
+
+// --- Change Threshold (adaptive polling) ---
+#define POWER_CHANGE_THRESHOLD    0.5   // Smallest power change in W that counts as movement
+
+// --- Display Smoothing (dashboard only; energy, history and /metrics stay raw) ---
+// Widgets redraw only when their formatted text changes; the filter keeps
+// meter jitter from changing it every poll
+#define FILTER_NONE               0
+#define FILTER_EMA                1     // Exponential moving average
+#define FILTER_MEDIAN             2     // Median of the last FILTER_MEDIAN_SIZE samples, then the EMA
+#define DISPLAY_FILTER            FILTER_EMA
+#define FILTER_EMA_ALPHA          0.3   // Weight of the newest sample (1.0 = no smoothing)
+#define FILTER_MEDIAN_SIZE        5     // Odd, at most 7
+#define FILTER_STEP_W             (POWER_CHANGE_THRESHOLD * POLL_TRANSIENT_FACTOR)  // Larger power steps skip the filter
+#define POWER_HYSTERESIS_W        1.5   // Shown value holds until the filtered one is this far past the rounding edge
+#define POWER_HYSTERESIS_KW       0.01  // Same for the 0.1 kW steps above 1 kW
+#define VOLTAGE_HYSTERESIS_V      0.3
+#define CURRENT_HYSTERESIS_A      0.03
+
+// --- Adaptive Polling (HTTP transport) ---
+#define ENABLE_ADAPTIVE_POLLING   true
+#define POLL_FAST_MS              250   // Interval while power is changing
+#define POLL_IDLE_MS              10000 // Longest interval when readings are flat
+#define POLL_TRANSIENT_FACTOR     20    // Transient = delta > POWER_CHANGE_THRESHOLD * factor
+#define POLL_STEADY_SAMPLES       8     // Steady samples before doubling the interval
+#define POLL_FAILURE_MAX_MS       30000 // Backoff cap against an unreachable meter
+
+// --- Energy Accumulator ---
+#define ENERGY_MAX_GAP_MS              60000    // Longer sample gaps are not integrated
+#define ENERGY_CHECKPOINT_INTERVAL_MS  600000   // Write totals to NVS at most every 10 min...
+#define ENERGY_CHECKPOINT_MIN_WH       1.0      // ...if at least this much was added
+#define ENERGY_CHECKPOINT_DELTA_WH     50.0     // Write early after a large delta
+
+// --- Fast Boot ---
+#define ENABLE_FAST_BOOT               true     // With a cached reading: no startup animation, dashboard at once
+#define READING_CHECKPOINT_MS          600000   // Write the last reading to NVS at most every 10 min
 
 // --- WiFi Reconnection ---
-#define WIFI_RECONNECT_MAX_ATTEMPTS  3     // Max reconnection attempts before showing error
+#define WIFI_RECONNECT_MAX_ATTEMPTS  3     // Failed attempts before the state reads WIFI_FAILED (retries go on)
 #define WIFI_RECONNECT_BACKOFF_MS    1000  // Initial backoff delay (exponential)
+#define WIFI_RECONNECT_BACKOFF_MAX_MS 16000 // Slowest retry rate
 
 #endif // CONFIG_H
@@ -6,37 +6,103 @@
 #ifndef DATA_FETCHER_H
 #define DATA_FETCHER_H
 
+#include <WiFi.h>
 #include <HTTPClient.h>
+#include <WiFiUdp.h>
 #include <ArduinoJson.h>
 #include "config.h"
 #include "types.h"
+#include "power_json_scanner.h"
+#include "firmware_stats.h"
+#include "profiler.h"
+
+#define PUSH_PACKET_MAX  512   // Larger datagrams are rejected
+
+/**
+ * Outcome of a push-mode receive poll
+ */
+enum PushResult {
+    PUSH_NONE,      // Nothing received yet
+    PUSH_SAMPLE,    // Valid sample received
+    PUSH_INVALID,   // Datagram received but unusable
+    PUSH_TIMEOUT    // Nothing received for UDP_STALE_TIMEOUT_MS
+};
+
+/**
+ * Write-only stream feeding a PowerJsonScanner
+ * HTTPClient::writeToStream() decodes chunked bodies into it, so no
+ * response is ever copied into a String
+ */
+class ScannerSink : public Stream {
+public:
+    explicit ScannerSink(PowerJsonScanner& target) : scanner(target) {}
+    
+    size_t write(uint8_t c) override {
+        scanner.feed((char)c);
+        return 1;
+    }
+    
+    size_t write(const uint8_t* data, size_t size) override {
+        scanner.feed((const char*)data, size);
+        return size;
+    }
+    
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+
+private:
+    PowerJsonScanner& scanner;
+};
 
 class DataFetcher {
 public:
     DataFetcher() : 
         last_fetch_time(0),
         last_fetch_successful(false),
-        consecutive_failures(0) {}
+        consecutive_failures(0),
+        connections_opened(0),
+        connections_reused(0),
+        push_listening(false),
+        last_push_time(0),
+        stats(nullptr) {}
+    
+    /**
+     * Record connect/TTFB/parse latencies (may be nullptr)
+     */
+    void setStats(FirmwareStats* firmware_stats) {
+        stats = firmware_stats;
+    }
     
     /**
      * Fetch power data from the API
      * Returns true if data was successfully fetched and parsed
      */
     bool fetchPowerData(const char* url, PowerData& data) {
+        PROFILE_SCOPE(PROF_FETCH);
         Serial.print("Fetching data from: ");
         Serial.println(url);
         
-        // Begin HTTP connection
-        http.begin(url);
-        http.setTimeout(HTTP_TIMEOUT_MS);
+        timing.request_us = micros();   // A keep-alive retry below counts towards this request
+        bool reused = false;
+        int httpCode = sendRequest(url, reused);
         
-        int httpCode = http.GET();
+        // The meter may have closed an idle keep-alive socket; retry once fresh
+        if (reused && isConnectionLost(httpCode)) {
+            Serial.println("Keep-alive connection dropped, reconnecting");
+            http.end();
+            client.stop();
+            httpCode = sendRequest(url, reused);
+        }
         
         if (httpCode == HTTP_CODE_OK) {
-            String payload = http.getString();
-            http.end(); // Release resources early
+            uint32_t parse_start = micros();
+            bool parsed = readBody(data);
+            timing.parsed_us = micros();
+            http.end(); // Keeps the socket open for reuse when the server allows it
+            recordPhase(FETCH_PARSE, parse_start);
             
-            if (parseJSON(payload, data)) {
+            if (parsed) {
                 last_fetch_time = millis();
                 last_fetch_successful = true;
                 consecutive_failures = 0;
@@ -53,6 +119,7 @@ public:
         } else if (httpCode > 0) {
             // HTTP error
             http.end();
+            client.stop();
             last_fetch_successful = false;
             consecutive_failures++;
             Serial.printf("HTTP Error: %d - %s\n", 
@@ -61,6 +128,7 @@ public:
         } else {
             // Connection error
             http.end();
+            client.stop();
             last_fetch_successful = false;
             consecutive_failures++;
             Serial.printf("HTTP Connection Failed: %s\n", 
@@ -69,6 +137,77 @@ public:
         }
     }
     
+    /**
+     * Start listening for pushed samples (push transport)
+     * Call again after a WiFi reconnect
+     */
+    bool beginPush(uint16_t port) {
+        udp.stop();
+        push_listening = udp.begin(port);
+        last_push_time = millis();
+        
+        if (push_listening) {
+            Serial.printf("Listening for pushed samples on UDP %u\n", port);
+        } else {
+            Serial.printf("UDP listen on port %u failed\n", port);
+        }
+        return push_listening;
+    }
+    
+    /**
+     * Poll for one pushed sample (non-blocking)
+     */
+    PushResult receivePush(PowerData& data) {
+        if (!push_listening) return PUSH_NONE;
+        
+        int size = udp.parsePacket();
+        if (size <= 0) {
+            if (millis() - last_push_time < UDP_STALE_TIMEOUT_MS) return PUSH_NONE;
+            
+            // Report once per timeout window
+            last_push_time = millis();
+            last_fetch_successful = false;
+            consecutive_failures++;
+            Serial.println("No pushed sample received");
+            return PUSH_TIMEOUT;
+        }
+        
+        last_push_time = millis();
+        timing.request_us = timing.first_byte_us = micros();
+        
+        if (size > PUSH_PACKET_MAX) {
+            // Dropped unread; the next parsePacket() discards it
+            last_fetch_successful = false;
+            consecutive_failures++;
+            Serial.printf("Pushed datagram too large (%d bytes)\n", size);
+            return PUSH_INVALID;
+        }
+        
+        PowerJsonScanner scanner;
+        char buffer[64];
+        int n;
+        while (!scanner.isComplete() && (n = udp.read(buffer, sizeof(buffer))) > 0) {
+            scanner.feed(buffer, n);
+        }
+        
+        if (scanner.isComplete()) {
+            scanner.getData(data);
+            if (validate(data)) {
+                timing.parsed_us = micros();
+                last_fetch_time = last_push_time;
+                last_fetch_successful = true;
+                consecutive_failures = 0;
+                return PUSH_SAMPLE;
+            }
+        } else {
+            Serial.printf("Pushed datagram missing fields (found mask 0x%x)\n", scanner.getFound());
+        }
+        
+        last_fetch_successful = false;
+        consecutive_failures++;
+        return PUSH_INVALID;
+    }
+    
     /**
      * Check if last fetch was successful
      */
@@ -83,6 +222,13 @@ public:
         return last_fetch_time;
     }
     
+    /**
+     * Pipeline stamps of the last successful fetch or push
+     */
+    const SampleTiming& getLastTiming() {
+        return timing;
+    }
+    
     /**
      * Get number of consecutive failures
      */
@@ -96,12 +242,177 @@ public:
     void resetFailures() {
         consecutive_failures = 0;
     }
+    
+    /**
+     * Number of requests that needed a new TCP connection
+     */
+    uint32_t getConnectionsOpened() {
+        return connections_opened;
+    }
+    
+    /**
+     * Number of requests sent over an already open keep-alive connection
+     */
+    uint32_t getConnectionsReused() {
+        return connections_reused;
+    }
 
 private:
+#ifdef HOST_BUILD
+    friend class HostBench;   // host/bench.cpp times the private helpers
+#endif
     HTTPClient http;
+    WiFiClient client;   // Outlives each request so the socket can be reused
     unsigned long last_fetch_time;
     bool last_fetch_successful;
     int consecutive_failures;
+    uint32_t connections_opened;
+    uint32_t connections_reused;
+    WiFiUDP udp;
+    bool push_listening;
+    unsigned long last_push_time;
+    SampleTiming timing;
+    FirmwareStats* stats;
+    
+    void recordPhase(FetchPhase phase, uint32_t start_us) {
+        if (stats) stats->fetch[phase].record(micros() - start_us);
+    }
+    
+    /**
+     * Issue the GET over the persistent client
+     * Sets reused to whether an open connection was picked up. A new
+     * connection is opened here rather than inside HTTPClient so connect
+     * time and time to first byte can be measured separately.
+     * HTTPClient still parses the URL and builds the request header as
+     * Strings on every call; they are freed before the next poll.
+     */
+    int sendRequest(const char* url, bool& reused) {
+        reused = HTTP_KEEP_ALIVE && client.connected();
+        if (reused) {
+            connections_reused++;
+        } else {
+            connections_opened++;
+            Serial.printf("Opening HTTP connection (%lu opened, %lu reused)\n",
+                         (unsigned long)connections_opened,
+                         (unsigned long)connections_reused);
+            
+            if (!connectClient(url)) {
+                return HTTPC_ERROR_CONNECTION_REFUSED;
+            }
+        }
+        
+        http.begin(client, url); // Picks up the connected client
+        http.setReuse(HTTP_KEEP_ALIVE);
+        http.setTimeout(HTTP_TIMEOUT_MS);
+        
+        uint32_t request_start = micros();
+        int httpCode = http.GET();
+        if (httpCode > 0) {
+            timing.first_byte_us = micros();
+            recordPhase(FETCH_TTFB, request_start);
+        }
+        return httpCode;
+    }
+    
+    /**
+     * Open the TCP connection for an http:// URL
+     */
+    bool connectClient(const char* url) {
+        char host[64];
+        uint16_t port = 80;
+        
+        const char* p = strstr(url, "://");
+        p = p ? p + 3 : url;
+        size_t len = strcspn(p, ":/");
+        if (len == 0 || len >= sizeof(host)) return false;
+        memcpy(host, p, len);
+        host[len] = '\0';
+        if (p[len] == ':') {
+            port = atoi(p + len + 1);
+        }
+        
+        uint32_t connect_start = micros();
+        if (!client.connect(host, port, HTTP_TIMEOUT_MS)) {
+            return false;
+        }
+        recordPhase(FETCH_CONNECT, connect_start);
+        return true;
+    }
+    
+    /**
+     * Errors caused by a socket the server already closed
+     */
+    static bool isConnectionLost(int httpCode) {
+        return httpCode == HTTPC_ERROR_CONNECTION_LOST ||
+               httpCode == HTTPC_ERROR_SEND_HEADER_FAILED ||
+               httpCode == HTTPC_ERROR_NOT_CONNECTED;
+    }
+    
+    /**
+     * Read the response body and extract power data
+     * Streams through the key scanner when the length is known; chunked or
+     * close-delimited bodies are decoded by HTTPClient into the scanner
+     */
+    bool readBody(PowerData& data) {
+        PROFILE_SCOPE(PROF_PARSE);
+        int remaining = http.getSize();
+        
+        if (!ENABLE_STREAMING_PARSER) {
+            String payload = http.getString();
+            return parseJSON(payload, data);
+        }
+        
+        PowerJsonScanner scanner;
+        if (remaining < 0) {
+            ScannerSink sink(scanner);
+            if (http.writeToStream(&sink) < 0) {
+                Serial.println("Response body read failed");
+                client.stop();
+                return false;
+            }
+            return finishScan(scanner, data);
+        }
+        
+        WiFiClient* stream = http.getStreamPtr();
+        char buffer[64];
+        
+        while (remaining > 0 && !scanner.isComplete()) {
+            int n = stream->readBytes(buffer, min(remaining, (int)sizeof(buffer)));
+            if (n <= 0) {
+                Serial.println("Response body timed out");
+                client.stop();
+                return false;
+            }
+            remaining -= n;
+            scanner.feed(buffer, n);
+        }
+        
+        // Skip the rest of the body so the next response starts clean;
+        // if it has not arrived yet, drop the connection instead of waiting
+        while (remaining > 0 && stream->available() > 0) {
+            int n = stream->read((uint8_t*)buffer, min(remaining, (int)sizeof(buffer)));
+            if (n <= 0) break;
+            remaining -= n;
+        }
+        if (remaining > 0) {
+            client.stop();
+        }
+        
+        return finishScan(scanner, data);
+    }
+    
+    /**
+     * Take the reading out of a fed scanner and validate it
+     */
+    bool finishScan(PowerJsonScanner& scanner, PowerData& data) {
+        if (!scanner.isComplete()) {
+            Serial.printf("JSON missing required fields (found mask 0x%x)\n", scanner.getFound());
+            return false;
+        }
+        
+        scanner.getData(data);
+        return validate(data);
+    }
     
     /**
      * Parse JSON payload and extract power data
@@ -131,7 +442,13 @@ private:
         data.current = doc["current"].as<float>();
         data.power_active = doc["power_active"].as<float>();
         
-        // Validate data ranges (sanity checks)
+        return validate(data);
+    }
+    
+    /**
+     * Validate data ranges (sanity checks)
+     */
+    static bool validate(const PowerData& data) {
         if (data.voltage < 0 || data.voltage > 500) {
             Serial.println("Invalid voltage value");
             return false;
@@ -1,6 +1,8 @@
 /*
- * Display Manager with Tile-Based Double Buffering
- * Handles all display rendering with flicker-free updates
+ * Display Manager
+ * The dashboard scene: widget content, change detection and drawing,
+ * placed by the compile-time Layout (DISPLAY_LAYOUT)
+ * Rasterising, dirty tracking and flushing are left to BandRenderer.
  */
 
 #ifndef DISPLAY_MANAGER_H
@@ -8,110 +10,93 @@
 
 #include <Adafruit_GFX.h>
 #include <Adafruit_ST7789.h>
-#include <SPI.h>
 #include <time.h>
 #include <sys/time.h>
 #include "config.h"
 #include "types.h"
+#include "band_renderer.h"
+#include "layout.h"
+#include "firmware_stats.h"
+#include "profiler.h"
 
-class DisplayManager {
+/**
+ * Widgets making up the scene (drawn in this order)
+ */
+enum WidgetId {
+    WIDGET_WIFI,
+    WIDGET_TEMP,
+    WIDGET_TIME,
+    WIDGET_ENERGY,
+    WIDGET_DATA_AGE,    // Shown once the newest sample is DATA_STALE_MS old
+    WIDGET_STATUS_LINE,
+    WIDGET_POWER,
+    WIDGET_VOLTAGE,
+    WIDGET_CURRENT,
+    WIDGET_METERS,      // Several meters: replaces voltage and current
+    WIDGET_GRAPH,
+    WIDGET_PROFILER,    // Development overlay, drawn over the graph
+    WIDGET_COUNT
+};
+
+static_assert(WIDGET_COUNT <= SCENE_MAX_WIDGETS, "scene widget slots");
+
+#if ENABLE_PROFILER
+static const char* const WIDGET_NAMES[WIDGET_COUNT] = {
+    "w_wifi", "w_temp", "w_time", "w_energy", "w_age", "w_line",
+    "w_power", "w_voltage", "w_current", "w_meters", "w_graph", "w_profiler"
+};
+#endif
+
+class DisplayManager : public RenderScene {
 public:
-    DisplayManager() : 
-        tft(nullptr),
-        status_canvas(nullptr),
-        main_canvas(nullptr),
-        buffer_mode(DIRECT),
-        screen_width(0),
-        wifi_icon_x(0),
-        wifi_icon_y(0),
-        temp_text_right_x(0),
-        time_text_left_x(0),
-        prev_rssi_level(-1) {
+    DisplayManager() :
+        prev_rssi_level(-1),
+        stale(false),
+        meter_count(1),
+        graph_cursor(0) {
         
         // Initialize previous values
         prev_power.voltage = -1.0f;
         prev_power.current = -1.0f;
         prev_power.power_active = -1.0f;
         prev_power_color = BG_COLOR;
+        power_value_str[0] = '\0';
+        power_unit_str[0] = '\0';
+        voltage_str[0] = '\0';
+        current_str[0] = '\0';
+        power_unit_x = power_unit_y = 0;
         
         prev_status.internal_temp = -100.0f;
         prev_status.rssi = -100;
-        prev_status.hours = "";
-        prev_status.minutes = "";
-        prev_status.seconds = "";
-    }
-    
-    ~DisplayManager() {
-        if (status_canvas) delete status_canvas;
-        if (main_canvas) delete main_canvas;
+        energy_today_str[0] = '\0';
+        energy_month_str[0] = '\0';
+        data_age_str[0] = '\0';
+        profiler_str[0] = '\0';
+        
+        memset(graph_cols, 0, sizeof(graph_cols));
+        memset(graph_colors, 0, sizeof(graph_colors));
     }
     
     /**
      * Initialize display and allocate buffers
      */
     void begin() {
-        // Initialize TFT display
-        tft = new Adafruit_ST7789(TFT_CS, TFT_DC, TFT_RST);
-        // Initialize with physical dimensions (240, 320) before rotation
-        tft->init(240, 320);
-        tft->setRotation(3); // Landscape: 320x240
-        screen_width = tft->width();
-        
-        // Calculate runtime UI positions
-        wifi_icon_y = (STATUS_BAR_HEIGHT - WIFI_ICON_HEIGHT) / 2;
-        wifi_icon_x = screen_width - WIFI_ICON_WIDTH - WIFI_RIGHT_PADDING;
-        temp_text_right_x = wifi_icon_x - TEMP_WIFI_GAP;
-        time_text_left_x = 5;
-        
-        Serial.printf("Display initialized: %dx%d\n", screen_width, tft->height());
-        
-        // Attempt to allocate canvas for double buffering
-        if (ENABLE_DOUBLE_BUFFER) {
-            delay(20); // Allow memory to stabilize
-            
-            // Allocate status bar canvas (320x40 = 25.6KB)
-            Serial.print("Allocating status canvas (320x40)... ");
-            status_canvas = new GFXcanvas16(320, STATUS_BAR_HEIGHT);
-            
-            if (!status_canvas || !status_canvas->getBuffer()) {
-                Serial.println("FAILED!");
-                if (status_canvas) { delete status_canvas; status_canvas = nullptr; }
-            } else {
-                Serial.printf("OK (%d KB free)\n", ESP.getFreeHeap() / 1024);
-            }
-            
-            delay(20); // Allow memory to stabilize
-            
-            // Allocate main display canvas (320x180 = 115.2KB)
-            int main_height = tft->height() - STATUS_BAR_HEIGHT - 1 - STATUS_BAR_V_PADDING;
-            Serial.printf("Allocating main canvas (320x%d)... ", main_height);
-            main_canvas = new GFXcanvas16(320, main_height);
-            
-            if (!main_canvas || !main_canvas->getBuffer()) {
-                Serial.println("FAILED!");
-                if (main_canvas) { delete main_canvas; main_canvas = nullptr; }
-            } else {
-                Serial.printf("OK (%d KB free)\n", ESP.getFreeHeap() / 1024);
-            }
-            
-            // Check if we have at least one canvas
-            if (status_canvas || main_canvas) {
-                buffer_mode = TILE;  // Reusing TILE mode for canvas buffering
-                Serial.println("Canvas buffering enabled - flicker-free mode!");
-            } else {
-                buffer_mode = DIRECT;
-                Serial.println("WARNING: Canvas allocation failed, using direct rendering");
-            }
-        } else {
-            buffer_mode = DIRECT;
-            Serial.println("Double buffering disabled, using direct rendering");
+        renderer.begin(this);
+        setupWidgets();
+        
+#if ENABLE_PROFILER
+        for (int id = 0; id < WIDGET_COUNT; id++) {
+            PROFILE_NAME(PROF_WIDGET_BASE + id, WIDGET_NAMES[id]);
         }
+#endif
     }
     
     /**
      * Draw fullscreen message (for startup/errors)
      */
     void drawFullScreenMessage(const String& text, int textSize, uint16_t color) {
+        Adafruit_ST7789* tft = renderer.panel();
+        renderer.beginDirectDraw();
         tft->fillScreen(BG_COLOR);
         tft->setTextWrap(true);
         tft->setTextSize(textSize);
@@ -143,13 +128,13 @@ public:
      * Draw a single frame of the startup animation to the display using strip buffering
      * This renders the entire screen flicker-free by building each strip in a canvas
      */
-    void drawStartupFrame(GFXcanvas16* strip, int strip_h, uint16_t bgColor, 
+    void drawStartupFrame(GFXcanvas16* strip, int strip_h, uint16_t bgColor,
                           uint16_t textColor, bool showText,
                           const char* title, const char* subtitle,
                           int title_x, int title_y, int sub_x, int sub_y) {
         
-        int screen_h = tft->height();
-        int screen_w = tft->width();
+        int screen_h = renderer.height();
+        int screen_w = renderer.width();
         
         // Render screen in horizontal strips
         for (int strip_y = 0; strip_y < screen_h; strip_y += strip_h) {
@@ -179,7 +164,7 @@ public:
             }
             
             // Flush strip to display
-            tft->drawRGBBitmap(0, strip_y, strip->getBuffer(), screen_w, current_strip_h);
+            renderer.flushBandRect(strip_y, 0, strip_y, screen_w, current_strip_h);
         }
     }
     
@@ -190,6 +175,7 @@ public:
     void drawStartupAnimation() {
         const char* title = "ESP32-C3";
         const char* subtitle = "Energy Monitor";
+        Adafruit_ST7789* tft = renderer.panel();
         
         int16_t x1, y1;
         uint16_t tw, th, sw, sh;
@@ -205,13 +191,13 @@ public:
         int sub_x = (tft->width() - sw) / 2;
         int sub_y = title_y + th + 15;
         
-        // Allocate strip buffer (320x60 = 38.4KB - fits in ESP32-C3 RAM)
-        const int STRIP_HEIGHT = 60;
-        GFXcanvas16* strip = new GFXcanvas16(320, STRIP_HEIGHT);
+        // Reuse the band buffer as animation strip
+        GFXcanvas16* strip = renderer.canvas();
         
-        if (!strip || !strip->getBuffer()) {
-            // Fallback to non-buffered if allocation fails
-            Serial.println("Strip buffer allocation failed, using direct rendering");
+        if (!strip) {
+            // Fallback to non-buffered if no band is available
+            Serial.println("No band buffer, using direct rendering");
+            renderer.beginDirectDraw();
             tft->fillScreen(ST77XX_BLACK);
             delay(500);
             tft->fillScreen(ST77XX_WHITE);
@@ -224,27 +210,26 @@ public:
             tft->print(subtitle);
             delay(1500);
             tft->fillScreen(ST77XX_BLACK);
-            if (strip) delete strip;
             return;
         }
         
         Serial.println("Using buffered startup animation");
         
         // Step 1: Start with black screen
-        drawStartupFrame(strip, STRIP_HEIGHT, ST77XX_BLACK, ST77XX_BLACK, false,
+        drawStartupFrame(strip, TILE_HEIGHT, ST77XX_BLACK, ST77XX_BLACK, false,
                          title, subtitle, title_x, title_y, sub_x, sub_y);
         delay(300);
         
         // Step 2: Fade in white background (black -> white)
         for (int i = 0; i <= 255; i += 20) {
             uint16_t color = grayToRGB565(i);
-            drawStartupFrame(strip, STRIP_HEIGHT, color, color, false,
+            drawStartupFrame(strip, TILE_HEIGHT, color, color, false,
                              title, subtitle, title_x, title_y, sub_x, sub_y);
             delay(25);
         }
         
         // Step 3: Show text (instant appear on white background)
-        drawStartupFrame(strip, STRIP_HEIGHT, ST77XX_WHITE, ST77XX_BLACK, true,
+        drawStartupFrame(strip, TILE_HEIGHT, ST77XX_WHITE, ST77XX_BLACK, true,
                          title, subtitle, title_x, title_y, sub_x, sub_y);
         delay(1500);
         
@@ -255,18 +240,16 @@ public:
             int textGray = max(0, i - 80);
             uint16_t textColor = grayToRGB565(textGray);
             
-            drawStartupFrame(strip, STRIP_HEIGHT, bgColor, textColor, showText,
+            drawStartupFrame(strip, TILE_HEIGHT, bgColor, textColor, showText,
                              title, subtitle, title_x, title_y, sub_x, sub_y);
             delay(30);
         }
         
         // Final black screen
-        drawStartupFrame(strip, STRIP_HEIGHT, ST77XX_BLACK, ST77XX_BLACK, false,
+        drawStartupFrame(strip, TILE_HEIGHT, ST77XX_BLACK, ST77XX_BLACK, false,
                          title, subtitle, title_x, title_y, sub_x, sub_y);
         delay(100);
         
-        // Free the strip buffer
-        delete strip;
         Serial.println("Startup animation complete");
     }
     
@@ -274,28 +257,24 @@ public:
      * Draw initial UI structure
      */
     void drawInitialUI() {
-        tft->fillScreen(BG_COLOR);
-        tft->drawFastHLine(0, STATUS_BAR_HEIGHT, screen_width, STATUS_BAR_LINE_COLOR);
-        
         // Force draw all elements
         StatusData init_status;
         init_status.internal_temp = temperatureRead();
         init_status.rssi = -100;
-        init_status.hours = "--";
-        init_status.minutes = "--";
-        init_status.seconds = "--";
-        init_status.time_str = "--:--:--";
-        
-        PowerData init_power(0.0f, 0.0f, 0.0f);
+        init_status.clearTime();
         
-        drawStatusBar(init_status, true);
-        drawMainDisplay(init_power, true);
-        
-        // Store initial values as previous
-        prev_status = init_status;
-        prev_power = init_power;
-        prev_power_color = POWER_COLOR_NORMAL;
-        prev_rssi_level = getRSSILevel(init_status.rssi);
+        drawInitialUI(init_status, PowerData(0.0f, 0.0f, 0.0f));
+    }
+    
+    /**
+     * Draw the whole scene with known content (fast boot: restored
+     * energy totals, the RTC clock and the cached reading in one frame)
+     */
+    void drawInitialUI(const StatusData& status, const PowerData& power) {
+        // Whole screen is re-rasterised, including background and status line
+        renderer.markDirty(0, 0, renderer.width(), renderer.height());
+        drawStatusBar(status, true);
+        drawMainDisplay(power, true);
     }
     
     /**
@@ -305,132 +284,306 @@ public:
         int current_level = getRSSILevel(status.rssi);
         long rounded_temp = round(status.internal_temp);
         
-        bool time_changed = (status.hours != prev_status.hours || 
-                           status.minutes != prev_status.minutes || 
-                           status.seconds != prev_status.seconds);
+        bool time_changed = (status.hour != prev_status.hour ||
+                             status.minute != prev_status.minute ||
+                             status.second != prev_status.second);
         bool rssi_changed = (current_level != prev_rssi_level);
         bool temp_changed = (rounded_temp != round(prev_status.internal_temp));
-        
-        // Get drawing target(canvas if available, else TFT directly)
-        Adafruit_GFX* target = getDrawTarget(status_canvas);
-        bool using_canvas = (target == (Adafruit_GFX*)status_canvas);
-        
-        // If using canvas, we MUST redraw everything because we clear the canvas
-        bool effective_force_redraw = force_redraw || using_canvas;
+        bool energy_changed = updateEnergy(status);
+        bool age_changed = updateDataAge(status);
         
         // Skip if nothing changed AND we're not forcing a redraw
-        if (!rssi_changed && !temp_changed && !time_changed && !effective_force_redraw) {
+        if (!rssi_changed && !temp_changed && !time_changed && !energy_changed && !age_changed &&
+            !force_redraw) {
             return;
         }
         
-        // If using canvas, clear it first
-        if (using_canvas) {
-            status_canvas->fillScreen(STATUS_BAR_BG_COLOR);
-        }
-        
         // Update WiFi icon
-        if (rssi_changed || effective_force_redraw) {
-            drawWiFiIcon(target, current_level);
+        if (rssi_changed || force_redraw) {
             prev_rssi_level = current_level;
+            renderer.markWidgetDirty(WIDGET_WIFI);
         }
         
         // Update temperature
-        if (temp_changed || effective_force_redraw) {
-            drawTemperature(target, rounded_temp);
+        if (temp_changed || force_redraw) {
+            updateTemperature(rounded_temp);
             prev_status.internal_temp = status.internal_temp;
         }
         
         // Update time (segment by segment)
-        if (time_changed || effective_force_redraw) {
-            drawTime(target, status, effective_force_redraw);
-            prev_status.hours = status.hours;
-            prev_status.minutes = status.minutes;
-            prev_status.seconds = status.seconds;
+        if (time_changed || force_redraw) {
+            updateTime(status, force_redraw);
+        }
+        
+        // Update energy totals
+        if (energy_changed || force_redraw) {
+            renderer.markWidgetDirty(WIDGET_ENERGY);
         }
         
-        // Flush canvas to screen atomically - no flicker!
-        if (using_canvas) {
-            flushCanvas(status_canvas, 0, 0);
+        // Update sample age
+        if (age_changed || force_redraw) {
+            renderer.markWidgetDirty(WIDGET_DATA_AGE);
         }
+        
+        // Re-rasterise changed regions band by band - no flicker!
+        renderer.render(RENDER_STATUS);
     }
     
     /**
      * Update main display area (power, voltage, current)
      */
     void drawMainDisplay(const PowerData& power, bool force_redraw) {
-        int main_area_y = STATUS_BAR_HEIGHT + 1 + STATUS_BAR_V_PADDING;
-        int main_area_h = tft->height() - main_area_y;
-        
-        int power_area_y = 0;  // Relative to canvas
-        int power_area_h = main_area_h * 3 / 5;
-        int va_area_y = power_area_h;  // Relative to canvas
-        int va_area_h = main_area_h - power_area_h;
-        
         // Determine power color
-        uint16_t current_power_color = getPowerColor(power.power_active);
+        uint16_t current_power_color = stale ? STALE_VALUE_COLOR : getPowerColor(power.power_active);
         
-        // Get drawing target (canvas if available, else TFT directly)
-        Adafruit_GFX* target = getDrawTarget(main_canvas);
-        bool using_canvas = (target == (Adafruit_GFX*)main_canvas);
+        // Previous values are updated only when a widget changes
+        updatePowerValue(power.power_active, current_power_color, force_redraw);
+        if (meter_count == 1) {
+            updateVoltageCurrent(power.voltage, power.current, force_redraw);
+        }
+        
+        // Re-rasterise changed regions band by band - no flicker!
+        renderer.render(RENDER_MAIN);
+    }
+    
+    /**
+     * Gray out the readings (last known values while WiFi is down)
+     * Only the power, voltage and current widgets are re-rasterised
+     */
+    void setStale(bool is_stale) {
+        if (is_stale == stale) return;
+        stale = is_stale;
         
-        // If using canvas, we MUST redraw everything because we clear the canvas
-        bool effective_force_redraw = force_redraw || using_canvas;
+        // Nothing to recolor before the first drawMainDisplay()
+        if (power_value_str[0] == '\0') return;
         
-        // If using canvas, clear it first
-        if (using_canvas) {
-            main_canvas->fillScreen(BG_COLOR);
+        if (meter_count > 1) {
+            renderer.markWidgetDirty(WIDGET_METERS);
+        }
+        PowerData shown = prev_power;
+        drawMainDisplay(shown, true);
+    }
+    
+    bool isStale() {
+        return stale;
+    }
+    
+    /**
+     * Show one cell per meter in the bottom row instead of voltage and
+     * current (count > 1); the power widget then shows the total
+     * Call after begin() and before drawInitialUI()
+     */
+    void setMeterCount(int count) {
+        meter_count = constrain(count, 1, METER_MAX);
+        renderer.clearWidgets();
+        setupWidgets();
+    }
+    
+    /**
+     * Update the meter cells (no-op with a single meter)
+     * A cell is re-rasterised only when its text or staleness changed
+     */
+    void drawMeters(const MeterReading* meters, bool force_redraw) {
+        if (meter_count <= 1) return;
+        
+        for (int i = 0; i < meter_count; i++) {
+            const MeterReading& m = meters[i];
+            MeterReading& shown = meter_shown[i];
+            bool changed = m.has_data != shown.has_data || m.stale != shown.stale ||
+                           meterTextChanged(m.data, shown.data);
+            if (!changed && !force_redraw) continue;
+            
+            shown = m;
+            const Layout::Rect cell = Layout::meterCell(i, meter_count);
+            renderer.markDirty(cell.x, cell.y, cell.w, cell.h);
         }
         
-        // Draw power value (coordinates relative to canvas/main area)
-        drawPowerValue(target, power.power_active, current_power_color,
-                      0, power_area_y, screen_width, power_area_h,
-                      prev_power.power_active, prev_power_color, effective_force_redraw);
+        renderer.render(RENDER_MAIN);
+    }
+    
+    /**
+     * Add the newest power reading to the sweep graph
+     * Each call advances the cursor by one column; only that column and
+     * the blank gap ahead of it are redrawn
+     */
+    void addGraphSample(float power) {
+        if (!ENABLE_POWER_GRAPH) return;
         
-        // Draw voltage and current (coordinates relative to canvas/main area)
-        drawVoltageCurrentRevised(target, power.voltage, power.current,
-                                 VA_FONT_SIZE, VOLTAGE_COLOR, CURRENT_COLOR,
-                                 0, va_area_y, screen_width, va_area_h,
-                                 prev_power.voltage, prev_power.current, effective_force_redraw);
+        int col = graph_cursor;
+        float ratio = constrain(power / GRAPH_MAX_POWER, 0.0f, 1.0f);
+        graph_cols[col] = max(1, (int)lroundf(ratio * Layout::GRAPH.h)); // 1 px baseline = data present
+        graph_colors[col] = getPowerColor(power);
         
-        // Flush canvas to screen atomically - no flicker!
-        if (using_canvas) {
-            flushCanvas(main_canvas, 0, main_area_y);
-        }
+        // Clear the gap column that the sweep moves into
+        int gap_col = (col + GRAPH_GAP_COLUMNS) % renderer.width();
+        graph_cols[gap_col] = 0;
+        
+        graph_cursor = (col + 1) % renderer.width();
         
-        // Update previous values
-        prev_power = power;
-        prev_power_color = current_power_color;
+        // New column, moved cursor and gap (split when the sweep wraps)
+        if (gap_col > col) {
+            renderer.markDirty(col, Layout::GRAPH.y, gap_col - col + 1, Layout::GRAPH.h);
+        } else {
+            renderer.markDirty(col, Layout::GRAPH.y, renderer.width() - col, Layout::GRAPH.h);
+            renderer.markDirty(0, Layout::GRAPH.y, gap_col + 1, Layout::GRAPH.h);
+        }
+        renderer.render(RENDER_GRAPH);
+    }
+    
+    /**
+     * Show the last profiler window in the overlay (no-op unless
+     * ENABLE_PROFILER and PROFILER_OVERLAY)
+     */
+    void updateProfilerOverlay() {
+#if ENABLE_PROFILER
+        if (!PROFILER_OVERLAY) return;
+        
+        const ProfileSummary& render = profiler().getSummary(PROF_RENDER);
+        snprintf(profiler_str, sizeof(profiler_str), "R%.1f/%.1fms",
+                 render.avg_us / 1000.0f, render.p99_us / 1000.0f);
+        renderer.markWidgetDirty(WIDGET_PROFILER);
+        renderer.render(RENDER_GRAPH);
+#endif
+    }
+    
+    /**
+     * Record render and flush times (may be nullptr)
+     */
+    void setStats(FirmwareStats* firmware_stats) {
+        renderer.setStats(firmware_stats);
+    }
+    
+    /**
+     * Register callback fired when a DMA flush of a region completes
+     * Runs in interrupt context
+     */
+    void setFlushCompleteCallback(DmaFlusher::CompletionCallback callback, void* arg) {
+        renderer.setFlushCompleteCallback(callback, arg);
+    }
+    
+    /**
+     * Check if pixels are still being transferred in the background
+     */
+    bool isFlushing() {
+        return renderer.isFlushing();
+    }
+    
+    /**
+     * Block until queued DMA transfers are on the panel
+     */
+    void waitFlush() {
+        renderer.waitFlush();
+    }
+    
+    /**
+     * Hand the panel to the caller for raw drawing (benchmarks)
+     * The scene is stale afterwards; call drawInitialUI() to restore it
+     */
+    Adafruit_ST7789* beginRawDraw() {
+        waitFlush();
+        renderer.beginDirectDraw();
+        return renderer.panel();
     }
 
 private:
-    Adafruit_ST7789* tft;
-    GFXcanvas16* status_canvas;
-    GFXcanvas16* main_canvas;
-    BufferMode buffer_mode;
-    int screen_width;
-    int wifi_icon_x, wifi_icon_y;
-    int temp_text_right_x, time_text_left_x;
-    
-    // Previous state for change detection
+#ifdef HOST_BUILD
+    friend class HostBench;   // host/bench.cpp times the private helpers
+#endif
+    BandRenderer renderer;
+    
+    // Previous state for change detection (what the scene currently shows)
     PowerData prev_power;
     StatusData prev_status;
     uint16_t prev_power_color;
     int prev_rssi_level;
+    bool stale;                           // Readings drawn in STALE_VALUE_COLOR
+    int meter_count;                      // > 1: meter cells instead of voltage/current
+    MeterReading meter_shown[METER_MAX];
+    
+    // Formatted widget content and text bounds (screen coordinates)
+    char power_value_str[12];
+    char power_unit_str[4];
+    char voltage_str[16];
+    char current_str[16];
+    int16_t power_unit_x, power_unit_y;
+    DirtyRegion power_bounds;
+    DirtyRegion voltage_bounds;
+    DirtyRegion current_bounds;
+    DirtyRegion temp_bounds;
+    char energy_today_str[12];
+    char energy_month_str[12];
+    char data_age_str[6];                 // Empty while the data is fresh
+    char profiler_str[16];
+    
+    // Sweep graph column cache (height 0 = blank column)
+    uint8_t graph_cols[SCREEN_WIDTH];
+    uint16_t graph_colors[SCREEN_WIDTH];
+    int graph_cursor;
+    
+    /**
+     * Describe the scene as a list of widget rectangles
+     */
+    void setupWidgets() {
+        markWidget(WIDGET_WIFI, Layout::WIFI_ICON);
+        markWidget(WIDGET_TEMP, Layout::TEMP);
+        markWidget(WIDGET_TIME, Layout::TIME);
+        markWidget(WIDGET_ENERGY, Layout::ENERGY);
+        markWidget(WIDGET_DATA_AGE, Layout::DATA_AGE);
+        markWidget(WIDGET_STATUS_LINE, Layout::STATUS_LINE);
+        markWidget(WIDGET_POWER, Layout::POWER);
+        if (meter_count > 1) {
+            markWidget(WIDGET_METERS, Layout::METERS);
+        } else {
+            markWidget(WIDGET_VOLTAGE, Layout::VOLTAGE);
+            markWidget(WIDGET_CURRENT, Layout::CURRENT);
+        }
+        if (ENABLE_POWER_GRAPH) {
+            markWidget(WIDGET_GRAPH, Layout::GRAPH);
+        }
+        if (ENABLE_PROFILER && PROFILER_OVERLAY) {
+            markWidget(WIDGET_PROFILER, Layout::PROFILER);
+        }
+    }
+    
+    void markWidget(int id, const Layout::Rect& rect) {
+        renderer.setWidget(id, rect.x, rect.y, rect.w, rect.h);
+    }
     
     /**
-     * Flush canvas to screen at specified position
+     * Draw one widget with its current content
+     * y_offset is the screen row mapped to row 0 of the target
      */
-    void flushCanvas(GFXcanvas16* canvas, int x, int y) {
-        if (canvas && canvas->getBuffer()) {
-            tft->drawRGBBitmap(x, y, canvas->getBuffer(), canvas->width(), canvas->height());
+    void drawWidget(Adafruit_GFX* target, int id, int y_offset) override {
+        switch (id) {
+            case WIDGET_WIFI:        drawWiFiIcon(target, y_offset); break;
+            case WIDGET_TEMP:        drawTemperature(target, y_offset); break;
+            case WIDGET_TIME:        drawTime(target, y_offset); break;
+            case WIDGET_ENERGY:      drawEnergy(target, y_offset); break;
+            case WIDGET_DATA_AGE:    drawDataAge(target, y_offset); break;
+            case WIDGET_STATUS_LINE:
+                target->drawFastHLine(0, STATUS_BAR_HEIGHT - y_offset, renderer.width(),
+                                      STATUS_BAR_LINE_COLOR);
+                break;
+            case WIDGET_POWER:       drawPowerValue(target, y_offset); break;
+            case WIDGET_VOLTAGE:     drawVoltage(target, y_offset); break;
+            case WIDGET_CURRENT:     drawCurrent(target, y_offset); break;
+            case WIDGET_METERS:      drawMeterCells(target, y_offset); break;
+            case WIDGET_GRAPH:       drawGraph(target, y_offset); break;
+            case WIDGET_PROFILER:    drawProfilerOverlay(target, y_offset); break;
         }
     }
     
     /**
-     * Get drawing target (canvas or tft)
+     * Fill background of a screen rectangle (status bar rows use their own color)
      */
-    Adafruit_GFX* getDrawTarget(GFXcanvas16* canvas) {
-        return (canvas && canvas->getBuffer()) ? (Adafruit_GFX*)canvas : (Adafruit_GFX*)tft;
+    void fillBackground(Adafruit_GFX* target, int x, int y, int w, int h, int y_offset) override {
+        int status_rows = min(h, max(0, STATUS_BAR_HEIGHT - y));
+        if (status_rows > 0) {
+            target->fillRect(x, y - y_offset, w, status_rows, STATUS_BAR_BG_COLOR);
+        }
+        if (h > status_rows) {
+            target->fillRect(x, y + status_rows - y_offset, w, h - status_rows, BG_COLOR);
+        }
     }
     
     /**
@@ -455,235 +608,418 @@ private:
     }
     
     /**
-     * Calculate centered text position
+     * Determine temperature color based on value
      */
-    void getTextCenterPos(Adafruit_GFX* target, const String& text, int font_size, 
-                         int area_x, int area_y, int area_w, int area_h,
-                         int16_t& cursor_x, int16_t& cursor_y) {
-        int16_t x1, y1;
-        uint16_t w, h;
-        target->setTextSize(font_size);
-        target->getTextBounds(text, 0, 0, &x1, &y1, &w, &h);
-        cursor_x = area_x + (area_w - w) / 2;
-        cursor_y = area_y + (area_h - h) / 2 + 1;
+    uint16_t getTempColor(long rounded_temp) {
+        if (rounded_temp < 60) return TEMP_COLOR_GREEN;
+        if (rounded_temp <= 65) return TEMP_COLOR_YELLOW;
+        if (rounded_temp <= 70) return TEMP_COLOR_ORANGE;
+        return TEMP_COLOR_RED;
     }
     
     /**
      * Draw WiFi icon (rectangle bars version)
      */
-    void drawWiFiIcon(Adafruit_GFX* target, int level) {
+    void drawWiFiIcon(Adafruit_GFX* target, int y_offset) {
         const int bar_max_h = WIFI_ICON_HEIGHT;
         const int bar_w = 4;
         const int bar_gap = 2;
         int total_icon_w = 4 * bar_w + 3 * bar_gap;
-        int start_x = wifi_icon_x + (WIFI_ICON_WIDTH - total_icon_w) / 2;
-        
-        target->fillRect(wifi_icon_x, wifi_icon_y, WIFI_ICON_WIDTH, WIFI_ICON_HEIGHT, 
-                     STATUS_BAR_BG_COLOR);
+        int start_x = Layout::WIFI_ICON.x + (WIFI_ICON_WIDTH - total_icon_w) / 2;
+        int icon_y = Layout::WIFI_ICON.y - y_offset;
         
         int current_x = start_x;
         for (int i = 0; i < 4; i++) {
-            uint16_t color = (level >= i + 1) ? WIFI_ICON_COLOR : STATUS_BAR_LINE_COLOR;
+            uint16_t color = (prev_rssi_level >= i + 1) ? WIFI_ICON_COLOR : STATUS_BAR_LINE_COLOR;
             int bar_h = bar_max_h * (i + 1) / 4;
-            target->fillRect(current_x, wifi_icon_y + bar_max_h - bar_h, bar_w, bar_h, color);
+            target->fillRect(current_x, icon_y + bar_max_h - bar_h, bar_w, bar_h, color);
             current_x += (bar_w + bar_gap);
         }
     }
     
+    /**
+     * Update temperature content and mark it dirty
+     */
+    void updateTemperature(long rounded_temp) {
+        char temp_str[8];
+        formatTemperature(temp_str, sizeof(temp_str), rounded_temp);
+        
+        // Right-aligned against the WiFi icon
+        int w = Layout::textWidth(strlen(temp_str), STATUS_BAR_FONT_SIZE);
+        renderer.markTextDirty(temp_bounds, Layout::TEMP_RIGHT_X - w, Layout::STATUS_TEXT_Y,
+                      w, Layout::textHeight(STATUS_BAR_FONT_SIZE));
+    }
+    
+    void formatTemperature(char* buffer, size_t size, long rounded_temp) {
+        snprintf(buffer, size, "%ld%cC", rounded_temp, (char)247);
+    }
+    
     /**
      * Draw temperature display
      */
-    void drawTemperature(Adafruit_GFX* target, long rounded_temp) {
+    void drawTemperature(Adafruit_GFX* target, int y_offset) {
+        if (!temp_bounds.is_dirty) return;
+        
+        long rounded_temp = round(prev_status.internal_temp);
         char temp_str[8];
-        snprintf(temp_str, sizeof(temp_str), "%ld%cC", rounded_temp, (char)247);
-        
-        const int max_temp_width_pixels = 65;
-        int clear_x = temp_text_right_x - max_temp_width_pixels;
-        if (clear_x < 0) clear_x = 0;
-        int clear_width = max_temp_width_pixels;
-        if (clear_x == 0) clear_width = temp_text_right_x;
-        
-        target->fillRect(clear_x, 0, clear_width, STATUS_BAR_HEIGHT, STATUS_BAR_BG_COLOR);
-        
-        // Determine color based on temperature
-        uint16_t temp_color;
-        if (rounded_temp < 60) {
-            temp_color = TEMP_COLOR_GREEN;
-        } else if (rounded_temp <= 65) {
-            temp_color = TEMP_COLOR_YELLOW;
-        } else if (rounded_temp <= 70) {
-            temp_color = TEMP_COLOR_ORANGE;
+        formatTemperature(temp_str, sizeof(temp_str), rounded_temp);
+        
+        renderer.drawText(target, temp_str, STATUS_BAR_FONT_SIZE, getTempColor(rounded_temp),
+                 temp_bounds.x, temp_bounds.y, y_offset);
+    }
+    
+    /**
+     * Update time content, marking only the segments that changed
+     */
+    void updateTime(const StatusData& status, bool force_redraw) {
+        const int text_h = Layout::textHeight(TIME_FONT_SIZE);
+        const int text_y = Layout::TIME_TEXT_Y;
+        
+        if (force_redraw) {
+            renderer.markWidgetDirty(WIDGET_TIME);
         } else {
-            temp_color = TEMP_COLOR_RED;
+            if (status.hour != prev_status.hour) {
+                renderer.markDirty(Layout::timeSegmentX(0), text_y, TIME_SEGMENT_WIDTH, text_h);
+            }
+            if (status.minute != prev_status.minute) {
+                renderer.markDirty(Layout::timeSegmentX(1), text_y, TIME_SEGMENT_WIDTH, text_h);
+            }
+            if (status.second != prev_status.second) {
+                renderer.markDirty(Layout::timeSegmentX(2), text_y, TIME_SEGMENT_WIDTH, text_h);
+            }
         }
         
-        target->setTextSize(STATUS_BAR_FONT_SIZE);
-        target->setTextColor(temp_color);
-        int16_t x1, y1;
-        uint16_t w, h;
-        target->getTextBounds(temp_str, 0, 0, &x1, &y1, &w, &h);
-        int text_y = (STATUS_BAR_HEIGHT - h) / 2 + 1;
-        int text_x = temp_text_right_x - w;
-        target->setCursor(text_x, text_y);
-        target->print(temp_str);
+        prev_status.hour = status.hour;
+        prev_status.minute = status.minute;
+        prev_status.second = status.second;
     }
     
     /**
-     * Draw time segment
+     * Draw time segment (right-aligned in its cell)
      */
-    void drawTimeSegment(Adafruit_GFX* target, const String& text, const String& prev_text, 
-                        int x_pos, bool force_redraw) {
-        if (text != prev_text || force_redraw) {
-            target->fillRect(x_pos, 0, TIME_SEGMENT_WIDTH, STATUS_BAR_HEIGHT, 
-                         STATUS_BAR_BG_COLOR);
-            
-            target->setTextSize(TIME_FONT_SIZE);
-            target->setTextColor(TIME_COLOR);
-            int16_t x1, y1;
-            uint16_t w, h;
-            target->getTextBounds(text, 0, 0, &x1, &y1, &w, &h);
-            int text_y = (STATUS_BAR_HEIGHT - h) / 2 + 1;
-            int text_x = x_pos + TIME_SEGMENT_WIDTH - w;
-            target->setCursor(text_x, text_y);
-            target->print(text);
-        }
+    void drawTimeSegment(Adafruit_GFX* target, int8_t value, int x_pos, int y_offset) {
+        char text[3];
+        StatusData::formatSegment(text, value);
+        text[2] = '\0';
+        
+        int text_x = x_pos + TIME_SEGMENT_WIDTH - Layout::textWidth(strlen(text), TIME_FONT_SIZE);
+        renderer.drawText(target, text, TIME_FONT_SIZE, TIME_COLOR, text_x, Layout::TIME_TEXT_Y, y_offset);
     }
     
     /**
      * Draw time separator
      */
-    void drawTimeSeparator(Adafruit_GFX* target, int x_pos, bool force_redraw) {
-        if (force_redraw) {
-            target->setTextSize(TIME_FONT_SIZE);
-            target->setTextColor(TIME_COLOR);
-            target->setCursor(x_pos, (STATUS_BAR_HEIGHT - 16) / 2 + 1);
-            target->print(":");
-        }
+    void drawTimeSeparator(Adafruit_GFX* target, int x_pos, int y_offset) {
+        renderer.drawText(target, ":", TIME_FONT_SIZE, TIME_COLOR, x_pos, Layout::TIME_TEXT_Y, y_offset);
     }
     
     /**
      * Draw complete time display
      */
-    void drawTime(Adafruit_GFX* target, const StatusData& status, bool force_redraw) {
-        int time_start_x = time_text_left_x;
-        
-        drawTimeSegment(target, status.hours, prev_status.hours, time_start_x, force_redraw);
-        
-        int sep1_x = time_start_x + TIME_SEGMENT_WIDTH;
-        drawTimeSeparator(target, sep1_x, force_redraw);
-        
-        int min_x = sep1_x + TIME_SEPARATOR_WIDTH;
-        drawTimeSegment(target, status.minutes, prev_status.minutes, min_x, force_redraw);
+    void drawTime(Adafruit_GFX* target, int y_offset) {
+        drawTimeSegment(target, prev_status.hour, Layout::timeSegmentX(0), y_offset);
+        drawTimeSeparator(target, Layout::timeSegmentX(0) + TIME_SEGMENT_WIDTH, y_offset);
+        drawTimeSegment(target, prev_status.minute, Layout::timeSegmentX(1), y_offset);
+        drawTimeSeparator(target, Layout::timeSegmentX(1) + TIME_SEGMENT_WIDTH, y_offset);
+        drawTimeSegment(target, prev_status.second, Layout::timeSegmentX(2), y_offset);
+    }
+    
+    /**
+     * Format energy totals; returns true if the shown text changes
+     */
+    bool updateEnergy(const StatusData& status) {
+        char today[sizeof(energy_today_str)];
+        char month[sizeof(energy_month_str)];
+        formatEnergy(today, sizeof(today), status.energy_today);
+        formatEnergy(month, sizeof(month), status.energy_month);
+        
+        if (strcmp(today, energy_today_str) == 0 && strcmp(month, energy_month_str) == 0) {
+            return false;
+        }
         
-        int sep2_x = min_x + TIME_SEGMENT_WIDTH;
-        drawTimeSeparator(target, sep2_x, force_redraw);
+        strcpy(energy_today_str, today);
+        strcpy(energy_month_str, month);
+        return true;
+    }
+    
+    /**
+     * Keep about four significant digits in a fixed width
+     */
+    void formatEnergy(char* buffer, size_t size, float kwh) {
+        if (kwh < 10.0f) {
+            snprintf(buffer, size, "%.2fkWh", kwh);
+        } else if (kwh < 100.0f) {
+            snprintf(buffer, size, "%.1fkWh", kwh);
+        } else {
+            snprintf(buffer, size, "%.0fkWh", kwh);
+        }
+    }
+    
+    /**
+     * Draw "Today" and "Month" rows, labels left and values right-aligned
+     */
+    void drawEnergy(Adafruit_GFX* target, int y_offset) {
+        const Layout::Rect& area = Layout::ENERGY;
+        
+        renderer.drawText(target, "Today", ENERGY_FONT_SIZE, ENERGY_LABEL_COLOR,
+                 area.x, Layout::ENERGY_TODAY_Y, y_offset);
+        renderer.drawText(target, energy_today_str, ENERGY_FONT_SIZE, ENERGY_VALUE_COLOR,
+                 area.right() - Layout::textWidth(strlen(energy_today_str), ENERGY_FONT_SIZE),
+                 Layout::ENERGY_TODAY_Y, y_offset);
+        
+        renderer.drawText(target, "Month", ENERGY_FONT_SIZE, ENERGY_LABEL_COLOR,
+                 area.x, Layout::ENERGY_MONTH_Y, y_offset);
+        renderer.drawText(target, energy_month_str, ENERGY_FONT_SIZE, ENERGY_VALUE_COLOR,
+                 area.right() - Layout::textWidth(strlen(energy_month_str), ENERGY_FONT_SIZE),
+                 Layout::ENERGY_MONTH_Y, y_offset);
+    }
+    
+    /**
+     * Format the sample age; returns true if the shown text changes
+     */
+    bool updateDataAge(const StatusData& status) {
+        char age[sizeof(data_age_str)];
+        formatDataAge(age, sizeof(age), status.data_age_s);
         
-        int sec_x = sep2_x + TIME_SEPARATOR_WIDTH;
-        drawTimeSegment(target, status.seconds, prev_status.seconds, sec_x, force_redraw);
+        if (strcmp(age, data_age_str) == 0) return false;
+        strcpy(data_age_str, age);
+        return true;
     }
     
     /**
-     * Draw power value with W/kW conversion
+     * Three characters at most ("45s", "12m", "3h", "2d"); empty while
+     * the newest sample is younger than DATA_STALE_MS
      */
-    void drawPowerValue(Adafruit_GFX* target, float value, uint16_t value_color,
-                       int area_x, int area_y, int area_w, int area_h,
-                       float prev_value, uint16_t prev_color, bool force_redraw) {
+    void formatDataAge(char* buffer, size_t size, long age_s) {
+        if (age_s < DATA_STALE_MS / 1000) {
+            buffer[0] = '\0';
+        } else if (age_s < 100) {
+            snprintf(buffer, size, "%lds", age_s);
+        } else if (age_s < 100 * 60) {
+            snprintf(buffer, size, "%ldm", age_s / 60);
+        } else if (age_s < 100 * 3600) {
+            snprintf(buffer, size, "%ldh", age_s / 3600);
+        } else {
+            snprintf(buffer, size, "%ldd", min(age_s / 86400, 99L));
+        }
+    }
+    
+    /**
+     * Draw the sample age centered under the WiFi icon
+     */
+    void drawDataAge(Adafruit_GFX* target, int y_offset) {
+        if (data_age_str[0] == '\0') return;
         
-        bool value_changed = abs(value - prev_value) > POWER_CHANGE_THRESHOLD;
-        bool color_changed = (value_color != prev_color);
+        const Layout::Rect& area = Layout::DATA_AGE;
+        int w = Layout::textWidth(strlen(data_age_str), DATA_AGE_FONT_SIZE);
+        renderer.drawText(target, data_age_str, DATA_AGE_FONT_SIZE, DATA_AGE_COLOR,
+                 area.x + (area.w - w) / 2, area.y, y_offset);
+    }
+    
+    /**
+     * Update power value with W/kW conversion and mark it dirty
+     * Only a change in the formatted text or its color redraws
+     */
+    void updatePowerValue(float value, uint16_t value_color, bool force_redraw) {
+        char value_str[sizeof(power_value_str)];
+        bool kw = value >= 1000.0f;
+        const char* unit_str = kw ? "kW" : "W";
+        if (kw) {
+            snprintf(value_str, sizeof(value_str), "%.1f", value / 1000.0f);
+        } else {
+            snprintf(value_str, sizeof(value_str), "%d", (int)round(value));
+        }
         
-        if (!value_changed && !color_changed && !force_redraw) {
+        prev_power.power_active = value;
+        if (!force_redraw && value_color == prev_power_color &&
+            strcmp(value_str, power_value_str) == 0 && strcmp(unit_str, power_unit_str) == 0) {
             return;
         }
         
-        // Use regular fillRect - works correctly inside transactions
-        target->fillRect(area_x, area_y, area_w, area_h, BG_COLOR);
+        strcpy(power_value_str, value_str);
+        strcpy(power_unit_str, unit_str);
         
-        String value_str;
-        String unit_str;
-        int unit_gap;
+        int len = strlen(power_value_str);
+        const Layout::PowerText pos = len <= POWER_TEXT_MAX_CHARS ?
+            Layout::POWER_TEXT[kw][len] : Layout::powerText(len, kw);
         
-        if (value >= 1000.0f) {
-            float kw_value = value / 1000.0f;
-            value_str = String(kw_value, 1);
-            unit_str = "kW";
-            unit_gap = 2;
-        } else {
-            value_str = String((int)round(value), 10);
-            unit_str = "W";
-            unit_gap = 3;
-        }
+        power_unit_x = pos.unit_x;
+        power_unit_y = pos.unit_y;
         
-        int16_t x1, y1;
-        uint16_t value_w, value_h, unit_w, unit_h;
-        target->setTextSize(POWER_VALUE_FONT_SIZE);
-        target->getTextBounds(value_str, 0, 0, &x1, &y1, &value_w, &value_h);
-        target->setTextSize(POWER_UNIT_FONT_SIZE);
-        target->getTextBounds(unit_str, 0, 0, &x1, &y1, &unit_w, &unit_h);
-        
-        uint16_t total_w = value_w + unit_gap + unit_w;
-        int16_t start_x = area_x + (area_w - total_w) / 2;
-        int16_t start_y = area_y + (area_h - value_h) / 2;
+        renderer.markTextDirty(power_bounds, pos.x, pos.y, pos.w, pos.h);
+        prev_power_color = value_color;
+    }
+    
+    /**
+     * Draw power value
+     */
+    void drawPowerValue(Adafruit_GFX* target, int y_offset) {
+        if (!power_bounds.is_dirty) return;
         
-        target->setTextSize(POWER_VALUE_FONT_SIZE);
-        target->setTextColor(value_color);
-        target->setCursor(start_x, start_y);
-        target->print(value_str);
+        renderer.drawText(target, power_value_str, POWER_VALUE_FONT_SIZE, prev_power_color,
+                 power_bounds.x, power_bounds.y, y_offset);
+        renderer.drawText(target, power_unit_str, POWER_UNIT_FONT_SIZE, prev_power_color,
+                 power_unit_x, power_unit_y, y_offset);
+    }
+    
+    void formatVoltage(char* buffer, size_t size, float v) {
+        snprintf(buffer, size, "%dV", (int)round(v));
+    }
+    
+    void formatCurrent(char* buffer, size_t size, float c) {
+        snprintf(buffer, size, "%.1fA", c);
+    }
+    
+    /**
+     * Per-meter power, at most 5 characters ("9999W", "9.9kW", "12kW")
+     */
+    void formatMeterPower(char* buffer, size_t size, float p) {
+        if (p >= 10000.0f) {
+            snprintf(buffer, size, "%dkW", (int)round(p / 1000.0f));
+        } else if (p >= 1000.0f) {
+            snprintf(buffer, size, "%.1fkW", p / 1000.0f);
+        } else {
+            snprintf(buffer, size, "%dW", (int)round(p));
+        }
+    }
+    
+    /**
+     * Whether a meter cell would show different voltage or power text
+     */
+    bool meterTextChanged(const PowerData& a, const PowerData& b) {
+        char a_str[8], b_str[8];
+        formatVoltage(a_str, sizeof(a_str), a.voltage);
+        formatVoltage(b_str, sizeof(b_str), b.voltage);
+        if (strcmp(a_str, b_str) != 0) return true;
+        
+        formatMeterPower(a_str, sizeof(a_str), a.power_active);
+        formatMeterPower(b_str, sizeof(b_str), b.power_active);
+        return strcmp(a_str, b_str) != 0;
+    }
+    
+    /**
+     * Update voltage and current (separately centered) and mark them dirty
+     * when their formatted text changed
+     */
+    void updateVoltageCurrent(float v, float c, bool force_redraw) {
+        char str[sizeof(voltage_str)];
+        prev_power.voltage = v;
+        prev_power.current = c;
+        
+        formatVoltage(str, sizeof(str), v);
+        if (force_redraw || strcmp(str, voltage_str) != 0) {
+            strcpy(voltage_str, str);
+            markVATextDirty(voltage_bounds, Layout::VOLTAGE, Layout::VOLTAGE_TEXT, strlen(str));
+        }
         
-        int16_t unit_y = start_y + (value_h - unit_h) - (value_h / 10);
-        target->setTextSize(POWER_UNIT_FONT_SIZE);
-        target->setTextColor(value_color);
-        target->setCursor(start_x + value_w + unit_gap, unit_y);
-        target->print(unit_str);
+        formatCurrent(str, sizeof(str), c);
+        if (force_redraw || strcmp(str, current_str) != 0) {
+            strcpy(current_str, str);
+            markVATextDirty(current_bounds, Layout::CURRENT, Layout::CURRENT_TEXT, strlen(str));
+        }
+    }
+    
+    /**
+     * Mark a voltage/current string of len characters, centered in its area
+     */
+    void markVATextDirty(DirtyRegion& bounds, const Layout::Rect& area,
+                         const Layout::TextPos* table, int len) {
+        const Layout::TextPos pos = len <= VA_TEXT_MAX_CHARS ?
+            table[len] : Layout::centerText(area, len, VA_FONT_SIZE);
+        renderer.markTextDirty(bounds, pos.x, pos.y,
+                      Layout::textWidth(len, VA_FONT_SIZE), Layout::textHeight(VA_FONT_SIZE));
     }
     
     /**
-     * Draw voltage and current (separately centered)
+     * Draw voltage value
      */
-    void drawVoltageCurrentRevised(Adafruit_GFX* target, float v, float c, int font_size,
-                                  uint16_t v_color, uint16_t c_color,
-                                  int area_x, int area_y, int area_w, int area_h,
-                                  float prev_v, float prev_c, bool force_redraw) {
+    void drawVoltage(Adafruit_GFX* target, int y_offset) {
+        if (!voltage_bounds.is_dirty) return;
         
-        char v_str[16], c_str[16];
-        snprintf(v_str, sizeof(v_str), "%dV", (int)round(v));
-        snprintf(c_str, sizeof(c_str), "%.1fA", c);
+        renderer.drawText(target, voltage_str, VA_FONT_SIZE, stale ? STALE_VALUE_COLOR : VOLTAGE_COLOR,
+                 voltage_bounds.x, voltage_bounds.y, y_offset);
+    }
+    
+    /**
+     * Draw current value
+     */
+    void drawCurrent(Adafruit_GFX* target, int y_offset) {
+        if (!current_bounds.is_dirty) return;
         
-        bool v_changed = (round(v) != round(prev_v));
-        bool c_changed = (abs(c - prev_c) > CURRENT_CHANGE_THRESHOLD);
+        renderer.drawText(target, current_str, VA_FONT_SIZE, stale ? STALE_VALUE_COLOR : CURRENT_COLOR,
+                 current_bounds.x, current_bounds.y, y_offset);
+    }
+    
+    /**
+     * Draw the meter cells inside the columns being re-rasterised
+     * "L1 230V" over the meter's power; "L1" over "--" until it reports
+     */
+    void drawMeterCells(Adafruit_GFX* target, int y_offset) {
+        for (int i = 0; i < meter_count; i++) {
+            const Layout::Rect cell = Layout::meterCell(i, meter_count);
+            if (cell.right() <= renderer.clipX0() || cell.x >= renderer.clipX1()) continue;
+            
+            const MeterReading& m = meter_shown[i];
+            bool gray = stale || m.stale;
+            char label[12], voltage[8], value[8];
+            snprintf(label, sizeof(label), METER_LABEL_PREFIX "%d", i + 1);
+            if (m.has_data) {
+                formatVoltage(voltage, sizeof(voltage), m.data.voltage);
+                formatMeterPower(value, sizeof(value), m.data.power_active);
+            } else {
+                voltage[0] = '\0';
+                strcpy(value, "--");
+            }
+            
+            // Label and voltage as one centered run, a space apart
+            int label_len = strlen(label);
+            int voltage_len = strlen(voltage);
+            int line_len = label_len + (voltage_len > 0 ? 1 + voltage_len : 0);
+            int x = cell.x + (cell.w - Layout::textWidth(line_len, METER_LABEL_FONT_SIZE)) / 2;
+            renderer.drawText(target, label, METER_LABEL_FONT_SIZE, METER_LABEL_COLOR,
+                     x, Layout::METER_LABEL_Y, y_offset);
+            if (voltage_len > 0) {
+                renderer.drawText(target, voltage, METER_LABEL_FONT_SIZE, gray ? STALE_VALUE_COLOR : VOLTAGE_COLOR,
+                         x + Layout::textWidth(label_len + 1, METER_LABEL_FONT_SIZE),
+                         Layout::METER_LABEL_Y, y_offset);
+            }
+            
+            x = cell.x + (cell.w - Layout::textWidth(strlen(value), METER_VALUE_FONT_SIZE)) / 2;
+            renderer.drawText(target, value, METER_VALUE_FONT_SIZE,
+                     gray ? STALE_VALUE_COLOR : getPowerColor(m.data.power_active),
+                     x, Layout::METER_VALUE_Y, y_offset);
+        }
+    }
+    
+    /**
+     * Draw the graph columns that fall inside the area being re-rasterised
+     */
+    void drawGraph(Adafruit_GFX* target, int y_offset) {
+        int bottom = Layout::GRAPH.bottom() - y_offset;
+        int x1 = min(renderer.clipX1(), renderer.width());
         
-        if (!v_changed && !c_changed && !force_redraw) {
-            return;
+        for (int x = max(renderer.clipX0(), 0); x < x1; x++) {
+            if (graph_cols[x] > 0) {
+                target->drawFastVLine(x, bottom - graph_cols[x], graph_cols[x], graph_colors[x]);
+            }
         }
         
-        int value_area_w = area_w / 2;
-        int v_area_x = area_x;
-        int c_area_x = area_x + value_area_w;
-        
-        if (v_changed || force_redraw) {
-            // Use writeFillRect for faster rendering
-            target->fillRect(v_area_x, area_y, value_area_w, area_h, BG_COLOR);
-            int16_t cursor_x, cursor_y;
-            getTextCenterPos(target, String(v_str), font_size, v_area_x, area_y, 
-                           value_area_w, area_h, cursor_x, cursor_y);
-            target->setTextSize(font_size);
-            target->setTextColor(v_color);
-            target->setCursor(cursor_x, cursor_y);
-            target->print(v_str);
-        }
-        
-        if (c_changed || force_redraw) {
-            // Use writeFillRect for faster rendering
-            target->fillRect(c_area_x, area_y, value_area_w, area_h, BG_COLOR);
-            int16_t cursor_x, cursor_y;
-            getTextCenterPos(target, String(c_str), font_size, c_area_x, area_y, 
-                           value_area_w, area_h, cursor_x, cursor_y);
-            target->setTextSize(font_size);
-            target->setTextColor(c_color);
-            target->setCursor(cursor_x, cursor_y);
-            target->print(c_str);
+        // Cursor marks where the next sample lands
+        if (graph_cursor >= renderer.clipX0() && graph_cursor < x1) {
+            target->drawFastVLine(graph_cursor, Layout::GRAPH.y - y_offset, Layout::GRAPH.h, GRAPH_CURSOR_COLOR);
         }
     }
+    
+    /**
+     * Profiler summary on a cleared patch over the graph
+     */
+    void drawProfilerOverlay(Adafruit_GFX* target, int y_offset) {
+        if (!profiler_str[0]) return;
+        
+        const DirtyRegion& area = renderer.widget(WIDGET_PROFILER);
+        target->fillRect(area.x, area.y - y_offset, area.width, area.height, BG_COLOR);
+        renderer.drawText(target, profiler_str, 1, PROFILER_OVERLAY_COLOR, area.x + 1, area.y + 1, y_offset);
+    }
 };
 
 #endif // DISPLAY_MANAGER_H
@@ -0,0 +1,327 @@
+/*
+ * DMA Flusher for the ST7789
+ * Pushes canvas rectangles to the panel with GPSPI DMA, non-blocking
+ */
+
+#ifndef DMA_FLUSHER_H
+#define DMA_FLUSHER_H
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <driver/spi_master.h>
+#include <driver/gpio.h>
+#include <esp_attr.h>
+#include "config.h"
+#include "buffer_arena.h"
+
+// ST7789 commands used for address window writes
+#define DMA_CMD_CASET  0x2A
+#define DMA_CMD_RASET  0x2B
+#define DMA_CMD_RAMWR  0x2C
+
+// Flags stored in spi_transaction_t::user
+#define DMA_USER_DC    0x1   // D/C level during the transfer (1 = data)
+#define DMA_USER_LAST  0x2   // Last pixel chunk of a rectangle
+
+/**
+ * Owns the SPI bus while active and streams pixel rectangles with DMA.
+ * Pixels are byte-swapped into two DMA bounce buffers, so the next chunk
+ * is prepared while the previous one is still on the wire.
+ *
+ * The Arduino SPI driver and the ESP-IDF spi_master driver cannot share
+ * the bus: call release() before drawing directly via Adafruit_ST7789
+ * and acquire() afterwards.
+ */
+class DmaFlusher {
+public:
+    typedef void (*CompletionCallback)(void* arg);
+    
+    DmaFlusher() :
+        device(nullptr),
+        active(false),
+        next_slot(0),
+        pending(0),
+        queued_seq(0),
+        done_seq(0),
+        next_chunk(0),
+        on_complete(nullptr),
+        on_complete_arg(nullptr) {
+        chunk[0] = chunk[1] = nullptr;
+        chunk_seq[0] = chunk_seq[1] = 0;
+    }
+    
+    ~DmaFlusher() {
+        release();
+    }
+    
+    /**
+     * Take the DMA buffers from the arena and the SPI bus from Arduino
+     * Must be called after the panel was initialized by Adafruit_ST7789
+     * Returns false if DMA is unavailable (caller falls back to blocking writes)
+     */
+    bool begin() {
+        uint16_t* chunks = (uint16_t*)BufferArena::get(ARENA_DMA_CHUNKS);
+        if (!chunks) {
+            Serial.println("DMA buffers not in the arena");
+            return false;
+        }
+        chunk[0] = chunks;
+        chunk[1] = chunks + DMA_CHUNK_PIXELS;
+        return acquire();
+    }
+    
+    /**
+     * Take the SPI bus from the Arduino driver
+     */
+    bool acquire() {
+        if (active) return true;
+        if (!chunk[0] || !chunk[1]) return false;
+        
+        SPI.end();
+        
+        spi_bus_config_t bus_cfg;
+        memset(&bus_cfg, 0, sizeof(bus_cfg));
+        bus_cfg.mosi_io_num = TFT_MOSI;
+        bus_cfg.miso_io_num = -1;
+        bus_cfg.sclk_io_num = TFT_SCLK;
+        bus_cfg.quadwp_io_num = -1;
+        bus_cfg.quadhd_io_num = -1;
+        bus_cfg.max_transfer_sz = DMA_CHUNK_PIXELS * sizeof(uint16_t);
+        
+        esp_err_t err = spi_bus_initialize(SPI2_HOST, &bus_cfg, SPI_DMA_CH_AUTO);
+        if (err != ESP_OK) {
+            Serial.printf("SPI DMA bus init failed: %d\n", err);
+            SPI.begin();
+            return false;
+        }
+        
+        // CS is held low while we own the bus (the panel is the only device)
+        spi_device_interface_config_t dev_cfg;
+        memset(&dev_cfg, 0, sizeof(dev_cfg));
+        dev_cfg.clock_speed_hz = TFT_SPI_FREQ_HZ;
+        dev_cfg.mode = 0;
+        dev_cfg.spics_io_num = -1;
+        dev_cfg.flags = SPI_DEVICE_NO_DUMMY;
+        dev_cfg.queue_size = DMA_QUEUE_SIZE;
+        dev_cfg.pre_cb = preTransfer;
+        dev_cfg.post_cb = postTransfer;
+        
+        err = spi_bus_add_device(SPI2_HOST, &dev_cfg, &device);
+        if (err != ESP_OK) {
+            Serial.printf("SPI DMA device add failed: %d\n", err);
+            spi_bus_free(SPI2_HOST);
+            SPI.begin();
+            return false;
+        }
+        
+        instance = this;
+        digitalWrite(TFT_CS, LOW);
+        active = true;
+        return true;
+    }
+    
+    /**
+     * Hand the SPI bus back to the Arduino driver
+     * Blocks until all queued transfers are complete
+     */
+    void release() {
+        if (!active) return;
+        
+        waitIdle();
+        spi_bus_remove_device(device);
+        spi_bus_free(SPI2_HOST);
+        device = nullptr;
+        active = false;
+        
+        digitalWrite(TFT_CS, HIGH);
+        SPI.begin();
+    }
+    
+    /**
+     * Check if the DMA path currently owns the bus
+     */
+    bool isActive() {
+        return active;
+    }
+    
+    /**
+     * Register callback invoked when the last chunk of a rectangle is sent
+     * Runs in interrupt context - keep it short and ISR-safe
+     */
+    void setCompletionCallback(CompletionCallback callback, void* arg) {
+        on_complete = callback;
+        on_complete_arg = arg;
+    }
+    
+    /**
+     * Queue a rectangle from a host-order RGB565 buffer
+     * Returns once the pixels have been copied into the bounce buffers;
+     * the tail of the transfer continues in the background
+     */
+    void pushRect(const uint16_t* buffer, int stride, int x, int y, int w, int h) {
+        if (!active || w <= 0 || h <= 0) return;
+        
+        queueCommand(DMA_CMD_CASET);
+        queueData4(x >> 8, x & 0xFF, (x + w - 1) >> 8, (x + w - 1) & 0xFF);
+        queueCommand(DMA_CMD_RASET);
+        queueData4(y >> 8, y & 0xFF, (y + h - 1) >> 8, (y + h - 1) & 0xFF);
+        queueCommand(DMA_CMD_RAMWR);
+        
+        // Stream rows in chunks, packing as many pixels per chunk as fit
+        uint32_t total = (uint32_t)w * h;
+        uint32_t sent = 0;
+        int row = 0, col = 0;
+        while (sent < total) {
+            uint32_t count = min((uint32_t)DMA_CHUNK_PIXELS, total - sent);
+            uint16_t* dst = claimChunk();
+            
+            // Byte-swap to the panel's big-endian order while copying
+            const uint16_t* src = buffer + row * stride + col;
+            for (uint32_t i = 0; i < count; i++) {
+                uint16_t color = *src++;
+                dst[i] = (color << 8) | (color >> 8);
+                if (++col == w) {
+                    col = 0;
+                    row++;
+                    src = buffer + row * stride;
+                }
+            }
+            
+            sent += count;
+            queueChunk(dst, count, sent == total);
+        }
+    }
+    
+    /**
+     * Check if transfers are still in flight
+     */
+    bool isBusy() {
+        reclaim(false);
+        return pending > 0;
+    }
+    
+    /**
+     * Block until all queued transfers are complete
+     */
+    void waitIdle() {
+        while (pending > 0) {
+            reclaim(true);
+        }
+    }
+
+private:
+    spi_device_handle_t device;
+    bool active;
+    
+    // Transaction ring (results come back in queue order)
+    spi_transaction_t slots[DMA_QUEUE_SIZE];
+    int next_slot;
+    int pending;
+    uint32_t queued_seq;
+    uint32_t done_seq;
+    
+    // Double-buffered pixel chunks
+    uint16_t* chunk[2];
+    uint32_t chunk_seq[2];
+    int next_chunk;
+    
+    CompletionCallback on_complete;
+    void* on_complete_arg;
+    
+    inline static DmaFlusher* instance = nullptr;   // Active flusher, for the transfer ISR
+    
+    /**
+     * Set D/C line before each transfer
+     */
+    static void IRAM_ATTR preTransfer(spi_transaction_t* t) {
+        gpio_set_level((gpio_num_t)TFT_DC, ((uintptr_t)t->user & DMA_USER_DC) ? 1 : 0);
+    }
+    
+    /**
+     * Fire completion callback after the last chunk of a rectangle
+     */
+    static void IRAM_ATTR postTransfer(spi_transaction_t* t) {
+        if (((uintptr_t)t->user & DMA_USER_LAST) && instance && instance->on_complete) {
+            instance->on_complete(instance->on_complete_arg);
+        }
+    }
+    
+    /**
+     * Collect finished transactions
+     * With block=false only already finished transfers are collected
+     */
+    void reclaim(bool block) {
+        while (pending > 0) {
+            spi_transaction_t* done;
+            if (spi_device_get_trans_result(device, &done, block ? portMAX_DELAY : 0) != ESP_OK) {
+                return;
+            }
+            pending--;
+            done_seq++;
+            if (block) return;
+        }
+    }
+    
+    /**
+     * Get a free transaction slot, waiting for the oldest one if needed
+     */
+    spi_transaction_t* claimSlot() {
+        while (pending >= DMA_QUEUE_SIZE) {
+            reclaim(true);
+        }
+        spi_transaction_t* t = &slots[next_slot];
+        next_slot = (next_slot + 1) % DMA_QUEUE_SIZE;
+        memset(t, 0, sizeof(*t));
+        return t;
+    }
+    
+    /**
+     * Get a free bounce buffer, waiting for its previous transfer if needed
+     */
+    uint16_t* claimChunk() {
+        while (done_seq < chunk_seq[next_chunk]) {
+            reclaim(true);
+        }
+        return chunk[next_chunk];
+    }
+    
+    void submit(spi_transaction_t* t) {
+        spi_device_queue_trans(device, t, portMAX_DELAY);
+        pending++;
+        queued_seq++;
+    }
+    
+    void queueCommand(uint8_t cmd) {
+        spi_transaction_t* t = claimSlot();
+        t->flags = SPI_TRANS_USE_TXDATA;
+        t->length = 8;
+        t->tx_data[0] = cmd;
+        t->user = (void*)0;
+        submit(t);
+    }
+    
+    void queueData4(uint8_t b0, uint8_t b1, uint8_t b2, uint8_t b3) {
+        spi_transaction_t* t = claimSlot();
+        t->flags = SPI_TRANS_USE_TXDATA;
+        t->length = 32;
+        t->tx_data[0] = b0;
+        t->tx_data[1] = b1;
+        t->tx_data[2] = b2;
+        t->tx_data[3] = b3;
+        t->user = (void*)DMA_USER_DC;
+        submit(t);
+    }
+    
+    void queueChunk(uint16_t* data, uint32_t count, bool last) {
+        spi_transaction_t* t = claimSlot();
+        t->length = count * 16;
+        t->tx_buffer = data;
+        t->user = (void*)(uintptr_t)(DMA_USER_DC | (last ? DMA_USER_LAST : 0));
+        submit(t);
+        
+        chunk_seq[next_chunk] = queued_seq;
+        next_chunk ^= 1;
+    }
+};
+
+#endif // DMA_FLUSHER_H
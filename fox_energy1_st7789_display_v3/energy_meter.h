@@ -0,0 +1,183 @@
+/*
+ * Energy Meter
+ * Integrates power samples into daily/monthly kWh with NVS checkpoints
+ */
+
+#ifndef ENERGY_METER_H
+#define ENERGY_METER_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <time.h>
+#include "config.h"
+
+#define ENERGY_NVS_KEY        "energy"
+#define ENERGY_NVS_VERSION    1
+
+/**
+ * Persisted totals (written as one blob to keep NVS writes minimal)
+ */
+struct EnergyCheckpoint {
+    uint32_t version;
+    int32_t day_id;       // YYYYMMDD of day_wh, 0 if unknown
+    int32_t month_id;     // YYYYMM of month_wh, 0 if unknown
+    double day_wh;
+    double month_wh;
+};
+
+/**
+ * Trapezoidal integrator over timestamped power samples.
+ * Intervals longer than ENERGY_MAX_GAP_MS are not integrated, so an
+ * outage never turns into a phantom plateau. Totals are checkpointed
+ * every ENERGY_CHECKPOINT_INTERVAL_MS (or sooner after a large delta)
+ * and on day/month rollover - a few writes per hour keeps NVS wear far
+ * below the flash endurance over years of 1 Hz sampling.
+ */
+class EnergyMeter {
+public:
+    EnergyMeter() :
+        prefs(nullptr),
+        have_prev(false),
+        prev_power(0),
+        prev_time(0),
+        saved_wh(0),
+        last_checkpoint(0),
+        gap_count(0) {
+        memset(&totals, 0, sizeof(totals));
+        totals.version = ENERGY_NVS_VERSION;
+    }
+    
+    /**
+     * Restore the last checkpoint
+     * prefs must stay open for the lifetime of the meter (may be nullptr)
+     */
+    void begin(Preferences* preferences) {
+        prefs = preferences;
+        last_checkpoint = millis();
+        
+        if (!prefs) {
+            Serial.println("Energy meter: no NVS, totals will not persist");
+            return;
+        }
+        
+        EnergyCheckpoint stored;
+        if (prefs->getBytes(ENERGY_NVS_KEY, &stored, sizeof(stored)) == sizeof(stored) &&
+            stored.version == ENERGY_NVS_VERSION) {
+            totals = stored;
+            Serial.printf("Energy restored: today %.3f kWh, month %.3f kWh\n",
+                         totals.day_wh / 1000.0, totals.month_wh / 1000.0);
+        } else {
+            Serial.println("No energy checkpoint, starting from zero");
+        }
+        saved_wh = totals.month_wh;
+    }
+    
+    /**
+     * Integrate one valid sample (sample_ms from millis())
+     */
+    void addSample(float power_w, unsigned long sample_ms) {
+        if (have_prev) {
+            unsigned long dt = sample_ms - prev_time;
+            if (dt == 0) return;
+            
+            if (dt <= ENERGY_MAX_GAP_MS) {
+                double wh = (prev_power + power_w) * 0.5 * dt / 3600000.0;
+                totals.day_wh += wh;
+                totals.month_wh += wh;
+            } else {
+                gap_count++;
+                Serial.printf("Energy: skipped %lu ms gap\n", dt);
+            }
+        }
+        
+        prev_power = power_w;
+        prev_time = sample_ms;
+        have_prev = true;
+    }
+    
+    /**
+     * Handle rollover and checkpoint policy (call about once per second)
+     * local is nullptr while the wall clock is not synchronized
+     */
+    void update(const struct tm* local, unsigned long now_ms) {
+        if (local) {
+            int32_t day_id = (local->tm_year + 1900) * 10000 + (local->tm_mon + 1) * 100 + local->tm_mday;
+            int32_t month_id = day_id / 100;
+            bool rolled = false;
+            
+            if (totals.month_id != month_id) {
+                if (totals.month_id != 0) {
+                    Serial.printf("Energy: month %ld closed at %.3f kWh\n",
+                                 (long)totals.month_id, totals.month_wh / 1000.0);
+                    totals.month_wh = 0;
+                    saved_wh = 0;
+                }
+                totals.month_id = month_id;
+                rolled = true;
+            }
+            
+            if (totals.day_id != day_id) {
+                if (totals.day_id != 0) {
+                    Serial.printf("Energy: day %ld closed at %.3f kWh\n",
+                                 (long)totals.day_id, totals.day_wh / 1000.0);
+                    totals.day_wh = 0;
+                }
+                totals.day_id = day_id;
+                rolled = true;
+            }
+            
+            if (rolled) {
+                checkpoint(now_ms);
+                return;
+            }
+        }
+        
+        double unsaved_wh = totals.month_wh - saved_wh;
+        bool interval_due = (now_ms - last_checkpoint >= ENERGY_CHECKPOINT_INTERVAL_MS) &&
+                            unsaved_wh >= ENERGY_CHECKPOINT_MIN_WH;
+        if (interval_due || unsaved_wh >= ENERGY_CHECKPOINT_DELTA_WH) {
+            checkpoint(now_ms);
+        }
+    }
+    
+    /**
+     * Write the totals to NVS now
+     */
+    void checkpoint(unsigned long now_ms) {
+        last_checkpoint = now_ms;
+        if (!prefs) return;
+        
+        if (prefs->putBytes(ENERGY_NVS_KEY, &totals, sizeof(totals)) == sizeof(totals)) {
+            saved_wh = totals.month_wh;
+        } else {
+            Serial.println("Energy checkpoint write failed");
+        }
+    }
+    
+    float getTodayKWh() {
+        return totals.day_wh / 1000.0;
+    }
+    
+    float getMonthKWh() {
+        return totals.month_wh / 1000.0;
+    }
+    
+    /**
+     * Number of intervals skipped because samples were too far apart
+     */
+    uint32_t getGapCount() {
+        return gap_count;
+    }
+
+private:
+    Preferences* prefs;
+    EnergyCheckpoint totals;
+    bool have_prev;
+    float prev_power;
+    unsigned long prev_time;
+    double saved_wh;              // month_wh at the last checkpoint
+    unsigned long last_checkpoint;
+    uint32_t gap_count;
+};
+
+#endif // ENERGY_METER_H
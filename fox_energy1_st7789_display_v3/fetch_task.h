@@ -0,0 +1,235 @@
+/*
+ * Background Fetch Task
+ * Runs DataFetcher in its own FreeRTOS task and publishes samples
+ * through a lock-free ring, so network latency never stalls rendering.
+ * Polls over HTTP or listens for pushed datagrams (DATA_TRANSPORT).
+ */
+
+#ifndef FETCH_TASK_H
+#define FETCH_TASK_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <atomic>
+#include "config.h"
+#include "types.h"
+#include "data_fetcher.h"
+#include "wifi_manager.h"
+#include "sample_queue.h"
+
+class FetchTask {
+public:
+    FetchTask() :
+        fetcher(nullptr),
+        wifi(nullptr),
+        url(nullptr),
+        task(nullptr),
+        consumer(nullptr),
+        interval_ms(LOOP_DELAY_MS),
+        reset_failures(false),
+        busy(false),
+        next_fetch_at(0) {}
+    
+    /**
+     * Start the fetch task
+     * Call from the UI task: it is woken whenever a sample is published.
+     * The fetcher must only be used by the fetch task afterwards.
+     */
+    bool begin(DataFetcher* data_fetcher, WiFiManager* wifi_manager, const char* data_url) {
+        fetcher = data_fetcher;
+        wifi = wifi_manager;
+        url = data_url;
+        consumer = xTaskGetCurrentTaskHandle();
+        
+        BaseType_t result = xTaskCreate(taskEntry, "fetch", FETCH_TASK_STACK,
+                                        this, FETCH_TASK_PRIORITY, &task);
+        if (result != pdPASS) {
+            Serial.println("Failed to start fetch task");
+            task = nullptr;
+            return false;
+        }
+        
+        Serial.println("Fetch task started");
+        return true;
+    }
+    
+    /**
+     * Take the next sample (UI side)
+     * Returns false if no new sample arrived
+     */
+    bool poll(PowerSample& sample) {
+        return samples.pop(sample);
+    }
+    
+    /**
+     * Sleep until a sample is published or the timeout expires (UI side)
+     */
+    void waitForSample(uint32_t timeout_ms) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeout_ms));
+    }
+    
+    /**
+     * True if a published sample has not been taken yet (UI side)
+     */
+    bool hasSample() {
+        return !samples.isEmpty();
+    }
+    
+    /**
+     * True while a request is in flight (or the task is about to start one)
+     */
+    bool isBusy() {
+        return busy.load(std::memory_order_relaxed);
+    }
+    
+    /**
+     * Time until the next poll is due; 0 when due, busy or listening for pushes
+     */
+    uint32_t msUntilNextFetch() {
+        if (DATA_TRANSPORT != TRANSPORT_HTTP_POLL || isBusy()) return 0;
+        long remaining = (long)(next_fetch_at.load(std::memory_order_relaxed) - millis());
+        return remaining > 0 ? (uint32_t)remaining : 0;
+    }
+    
+    /**
+     * Change the poll interval (takes effect after the current wait)
+     */
+    void setInterval(uint32_t ms) {
+        interval_ms.store(ms, std::memory_order_relaxed);
+    }
+    
+    uint32_t getInterval() {
+        return interval_ms.load(std::memory_order_relaxed);
+    }
+    
+    /**
+     * Number of samples dropped because the UI did not keep up
+     */
+    uint32_t getDroppedSamples() {
+        return samples.getDropped();
+    }
+    
+    /**
+     * Cut the current wait short, e.g. right after a WiFi reconnect
+     */
+    void wake() {
+        if (task) xTaskNotifyGive(task);
+    }
+    
+    /**
+     * Ask the task to reset the fetcher's failure counter before its next fetch
+     */
+    void resetFailures() {
+        reset_failures.store(true, std::memory_order_relaxed);
+    }
+    
+    TaskHandle_t getTaskHandle() {
+        return task;
+    }
+
+private:
+    DataFetcher* fetcher;
+    WiFiManager* wifi;
+    const char* url;
+    TaskHandle_t task;
+    TaskHandle_t consumer;
+    std::atomic<uint32_t> interval_ms;
+    std::atomic<bool> reset_failures;
+    std::atomic<bool> busy;
+    std::atomic<unsigned long> next_fetch_at;   // millis() of the next poll
+    SpscRing<PowerSample, SAMPLE_QUEUE_SIZE> samples;
+    
+    static void taskEntry(void* arg) {
+        static_cast<FetchTask*>(arg)->run();
+    }
+    
+    void run() {
+        if (DATA_TRANSPORT == TRANSPORT_UDP_PUSH) {
+            runPush();
+        } else {
+            runPoll();
+        }
+    }
+    
+    /**
+     * Hand a sample to the UI and wake it up
+     */
+    void publish(PowerSample& sample) {
+        sample.fetch_time = sample.valid ? fetcher->getLastFetchTime() : millis();
+        if (sample.valid) sample.timing = fetcher->getLastTiming();
+        sample.consecutive_failures = fetcher->getConsecutiveFailures();
+        samples.push(sample);
+        xTaskNotifyGive(consumer);
+    }
+    
+    void applyFailureReset() {
+        if (reset_failures.exchange(false, std::memory_order_relaxed)) {
+            fetcher->resetFailures();
+        }
+    }
+    
+    /**
+     * Poll loop - one request per interval while WiFi is up
+     */
+    void runPoll() {
+        for (;;) {
+            busy.store(true, std::memory_order_relaxed);
+            unsigned long start = millis();
+            applyFailureReset();
+            
+            if (wifi->isConnected()) {
+                PowerSample sample;
+                sample.valid = fetcher->fetchPowerData(url, sample.data);
+                publish(sample);
+            }
+            
+            // Keep a steady cadence; never burst to catch up after a slow request
+            unsigned long elapsed = millis() - start;
+            uint32_t interval = getInterval();
+            uint32_t wait = (elapsed < interval) ? (interval - elapsed) : 1;
+            next_fetch_at.store(millis() + wait, std::memory_order_relaxed);
+            busy.store(false, std::memory_order_relaxed);
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait)); // wake() ends it early
+        }
+    }
+    
+    /**
+     * Push loop - publish every datagram as soon as it lands
+     */
+    void runPush() {
+        bool listening = false;
+        
+        for (;;) {
+            applyFailureReset();
+            
+            if (!wifi->isConnected()) {
+                listening = false;
+                ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(500));
+                continue;
+            }
+            
+            // (Re)bind after boot and after every WiFi reconnect
+            if (!listening) {
+                listening = fetcher->beginPush(UDP_LISTEN_PORT);
+                if (!listening) {
+                    vTaskDelay(pdMS_TO_TICKS(1000));
+                    continue;
+                }
+            }
+            
+            PowerSample sample;
+            PushResult result = fetcher->receivePush(sample.data);
+            if (result == PUSH_NONE) {
+                vTaskDelay(pdMS_TO_TICKS(UDP_POLL_MS));
+                continue;
+            }
+            
+            // Drain back-to-back datagrams without sleeping
+            sample.valid = (result == PUSH_SAMPLE);
+            publish(sample);
+        }
+    }
+};
+
+#endif // FETCH_TASK_H
@@ -0,0 +1,250 @@
+/*
+ * Firmware Statistics
+ * Hot-path latency histograms and counters exported on /metrics
+ */
+
+#ifndef FIRMWARE_STATS_H
+#define FIRMWARE_STATS_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include "config.h"
+
+#define HISTOGRAM_MAX_BUCKETS  12   // Finite bucket bounds per histogram
+#define LATENCY_WINDOW_SIZE    64   // Newest samples kept per sliding-window percentile
+
+/**
+ * Fixed-bucket latency histogram (Prometheus style, microsecond input)
+ * Written by one task and read by the metrics task; a short critical
+ * section keeps the 64-bit sum and the buckets consistent.
+ */
+class LatencyHistogram {
+public:
+    struct Snapshot {
+        uint32_t buckets[HISTOGRAM_MAX_BUCKETS + 1];  // Last one is +Inf
+        uint32_t count;
+        uint64_t sum_us;
+    };
+    
+    /**
+     * bounds_us: ascending upper bounds, must outlive the histogram
+     */
+    LatencyHistogram(const uint32_t* bounds_us, uint8_t bound_count) :
+        bounds(bounds_us),
+        bound_count(min(bound_count, (uint8_t)HISTOGRAM_MAX_BUCKETS)),
+        count(0),
+        sum_us(0) {
+        memset(buckets, 0, sizeof(buckets));
+        mux = portMUX_INITIALIZER_UNLOCKED;
+    }
+    
+    void record(uint32_t us) {
+        uint8_t i = 0;
+        while (i < bound_count && us > bounds[i]) i++;
+        
+        portENTER_CRITICAL(&mux);
+        buckets[i]++;
+        count++;
+        sum_us += us;
+        portEXIT_CRITICAL(&mux);
+    }
+    
+    /**
+     * Copy the counters (non-cumulative buckets)
+     */
+    void snapshot(Snapshot& out) const {
+        portENTER_CRITICAL(&mux);
+        memcpy(out.buckets, buckets, sizeof(buckets));
+        out.count = count;
+        out.sum_us = sum_us;
+        portEXIT_CRITICAL(&mux);
+    }
+    
+    uint8_t getBoundCount() const {
+        return bound_count;
+    }
+    
+    uint32_t getBound(uint8_t i) const {
+        return bounds[i];
+    }
+
+private:
+    const uint32_t* bounds;
+    uint8_t bound_count;
+    uint32_t buckets[HISTOGRAM_MAX_BUCKETS + 1];
+    uint32_t count;
+    uint64_t sum_us;
+    mutable portMUX_TYPE mux;
+};
+
+/**
+ * Sliding window of the newest LATENCY_WINDOW_SIZE latencies
+ * Percentiles over recent samples, where a histogram only knows the
+ * whole uptime. Written by one task and read by the metrics task.
+ */
+class LatencyWindow {
+public:
+    LatencyWindow() :
+        head(0),
+        count(0) {
+        memset(samples, 0, sizeof(samples));
+        mux = portMUX_INITIALIZER_UNLOCKED;
+    }
+    
+    void record(uint32_t us) {
+        portENTER_CRITICAL(&mux);
+        samples[head] = us;
+        head = (head + 1) % LATENCY_WINDOW_SIZE;
+        if (count < LATENCY_WINDOW_SIZE) count++;
+        portEXIT_CRITICAL(&mux);
+    }
+    
+    /**
+     * Nearest-rank percentiles (quantiles in 0..1) of the window into out
+     * Returns the number of samples they are based on; out is untouched if 0
+     */
+    uint8_t percentiles(const float* quantiles, uint8_t n, uint32_t* out) const {
+        uint32_t sorted[LATENCY_WINDOW_SIZE];
+        
+        // Until the window fills, the samples are the first count entries
+        portENTER_CRITICAL(&mux);
+        uint8_t len = count;
+        memcpy(sorted, samples, len * sizeof(sorted[0]));
+        portEXIT_CRITICAL(&mux);
+        if (len == 0) return 0;
+        
+        // Insertion sort: small window, outside the critical section
+        for (uint8_t i = 1; i < len; i++) {
+            uint32_t v = sorted[i];
+            uint8_t j = i;
+            while (j > 0 && sorted[j - 1] > v) {
+                sorted[j] = sorted[j - 1];
+                j--;
+            }
+            sorted[j] = v;
+        }
+        
+        for (uint8_t i = 0; i < n; i++) {
+            int rank = (int)ceilf(quantiles[i] * len);
+            out[i] = sorted[constrain(rank, 1, (int)len) - 1];
+        }
+        return len;
+    }
+
+private:
+    uint32_t samples[LATENCY_WINDOW_SIZE];
+    uint8_t head;                       // Next slot to overwrite
+    uint8_t count;
+    mutable portMUX_TYPE mux;
+};
+
+// Network phases: 1 ms .. 4 s (HTTP_TIMEOUT_MS)
+static const uint32_t FETCH_BOUNDS_US[] = {
+    1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000, 4000000
+};
+
+// Band rendering and SPI flush: 0.5 ms .. 200 ms
+static const uint32_t RENDER_BOUNDS_US[] = {
+    500, 1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000
+};
+
+#define FETCH_BOUND_COUNT   (sizeof(FETCH_BOUNDS_US) / sizeof(FETCH_BOUNDS_US[0]))
+#define RENDER_BOUND_COUNT  (sizeof(RENDER_BOUNDS_US) / sizeof(RENDER_BOUNDS_US[0]))
+
+enum FetchPhase {
+    FETCH_CONNECT,      // TCP connect (new connections only)
+    FETCH_TTFB,         // Request sent until response headers parsed
+    FETCH_PARSE,        // Body read and parsed
+    FETCH_PHASE_COUNT
+};
+
+enum RenderTarget {
+    RENDER_STATUS,      // drawStatusBar
+    RENDER_MAIN,        // drawMainDisplay
+    RENDER_GRAPH,       // addGraphSample
+    RENDER_TARGET_COUNT
+};
+
+/**
+ * Sample pipeline stages, from the request to the pixels on the panel
+ */
+enum PipelineStage {
+    STAGE_REQUEST,      // Request started until response headers (HTTP only)
+    STAGE_PARSE,        // Body read, parsed and validated
+    STAGE_QUEUE,        // Waiting for the UI loop to take it
+    STAGE_RENDER,       // Taken until rasterised into the bands
+    STAGE_FLUSH,        // Rasterised until the DMA flush completed
+    STAGE_TOTAL,        // Request started until on the panel
+    PIPELINE_STAGE_COUNT
+};
+
+/**
+ * Everything /metrics reports besides the readings themselves
+ * Components record through a pointer set with setStats(); counters have
+ * a single writer each, so plain 32-bit fields are enough.
+ */
+struct FirmwareStats {
+    LatencyHistogram fetch[FETCH_PHASE_COUNT] = {
+        {FETCH_BOUNDS_US, FETCH_BOUND_COUNT},
+        {FETCH_BOUNDS_US, FETCH_BOUND_COUNT},
+        {FETCH_BOUNDS_US, FETCH_BOUND_COUNT}
+    };
+    LatencyHistogram render[RENDER_TARGET_COUNT] = {
+        {RENDER_BOUNDS_US, RENDER_BOUND_COUNT},
+        {RENDER_BOUNDS_US, RENDER_BOUND_COUNT},
+        {RENDER_BOUNDS_US, RENDER_BOUND_COUNT}
+    };
+    LatencyHistogram flush = {RENDER_BOUNDS_US, RENDER_BOUND_COUNT};  // Per render pass
+    
+    uint32_t fetch_failures = 0;          // Failed fetches since boot
+    int32_t consecutive_failures = 0;     // As of the newest sample
+    uint32_t wifi_reconnect_attempts = 0;
+    uint32_t wifi_reconnects = 0;         // Successful reconnections
+    uint32_t loop_overruns = 0;           // Frames longer than UI_FRAME_INTERVAL_MS
+    uint32_t samples_dropped = 0;         // Fetch task queue overflows
+    
+    // SamplePipeline, newest drawn samples
+    LatencyWindow pipeline[PIPELINE_STAGE_COUNT];
+    uint32_t last_sample_ms = 0;          // millis() of the newest valid sample, 0 = none yet
+    
+    // PowerManager
+    uint32_t light_sleeps = 0;
+    uint32_t light_sleep_ms = 0;          // Total time in light sleep
+    uint8_t backlight_level = 255;        // 0..255
+    float current_estimate_ma = 0;        // Modelled average draw since boot
+    
+    // MeterSet, one entry per meter in METER_URLS
+    uint8_t meter_count = 1;
+    float meter_power_w[METER_MAX] = {};
+    uint32_t meter_sample_ms[METER_MAX] = {};   // millis() of the last valid sample, 0 = none yet
+    int32_t meter_failures[METER_MAX] = {};     // Consecutive
+    
+    // HealthMonitor, refreshed every HEALTH_SAMPLE_MS
+    uint32_t heap_largest_block_min = 0;        // Smallest largest-free-block seen
+    uint32_t heap_allocated_blocks = 0;
+    uint32_t heap_free_blocks = 0;              // Free fragments
+    uint8_t heap_growth_windows = 0;            // Leak-check windows in a row with more live blocks
+    uint8_t task_count = 0;
+    char task_names[HEALTH_MAX_TASKS][12] = {};
+    uint32_t task_stack_free[HEALTH_MAX_TASKS] = {};  // High-water mark: least unused stack in bytes
+    
+    // TelemetryUplink
+    uint32_t telemetry_batches_sent = 0;
+    uint32_t telemetry_send_failures = 0;
+    uint32_t telemetry_records_dropped = 0;     // Overwritten before they could be sent
+    uint16_t telemetry_backlog = 0;             // Records waiting to be sent
+};
+
+static const char* const FETCH_PHASE_NAMES[FETCH_PHASE_COUNT] = {
+    "connect", "ttfb", "parse"
+};
+
+static const char* const RENDER_TARGET_NAMES[RENDER_TARGET_COUNT] = {
+    "status", "main", "graph"
+};
+
+static const char* const PIPELINE_STAGE_NAMES[PIPELINE_STAGE_COUNT] = {
+    "request", "parse", "queue", "render", "flush", "total"
+};
+
+#endif // FIRMWARE_STATS_H
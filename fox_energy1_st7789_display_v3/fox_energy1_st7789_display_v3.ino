@@ -23,6 +23,21 @@
 #include "wifi_manager.h"
 #include "display_manager.h"
 #include "data_fetcher.h"
+#include "fetch_task.h"
+#include "meter_set.h"
+#include "power_history.h"
+#include "value_filter.h"
+#include "energy_meter.h"
+#include "reading_cache.h"
+#include "metrics_server.h"
+#include "firmware_stats.h"
+#include "power_manager.h"
+#include "health_monitor.h"
+#include "telemetry_uplink.h"
+#include "sample_pipeline.h"
+#include "buffer_arena.h"
+#include "profiler.h"
+#include "benchmark.h"
 
 // =========================================================================
 // ===                      GLOBAL MANAGER INSTANCES                     ===
@@ -30,17 +45,36 @@
 
 WiFiManager wifiMgr;
 DisplayManager displayMgr;
-DataFetcher dataFetcher;
+MeterSet meters;
+PowerHistory powerHistory;
+EnergyMeter energyMeter;
+ReadingCache readingCache;
+MetricsServer metricsServer;
+FirmwareStats firmwareStats;
+PowerManager powerMgr;
+HealthMonitor healthMonitor;
+TelemetryUplink telemetry;
+SamplePipeline samplePipeline;
+DisplayFilter displayFilter;
 
 // =========================================================================
 // ===                      GLOBAL STATE VARIABLES                       ===
 // =========================================================================
 
 PowerData currentPower;
+PowerData shownPower;       // currentPower smoothed for the dashboard
 StatusData currentStatus;
-unsigned long last_data_fetch = 0;
-unsigned long last_time_update = 0;
-bool first_loop = true;
+time_t last_clock_second = 0;
+bool force_main_redraw = true;
+bool have_power_data = false;
+unsigned long last_sample_time = 0;   // millis() of the newest valid sample
+WiFiState wifi_state = WIFI_DISCONNECTED;
+
+// Adaptive poll scheduler state
+uint32_t poll_interval = LOOP_DELAY_MS;
+float last_sample_power = 0;
+bool have_last_sample = false;
+uint8_t steady_samples = 0;
 
 // =========================================================================
 // ===                        HELPER FUNCTIONS                           ===
@@ -48,39 +82,96 @@ bool first_loop = true;
 
 /**
  * Update time from NTP server
+ * Returns false while time is not synced
  */
-void updateTime() {
-    struct tm timeinfo;
-    if (!getLocalTime(&timeinfo)) {
-        currentStatus.hours = "--";
-        currentStatus.minutes = "--";
-        currentStatus.seconds = "--";
-        currentStatus.time_str = "--:--:--";
-        return;
+bool updateTime(struct tm& timeinfo) {
+    if (!getLocalTime(&timeinfo, 0)) { // Don't block the UI loop waiting for NTP
+        currentStatus.clearTime();
+        return false;
     }
     
-    char h_buffer[3], m_buffer[3], s_buffer[3], full_buffer[9];
+    currentStatus.setTime(timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
+    return true;
+}
+
+bool updateTime() {
+    struct tm timeinfo;
+    return updateTime(timeinfo);
+}
+
+/**
+ * Milliseconds until the wall clock reaches the next second
+ */
+uint32_t msUntilNextSecond() {
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return 1000 - tv.tv_usec / 1000;
+}
+
+/**
+ * Light sleep until the next clock tick or due fetch
+ * Only between frames with nothing in flight: no request running, no
+ * sample waiting, no DMA flush and WiFi up (the state machine needs its
+ * ticks while connecting). Returns false if the caller should wait awake.
+ */
+bool sleepUntilDue() {
+    if (!powerMgr.isLightSleepEnabled() || wifi_state != WIFI_CONNECTED) return false;
+    if (meters.isBusy() || meters.hasSample() || displayMgr.isFlushing() || telemetry.isBusy()) return false;
     
-    strftime(h_buffer, sizeof(h_buffer), "%H", &timeinfo);
-    strftime(m_buffer, sizeof(m_buffer), "%M", &timeinfo);
-    strftime(s_buffer, sizeof(s_buffer), "%S", &timeinfo);
-    strftime(full_buffer, sizeof(full_buffer), "%H:%M:%S", &timeinfo);
+    uint32_t idle_ms = min(msUntilNextSecond(), meters.msUntilNextFetch());
+    if (!powerMgr.lightSleep(idle_ms)) return false;
     
-    currentStatus.hours = String(h_buffer);
-    currentStatus.minutes = String(m_buffer);
-    currentStatus.seconds = String(s_buffer);
-    currentStatus.time_str = String(full_buffer);
+    // The fetch tasks' timeouts may not have advanced while asleep
+    if (meters.msUntilNextFetch() == 0) {
+        meters.wake();
+    }
+    return true;
 }
 
 /**
- * Initialize NTP time synchronization
+ * Pick the next poll interval from the latest sample
+ * Fast while the total power is moving, doubling towards POLL_IDLE_MS
+ * while it is flat, and exponential backoff for a meter that keeps failing
+ * total_power: the combined reading including this sample
  */
-void initializeNTP() {
-    configTime(GMT_OFFSET_SEC, DAYLIGHT_OFFSET_SEC, NTP_SERVER);
-    delay(1000); // Wait for time sync
-    updateTime();
-    Serial.print("Time synchronized: ");
-    Serial.println(currentStatus.time_str);
+void schedulePoll(const PowerSample& sample, float total_power) {
+    if (!ENABLE_ADAPTIVE_POLLING || DATA_TRANSPORT != TRANSPORT_HTTP_POLL) return;
+    
+    if (!sample.valid) {
+        // First failure retries at the normal rate, then back off; only
+        // the failing meter slows down
+        int shift = min(sample.consecutive_failures - 1, 5);
+        meters.backOff(sample.meter,
+                       min((uint32_t)LOOP_DELAY_MS << max(shift, 0), (uint32_t)POLL_FAILURE_MAX_MS));
+        have_last_sample = false;
+        return;
+    }
+    
+    uint32_t next = poll_interval;
+    
+    if (!have_last_sample) {
+        next = LOOP_DELAY_MS;
+    } else {
+        float delta = fabs(total_power - last_sample_power);
+        
+        if (delta > POWER_CHANGE_THRESHOLD * POLL_TRANSIENT_FACTOR) {
+            next = POLL_FAST_MS;
+            steady_samples = 0;
+        } else if (++steady_samples >= POLL_STEADY_SAMPLES) {
+            next = min(poll_interval * 2, (uint32_t)POLL_IDLE_MS);
+            steady_samples = 0;
+        }
+    }
+    
+    last_sample_power = total_power;
+    have_last_sample = true;
+    
+    if (next != poll_interval) {
+        Serial.printf("Poll interval: %lu -> %lu ms\n",
+                     (unsigned long)poll_interval, (unsigned long)next);
+        poll_interval = next;
+        meters.setInterval(poll_interval);
+    }
 }
 
 // =========================================================================
@@ -94,55 +185,99 @@ void setup() {
     Serial.println("Refactored with modular architecture");
     Serial.println("========================================\n");
     
+    // Hot-path timings and counters for /metrics
+    displayMgr.setStats(&firmwareStats);
+    meters.setStats(&firmwareStats);
+    wifiMgr.setStats(&firmwareStats);
+    powerMgr.setStats(&firmwareStats);
+    healthMonitor.setStats(&firmwareStats);
+    samplePipeline.setStats(&firmwareStats);
+    
     // Initialize display first
     displayMgr.begin();
-    displayMgr.drawStartupAnimation();
+    displayMgr.setMeterCount(meters.count());
+    displayMgr.setFlushCompleteCallback(SamplePipeline::onFlushComplete, &samplePipeline);
     
     // Initialize WiFi manager
     wifiMgr.begin();
     
-    // Attempt WiFi connection with infinite retry
-    Serial.println("Attempting WiFi connection...");
-    displayMgr.drawFullScreenMessage("Connecting WiFi...", 2, ST77XX_YELLOW);
+    // Backlight PWM; modem sleep and CPU clock on battery builds
+    powerMgr.begin();
     
-    while (!wifiMgr.connect()) {
-        Serial.println("WiFi connection failed! Retrying in 30 seconds...");
-        displayMgr.drawFullScreenMessage("WiFi Failed!\nRetrying in 30s...", 2, ST77XX_RED);
-        
-        // Countdown display
-        for (int i = 30; i > 0; i--) {
-            char msg[40];
-            snprintf(msg, sizeof(msg), "WiFi Failed!\nRetry in %ds...", i);
-            displayMgr.drawFullScreenMessage(msg, 2, ST77XX_RED);
-            delay(1000);
-        }
-        
-        Serial.println("Retrying WiFi connection...");
-        displayMgr.drawFullScreenMessage("Connecting WiFi...", 2, ST77XX_YELLOW);
+    // Restore energy totals and the last reading (share the WiFi manager's NVS handle)
+    energyMeter.begin(wifiMgr.getPreferences());
+    readingCache.begin(wifiMgr.getPreferences());
+    
+    // Fast boot: a unit that has shown readings before skips the animation
+    PowerData cached_power;
+    bool fast_boot = ENABLE_FAST_BOOT && readingCache.restore(cached_power);
+    if (!fast_boot) {
+        displayMgr.drawStartupAnimation();
     }
     
-    // Initialize current status
+    // Initialize current status; the clock shows at once if the RTC kept
+    // time (light sleep, software resets), otherwise after NTP
     currentStatus.internal_temp = temperatureRead();
-    currentStatus.rssi = wifiMgr.getRSSI();
+    currentStatus.rssi = -100;
+    currentStatus.energy_today = energyMeter.getTodayKWh();
+    currentStatus.energy_month = energyMeter.getMonthKWh();
+    updateTime();
+    
+    // Draw initial UI (readings stay gray until the first fresh sample)
+    displayMgr.setStale(true);
+    displayMgr.drawInitialUI(currentStatus, fast_boot ? cached_power : PowerData());
+    force_main_redraw = true;
+    Serial.printf("Dashboard up %lu ms after reset\n", millis());
     
-    // Initialize NTP
-    initializeNTP();
+    // Start connecting; loop() drives it, the dashboard runs meanwhile
+    wifiMgr.connect();
     
-    // Show connection success
     Serial.println("\n========================================");
     Serial.println("System Ready!");
     Serial.printf("WiFi SSID: %s\n", wifiMgr.getSSID().c_str());
-    Serial.printf("RSSI: %ld dBm\n", currentStatus.rssi);
     Serial.printf("Temperature: %.1f°C\n", currentStatus.internal_temp);
-    Serial.printf("Time: %s\n", currentStatus.time_str.c_str());
+    Serial.printf("History buffer: %u bytes\n", (unsigned)PowerHistory::memoryUsage());
+    BufferArena::printLayout();
     Serial.println("========================================\n");
     
-    displayMgr.drawFullScreenMessage("Connected!", 2, ST77XX_GREEN);
-    delay(1500);
+    // Development builds: regression baseline before the dashboard starts
+    if (ENABLE_BENCHMARK) {
+        // The fetch scenarios need the network, so only this mode waits for it
+        displayMgr.drawFullScreenMessage("Connecting WiFi...", 2, ST77XX_YELLOW);
+        while (wifiMgr.tick() != WIFI_CONNECTED) {
+            delay(10);
+        }
+        displayMgr.setStale(false); // Scenarios render in the normal colors
+        
+        Benchmark benchmark(&displayMgr, &meters.getFetcher(0));
+        benchmark.run(BENCHMARK_URL);
+        force_main_redraw = true;
+    }
+    
+    // Start background fetching, one task per meter (they own the fetchers from here on)
+    meters.begin(&wifiMgr);
+    
+    // Serve the local API so desktop clients don't poll the meter
+    powerHistory.begin();
+    if (ENABLE_METRICS_SERVER) {
+        metricsServer.begin(&powerHistory, &firmwareStats);
+    }
+    
+    // Diagnostics go out in batches from their own task
+    if (ENABLE_TELEMETRY) {
+        telemetry.begin(&wifiMgr, &firmwareStats);
+    }
     
-    // Draw initial UI
-    displayMgr.drawInitialUI();
-    first_loop = true;
+    // Stack headroom of every task this sketch runs
+    healthMonitor.addTask("loop", xTaskGetCurrentTaskHandle());
+    healthMonitor.addTask("metrics", metricsServer.getTaskHandle());
+    healthMonitor.addTask("telemetry", telemetry.getTaskHandle());
+    for (int i = 0; i < meters.count(); i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "fetch%u", (unsigned)(i + 1));
+        healthMonitor.addTask(name, meters.getTaskHandle(i));
+    }
+    healthMonitor.update(millis());
 }
 
 // =========================================================================
@@ -150,136 +285,203 @@ void setup() {
 // =========================================================================
 
 void loop() {
-    unsigned long current_time = millis();
-    bool force_redraw = first_loop;
+    unsigned long frame_start = millis();
+    
+    // The last drawn sample's record completes once its pixels are out
+    samplePipeline.update(displayMgr.isFlushing());
     
     // =====================================================================
-    // === TIME UPDATE (Every Second)                                   ===
+    // === TIME UPDATE (On every wall-clock second)                     ===
     // =====================================================================
     
-    if (current_time - last_time_update >= TIME_UPDATE_INTERVAL) {
-        if (wifiMgr.isConnected()) {
-            // Update status values
-            currentStatus.internal_temp = temperatureRead();
-            currentStatus.rssi = wifiMgr.getRSSI();
-            updateTime();
-            
-            // Update status bar
-            displayMgr.drawStatusBar(currentStatus, false);
-            
-            last_time_update = current_time;
+    // Follow the RTC instead of a millis() timer so no second is skipped
+    time_t now = time(nullptr);
+    if (now != last_clock_second) {
+        last_clock_second = now;
+        
+        // Update status values
+        currentStatus.internal_temp = temperatureRead();
+        currentStatus.rssi = wifiMgr.isConnected() ? wifiMgr.getRSSI() : -100;
+        struct tm timeinfo;
+        bool time_valid = updateTime(timeinfo);
+        
+        // Day/month rollover and batched NVS checkpoints
+        energyMeter.update(time_valid ? &timeinfo : nullptr, millis());
+        currentStatus.energy_today = energyMeter.getTodayKWh();
+        currentStatus.energy_month = energyMeter.getMonthKWh();
+        
+        // Backlight dimming and the current estimate
+        powerMgr.update(time_valid ? &timeinfo : nullptr, millis());
+        
+        // A reading that stopped updating is grayed out even with WiFi up;
+        // the status bar shows its age until the next valid sample
+        currentStatus.data_age_s = have_power_data ? (long)((millis() - last_sample_time) / 1000) : -1;
+        if (currentStatus.data_age_s >= DATA_STALE_MS / 1000 && !displayMgr.isStale()) {
+            Serial.printf("No valid sample for %ld s\n", currentStatus.data_age_s);
+            displayMgr.setStale(true);
+        }
+        
+        // Update status bar
+        displayMgr.drawStatusBar(currentStatus, false);
+        
+        // Heap fragmentation and stack high-water marks for /metrics
+        healthMonitor.update(millis());
+        
+        // Gray out meters that stopped reporting (several meters only)
+        meters.updateStaleness(millis());
+        displayMgr.drawMeters(meters.getReadings(), false);
+        
+        // Development builds: print the profiler window, refresh the overlay
+        if (PROFILE_REPORT(millis())) {
+            displayMgr.updateProfilerOverlay();
+            powerMgr.printReport();
+        }
+        
+        // One history sample and graph column per second (last reading holds)
+        if (have_power_data) {
+            powerHistory.tick(currentPower, now);
+            displayMgr.addGraphSample(currentPower.power_active);
         }
     }
     
     // =====================================================================
-    // === DATA FETCH (Every LOOP_DELAY_MS)                             ===
+    // === POWER SAMPLES (Published by the fetch task)                  ===
     // =====================================================================
     
-    bool should_fetch = (current_time - last_data_fetch >= LOOP_DELAY_MS) || first_loop;
+    PowerSample sample;
+    bool have_data = false;
     
-    if (should_fetch) {
-        last_data_fetch = current_time;
+    while (meters.poll(sample)) {
+        // Dashboard values are the total over all meters
+        PowerData total;
+        meters.getTotal(total);
+        schedulePoll(sample, total.power_active);
+        firmwareStats.consecutive_failures = meters.getConsecutiveFailures();
         
-        // Check WiFi connection
-        if (!wifiMgr.isConnected()) {
-            // Handle disconnection
-            handleWiFiDisconnection();
-            force_redraw = true; // Redraw after reconnection
+        if (sample.valid) {
+            // A large step is worth a full-brightness backlight
+            if (have_power_data &&
+                fabs(total.power_active - currentPower.power_active) >= BACKLIGHT_ACTIVITY_W) {
+                powerMgr.noteActivity(millis());
+            }
+            
+            currentPower = total;
+            displayFilter.update(total, shownPower);
+            have_data = true;
+            have_power_data = true;
+            last_sample_time = sample.fetch_time;
+            firmwareStats.last_sample_ms = sample.fetch_time;
+            samplePipeline.taken(sample);
+            energyMeter.addSample(total.power_active, sample.fetch_time);
+            readingCache.update(total, millis());
+            metricsServer.publish(currentPower, energyMeter.getTodayKWh(), energyMeter.getMonthKWh());
+            
+            Serial.printf("[%s] V=%.1fV, C=%.2fA, P=%.1fW\n",
+                         currentStatus.time_str,
+                         currentPower.voltage,
+                         currentPower.current,
+                         currentPower.power_active);
         } else {
-            // Fetch power data
-            if (dataFetcher.fetchPowerData(DATA_URL, currentPower)) {
-                // Successfully fetched data
-                Serial.printf("[%s] V=%.1fV, C=%.2fA, P=%.1fW\n",
-                             currentStatus.time_str.c_str(),
-                             currentPower.voltage,
-                             currentPower.current,
-                             currentPower.power_active);
-                
-                // Update main display
-                displayMgr.drawMainDisplay(currentPower, force_redraw);
-                
-                // Status bar is updated in its own timer loop (lines 150-162)
-                // removing redundant call here to prevent flickering
-                
-            } else {
-                // Data fetch failed
-                Serial.printf("Data fetch failed (%d consecutive failures)\n",
-                             dataFetcher.getConsecutiveFailures());
-                
-                // Keep displaying last valid data
-                // Only show error if we have too many consecutive failures
-                if (dataFetcher.getConsecutiveFailures() >= 5) {
-                    Serial.println("WARNING: Multiple data fetch failures");
-                }
+            firmwareStats.fetch_failures++;
+            
+            // Keep displaying last valid data
+            Serial.printf("Data fetch failed (%d consecutive failures)\n",
+                         sample.consecutive_failures);
+            
+            if (sample.consecutive_failures >= 5) {
+                Serial.println("WARNING: Multiple data fetch failures");
+            }
+            
+            // Link up but nothing gets through: a reused lease may be the cause
+            if (sample.consecutive_failures == WIFI_LEASE_DROP_FAILURES && wifi_state == WIFI_CONNECTED) {
+                wifiMgr.dropCachedLease();
             }
         }
-        
-        first_loop = false;
+    }
+    
+    firmwareStats.samples_dropped = meters.getDroppedSamples();
+    
+    // Only the newest sample is drawn if several arrived within one frame;
+    // widgets whose text is unchanged are not redrawn
+    if (have_data) {
+        // A cached reading from before the reset stays gray until now
+        if (displayMgr.isStale() && wifi_state == WIFI_CONNECTED) {
+            displayMgr.setStale(false);
+        }
+        // Clear the age indicator now rather than on the next clock tick
+        if (currentStatus.data_age_s >= DATA_STALE_MS / 1000) {
+            currentStatus.data_age_s = 0;
+            displayMgr.drawStatusBar(currentStatus, false);
+        }
+        displayMgr.drawMainDisplay(shownPower, force_main_redraw);
+        displayMgr.drawMeters(meters.getReadings(), force_main_redraw);
+        force_main_redraw = false;
+        samplePipeline.rendered(displayMgr.isFlushing());
+    }
+    
+    // =====================================================================
+    // === WIFI STATE MACHINE                                           ===
+    // =====================================================================
+    
+    // Never blocks; rendering above keeps its cadence while the link is down
+    WiFiState previous_wifi_state = wifi_state;
+    wifi_state = wifiMgr.tick();
+    if (wifi_state != previous_wifi_state) {
+        handleWiFiStateChange(previous_wifi_state, wifi_state);
     }
     
     // =====================================================================
     // === LOOP TIMING                                                  ===
     // =====================================================================
     
-    // Dynamic delay to maintain consistent loop timing
-    unsigned long loop_duration = millis() - current_time;
-    if (loop_duration < 200) {
-        delay(200 - loop_duration);
+    // Fixed UI cadence, independent of network latency; a new sample
+    // wakes the loop early so it reaches the screen without waiting
+    unsigned long frame_duration = millis() - frame_start;
+    if (frame_duration < UI_FRAME_INTERVAL_MS) {
+        // Battery builds sleep through the gap if nothing is due before it ends
+        if (!sleepUntilDue()) {
+            meters.waitForSample(UI_FRAME_INTERVAL_MS - frame_duration);
+        }
     } else {
-        // Loop took longer than expected, give CPU a minimal break
-        delay(10);
+        // Frame took longer than expected, give CPU a minimal break
+        firmwareStats.loop_overruns++;
+        delay(1);
     }
 }
 
 // =========================================================================
-// ===                      WIFI DISCONNECTION HANDLER                   ===
+// ===                      WIFI STATE CHANGE HANDLER                    ===
 // =========================================================================
 
-void handleWiFiDisconnection() {
-    Serial.println("\n!!! WiFi Disconnected !!!");
-    Serial.println("Attempting reconnection...");
-    
-    // Update display to show disconnection
-    currentStatus.rssi = -100;
-    currentStatus.internal_temp = temperatureRead();
-    displayMgr.drawStatusBar(currentStatus, true);
-    
-    // Show reconnection message
-    displayMgr.drawFullScreenMessage("WiFi Lost!\nReconnecting...", 2, ST77XX_RED);
-    
-    // Attempt reconnection
-    if (wifiMgr.reconnect()) {
-        // Reconnection successful
-        Serial.println("WiFi reconnected successfully!");
-        
-        // Re-initialize NTP
-        initializeNTP();
+void handleWiFiStateChange(WiFiState previous, WiFiState current) {
+    if (current == WIFI_CONNECTED) {
+        // The clock kept running; (re-)sync in the background without waiting
+        configTime(GMT_OFFSET_SEC, DAYLIGHT_OFFSET_SEC, NTP_SERVER);
         
-        // Update status
         currentStatus.rssi = wifiMgr.getRSSI();
-        currentStatus.internal_temp = temperatureRead();
-        
-        Serial.printf("WiFi restored - RSSI: %ld dBm\n", currentStatus.rssi);
-        
-        // Show success message
-        displayMgr.drawFullScreenMessage("WiFi Reconnected!", 2, ST77XX_GREEN);
-        delay(1500);
+        displayMgr.drawStatusBar(currentStatus, false);
         
-        // Redraw UI
-        displayMgr.drawInitialUI();
-        
-        // Reset data fetcher failure counter
-        dataFetcher.resetFailures();
+        // Readings from this boot are current again if they are younger
+        // than DATA_STALE_MS; older ones and a cached one wait for the
+        // first fresh sample
+        if (have_power_data && millis() - last_sample_time < DATA_STALE_MS) {
+            displayMgr.setStale(false);
+        }
         
-    } else {
-        // Reconnection failed
-        Serial.println("Reconnection failed, will retry...");
+        Serial.printf("WiFi up - RSSI: %ld dBm\n", currentStatus.rssi);
         
-        // Show failure state
-        displayMgr.drawFullScreenMessage("Reconnecting...\nPlease wait", 2, ST77XX_ORANGE);
-        delay(2000);
+        // Reset data fetcher failure counter and fetch without waiting out the interval
+        meters.resetFailures();
+        meters.wake();
+        return;
+    }
+    
+    if (previous == WIFI_CONNECTED) {
+        Serial.println("\n!!! WiFi Disconnected !!!");
         
-        // Redraw UI to show disconnected state
-        displayMgr.drawInitialUI();
+        // Keep the dashboard; the last readings stay up, grayed out
+        currentStatus.rssi = -100;
+        displayMgr.drawStatusBar(currentStatus, false);
+        displayMgr.setStale(true);
     }
 }
@@ -0,0 +1,197 @@
+/*
+ * Glyph Cache for the classic 5x7 Adafruit GFX font
+ * Pre-rasterises display glyphs into rectangle spans for fast scaled blits
+ */
+
+#ifndef GLYPH_CACHE_H
+#define GLYPH_CACHE_H
+
+#include <Adafruit_GFX.h>
+#include "config.h"
+
+// Characters used by the dashboard (digits, separators, units, degree sign)
+#define GLYPH_CACHE_CHARSET   "0123456789.,-:WkVAhC\xF7"
+#define GLYPH_CACHE_MAX_RECTS 256      // Span pool shared by all glyphs
+#define GLYPH_NOT_CACHED      0xFF
+
+// Classic font cell: 5x7 glyph plus 1 column/row spacing
+#define GLYPH_CELL_WIDTH      6
+#define GLYPH_CELL_HEIGHT     8
+
+/**
+ * One filled rectangle of a glyph in font pixels (scaled at draw time)
+ */
+struct GlyphRect {
+    uint8_t x, y, w, h;
+};
+
+/**
+ * Glyph atlas built once at boot from the Adafruit GFX classic font.
+ * Each glyph is stored as horizontal runs merged vertically into
+ * rectangles, so a size-11 digit becomes a handful of fills instead of
+ * one fillRect per font pixel. Output is pixel-identical to print().
+ */
+class GlyphCache {
+public:
+    GlyphCache() : rect_count(0), ready(false) {
+        memset(lookup, GLYPH_NOT_CACHED, sizeof(lookup));
+    }
+    
+    /**
+     * Rasterise the charset once (call at boot)
+     */
+    void begin() {
+        GFXcanvas1 cell(GLYPH_CELL_WIDTH, GLYPH_CELL_HEIGHT);
+        const char* charset = GLYPH_CACHE_CHARSET;
+        uint8_t glyph_count = 0;
+        rect_count = 0;
+        
+        for (const char* p = charset; *p; p++) {
+            uint8_t c = (uint8_t)*p;
+            cell.fillScreen(0);
+            cell.drawChar(0, 0, c, 1, 0, 1);
+            
+            Glyph& g = glyphs[glyph_count];
+            g.first = rect_count;
+            g.count = 0;
+            
+            if (!extractRects(cell, g)) {
+                Serial.printf("Glyph cache full at '%c'\n", c);
+                break;
+            }
+            
+            lookup[c] = glyph_count++;
+        }
+        
+        ready = true;
+        Serial.printf("Glyph cache: %d glyphs, %d spans\n", glyph_count, rect_count);
+    }
+    
+    /**
+     * Pixel width of a string in the classic font (incl. trailing spacing)
+     */
+    static uint16_t textWidth(const char* text, uint8_t size) {
+        return strlen(text) * GLYPH_CELL_WIDTH * size;
+    }
+    
+    static uint16_t textHeight(uint8_t size) {
+        return GLYPH_CELL_HEIGHT * size;
+    }
+    
+    /**
+     * Draw string into any GFX target (transparent background)
+     */
+    void drawString(Adafruit_GFX* target, int16_t x, int16_t y, const char* text,
+                    uint8_t size, uint16_t color) {
+        int16_t target_h = target->height();
+        
+        for (const char* p = text; *p; p++, x += GLYPH_CELL_WIDTH * size) {
+            uint8_t c = (uint8_t)*p;
+            if (!ready || lookup[c] == GLYPH_NOT_CACHED) {
+                target->drawChar(x, y, c, color, color, size);
+                continue;
+            }
+            
+            const Glyph& g = glyphs[lookup[c]];
+            for (uint16_t i = 0; i < g.count; i++) {
+                const GlyphRect& r = rects[g.first + i];
+                int16_t ry = y + r.y * size;
+                int16_t rh = r.h * size;
+                if (ry >= target_h || ry + rh <= 0) continue;
+                target->fillRect(x + r.x * size, ry, r.w * size, rh, color);
+            }
+        }
+    }
+    
+    /**
+     * Draw string straight into a canvas buffer, clipped to the canvas
+     */
+    void drawString(GFXcanvas16* canvas, int16_t x, int16_t y, const char* text,
+                    uint8_t size, uint16_t color) {
+        uint16_t* buffer = canvas->getBuffer();
+        int16_t canvas_w = canvas->width();
+        int16_t canvas_h = canvas->height();
+        
+        for (const char* p = text; *p; p++, x += GLYPH_CELL_WIDTH * size) {
+            uint8_t c = (uint8_t)*p;
+            if (!ready || lookup[c] == GLYPH_NOT_CACHED) {
+                canvas->drawChar(x, y, c, color, color, size);
+                continue;
+            }
+            
+            const Glyph& g = glyphs[lookup[c]];
+            for (uint16_t i = 0; i < g.count; i++) {
+                const GlyphRect& r = rects[g.first + i];
+                
+                // Clip rectangle to the canvas
+                int16_t x0 = max((int)(x + r.x * size), 0);
+                int16_t x1 = min(x + (r.x + r.w) * size, (int)canvas_w);
+                int16_t y0 = max((int)(y + r.y * size), 0);
+                int16_t y1 = min(y + (r.y + r.h) * size, (int)canvas_h);
+                if (x0 >= x1 || y0 >= y1) continue;
+                
+                for (int16_t row = y0; row < y1; row++) {
+                    uint16_t* dst = buffer + row * canvas_w + x0;
+                    for (int16_t n = x1 - x0; n > 0; n--) {
+                        *dst++ = color;
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    struct Glyph {
+        uint16_t first;
+        uint16_t count;
+    };
+    
+    GlyphRect rects[GLYPH_CACHE_MAX_RECTS];
+    Glyph glyphs[sizeof(GLYPH_CACHE_CHARSET) - 1];
+    uint16_t rect_count;
+    uint8_t lookup[256];
+    bool ready;
+    
+    /**
+     * Convert a rendered 6x8 cell into merged rectangles
+     * Returns false if the span pool is exhausted
+     */
+    bool extractRects(const GFXcanvas1& cell, Glyph& g) {
+        for (uint8_t y = 0; y < GLYPH_CELL_HEIGHT; y++) {
+            uint8_t x = 0;
+            while (x < GLYPH_CELL_WIDTH) {
+                if (!cell.getPixel(x, y)) {
+                    x++;
+                    continue;
+                }
+                
+                uint8_t run_start = x;
+                while (x < GLYPH_CELL_WIDTH && cell.getPixel(x, y)) x++;
+                uint8_t run_w = x - run_start;
+                
+                // Extend a rectangle ending on the previous row with the same run
+                bool merged = false;
+                for (uint16_t i = g.first; i < g.first + g.count; i++) {
+                    GlyphRect& r = rects[i];
+                    if (r.x == run_start && r.w == run_w && r.y + r.h == y) {
+                        r.h++;
+                        merged = true;
+                        break;
+                    }
+                }
+                if (merged) continue;
+                
+                if (rect_count >= GLYPH_CACHE_MAX_RECTS) return false;
+                GlyphRect& r = rects[rect_count++];
+                r.x = run_start;
+                r.y = y;
+                r.w = run_w;
+                r.h = 1;
+                g.count++;
+            }
+        }
+        return true;
+    }
+};
+
+#endif // GLYPH_CACHE_H
@@ -0,0 +1,153 @@
+/*
+ * Health Monitor
+ * Periodic heap fragmentation and task stack high-water marks, published
+ * on /metrics so slow leaks and shrinking headroom show up before a
+ * device fails
+ */
+
+#ifndef HEALTH_MONITOR_H
+#define HEALTH_MONITOR_H
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "config.h"
+#include "firmware_stats.h"
+
+class HealthMonitor {
+public:
+    HealthMonitor() :
+        task_count(0),
+        last_sample(0),
+        sampled(false),
+        largest_block_min(UINT32_MAX),
+        block_warned(false),
+        window_min(UINT32_MAX),
+        window_samples(0),
+        prev_window_min(0),
+        growth_windows(0),
+        leak_warned(false),
+        stats(nullptr) {}
+    
+    /**
+     * Publish the samples (may be nullptr)
+     */
+    void setStats(FirmwareStats* firmware_stats) {
+        stats = firmware_stats;
+    }
+    
+    /**
+     * Watch a task's stack; name is copied (at most 11 characters)
+     * Returns false when HEALTH_MAX_TASKS are registered already
+     */
+    bool addTask(const char* name, TaskHandle_t handle) {
+        if (!handle || task_count >= HEALTH_MAX_TASKS) return false;
+        
+        Task& task = tasks[task_count++];
+        strncpy(task.name, name, sizeof(task.name) - 1);
+        task.name[sizeof(task.name) - 1] = '\0';
+        task.handle = handle;
+        task.warned = false;
+        return true;
+    }
+    
+    /**
+     * Sample every HEALTH_SAMPLE_MS (cheap to call more often)
+     */
+    void update(unsigned long now) {
+        if (sampled && now - last_sample < HEALTH_SAMPLE_MS) return;
+        sampled = true;
+        last_sample = now;
+        
+        multi_heap_info_t info;
+        heap_caps_get_info(&info, MALLOC_CAP_8BIT);
+        
+        if (info.largest_free_block < largest_block_min) {
+            largest_block_min = info.largest_free_block;
+        }
+        bool block_low = info.largest_free_block < HEALTH_LARGEST_BLOCK_WARN;
+        if (block_low && !block_warned) {
+            Serial.printf("WARNING: largest free heap block %u bytes (%u free in %u fragments)\n",
+                         (unsigned)info.largest_free_block, (unsigned)info.total_free_bytes,
+                         (unsigned)info.free_blocks);
+        }
+        block_warned = block_low;
+        
+        checkGrowth(info);
+        
+        for (uint8_t i = 0; i < task_count; i++) {
+            Task& task = tasks[i];
+            task.stack_free = uxTaskGetStackHighWaterMark(task.handle); // Bytes on ESP-IDF
+            if (task.stack_free < HEALTH_STACK_WARN_BYTES && !task.warned) {
+                Serial.printf("WARNING: task %s has %u bytes of stack left\n",
+                             task.name, (unsigned)task.stack_free);
+                task.warned = true;
+            }
+        }
+        
+        if (stats) {
+            stats->heap_largest_block_min = largest_block_min;
+            stats->heap_allocated_blocks = info.allocated_blocks;
+            stats->heap_free_blocks = info.free_blocks;
+            stats->heap_growth_windows = growth_windows;
+            for (uint8_t i = 0; i < task_count; i++) {
+                memcpy(stats->task_names[i], tasks[i].name, sizeof(tasks[i].name));
+                stats->task_stack_free[i] = tasks[i].stack_free;
+            }
+            stats->task_count = task_count;
+        }
+    }
+
+private:
+    struct Task {
+        char name[12];
+        TaskHandle_t handle;
+        uint32_t stack_free;
+        bool warned;
+    };
+    
+    Task tasks[HEALTH_MAX_TASKS];
+    uint8_t task_count;
+    unsigned long last_sample;
+    bool sampled;
+    uint32_t largest_block_min;
+    bool block_warned;
+    
+    // Leak check: fewest allocated blocks per window, against the previous window
+    uint32_t window_min;
+    uint8_t window_samples;
+    uint32_t prev_window_min;           // 0 until the first window closed
+    uint8_t growth_windows;
+    bool leak_warned;
+    FirmwareStats* stats;
+    
+    /**
+     * Short-lived allocations (HTTPClient's Strings per request, lwIP
+     * buffers) come and go between samples, so only the fewest live
+     * blocks in a window count; a floor that keeps rising is a leak
+     */
+    void checkGrowth(const multi_heap_info_t& info) {
+        window_min = min(window_min, (uint32_t)info.allocated_blocks);
+        if (++window_samples < HEALTH_LEAK_WINDOW_SAMPLES) return;
+        
+        if (prev_window_min != 0 && window_min > prev_window_min) {
+            if (growth_windows < UINT8_MAX) growth_windows++;
+        } else {
+            growth_windows = 0;
+        }
+        
+        bool leaking = growth_windows >= HEALTH_LEAK_WINDOWS;
+        if (leaking && !leak_warned) {
+            Serial.printf("WARNING: allocated heap blocks keep growing (%u -> %u over %u windows)\n",
+                         (unsigned)prev_window_min, (unsigned)window_min, (unsigned)growth_windows);
+        }
+        leak_warned = leaking;
+        
+        prev_window_min = window_min;
+        window_min = UINT32_MAX;
+        window_samples = 0;
+    }
+};
+
+#endif // HEALTH_MONITOR_H
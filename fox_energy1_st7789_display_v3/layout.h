@@ -0,0 +1,241 @@
+/*
+ * Dashboard Layout
+ * Widget rectangles and text positions resolved at compile time from
+ * config.h, so rendering never measures text or derives coordinates
+ * DISPLAY_LAYOUT picks the arrangement; both define the same names, so
+ * DisplayManager draws either without knowing which one it got.
+ * The classic font has a fixed 6x8 cell: text extents only depend on
+ * the character count and the font size.
+ */
+
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include <stdint.h>
+#include "config.h"
+#include "glyph_cache.h"
+
+namespace Layout {
+
+/**
+ * Screen rectangle known at compile time
+ */
+struct Rect {
+    int16_t x, y, w, h;
+    
+    constexpr int16_t right() const { return x + w; }
+    constexpr int16_t bottom() const { return y + h; }
+};
+
+/**
+ * Top-left corner of a text run
+ */
+struct TextPos {
+    int16_t x, y;
+};
+
+// --- Text Metrics (same as getTextBounds() for unwrapped classic-font text) ---
+
+constexpr int16_t textWidth(int chars, int font_size) {
+    return chars * GLYPH_CELL_WIDTH * font_size;
+}
+
+constexpr int16_t textHeight(int font_size) {
+    return GLYPH_CELL_HEIGHT * font_size;
+}
+
+/**
+ * Cursor that centers a text run in an area (the +1 balances the empty
+ * bottom row of the font cell)
+ */
+constexpr TextPos centerText(Rect area, int chars, int font_size) {
+    return { (int16_t)(area.x + (area.w - textWidth(chars, font_size)) / 2),
+             (int16_t)(area.y + (area.h - textHeight(font_size)) / 2 + 1) };
+}
+
+/**
+ * Y of a text run vertically centered in the status bar
+ */
+constexpr int16_t statusTextY(int font_size) {
+    return (STATUS_BAR_HEIGHT - textHeight(font_size)) / 2 + 1;
+}
+
+// --- Status Bar ---
+
+constexpr int16_t TEMP_AREA_WIDTH = 65;     // Room for "-99°C" and a margin
+constexpr int16_t TIME_LEFT_X = 5;
+
+constexpr Rect WIFI_ICON = {
+    SCREEN_WIDTH - WIFI_ICON_WIDTH - WIFI_RIGHT_PADDING,
+    (STATUS_BAR_HEIGHT - WIFI_ICON_HEIGHT) / 2,
+    WIFI_ICON_WIDTH, WIFI_ICON_HEIGHT
+};
+
+constexpr int16_t TEMP_RIGHT_X = WIFI_ICON.x - TEMP_WIFI_GAP;   // Right-aligned text edge
+constexpr int16_t TEMP_X = TEMP_RIGHT_X > TEMP_AREA_WIDTH ? TEMP_RIGHT_X - TEMP_AREA_WIDTH : 0;
+
+constexpr Rect TEMP = { TEMP_X, 0, TEMP_RIGHT_X - TEMP_X, STATUS_BAR_HEIGHT };
+constexpr Rect TIME = { TIME_LEFT_X, 0, TIME_TOTAL_WIDTH, STATUS_BAR_HEIGHT };
+
+constexpr Rect STATUS_LINE = { 0, STATUS_BAR_HEIGHT, SCREEN_WIDTH, 1 };
+
+// Sample age in the gap under the WiFi icon, room for "99m"
+constexpr Rect DATA_AGE = {
+    WIFI_ICON.x, (int16_t)(WIFI_ICON.bottom() + 1), WIFI_ICON.w, textHeight(DATA_AGE_FONT_SIZE)
+};
+
+constexpr int16_t STATUS_TEXT_Y = statusTextY(STATUS_BAR_FONT_SIZE);
+constexpr int16_t TIME_TEXT_Y = statusTextY(TIME_FONT_SIZE);
+
+/**
+ * Left edge of a time cell (0 = hours, 1 = minutes, 2 = seconds)
+ */
+constexpr int16_t timeSegmentX(int segment) {
+    return TIME.x + segment * (TIME_SEGMENT_WIDTH + TIME_SEPARATOR_WIDTH);
+}
+
+constexpr int16_t MAIN_Y = STATUS_BAR_HEIGHT + 1 + STATUS_BAR_V_PADDING;
+constexpr int16_t MAIN_H = SCREEN_HEIGHT - MAIN_Y;
+
+#if DISPLAY_LAYOUT == LAYOUT_PORTRAIT
+
+// --- Main Area: power on top, voltage and current in rows below, energy totals at the bottom ---
+
+constexpr int16_t VA_ROW_H = 50;
+constexpr int16_t ENERGY_ROW_H = 38;
+constexpr int16_t ENERGY_MARGIN = 10;
+
+constexpr Rect POWER = { 0, MAIN_Y, SCREEN_WIDTH, MAIN_H - 2 * VA_ROW_H - ENERGY_ROW_H };
+constexpr Rect VOLTAGE = { 0, POWER.bottom(), SCREEN_WIDTH, VA_ROW_H };
+constexpr Rect CURRENT = { 0, VOLTAGE.bottom(), SCREEN_WIDTH, VA_ROW_H };
+constexpr Rect METERS = { 0, POWER.bottom(), SCREEN_WIDTH, 2 * VA_ROW_H };
+constexpr Rect ENERGY = {
+    ENERGY_MARGIN, CURRENT.bottom(), SCREEN_WIDTH - 2 * ENERGY_MARGIN, ENERGY_ROW_H
+};
+
+static_assert(ENERGY.bottom() == SCREEN_HEIGHT, "main area rows");
+
+#else
+
+// --- Main Area: power on top (3/5), voltage and current below, energy totals in the status bar ---
+
+constexpr Rect POWER = { 0, MAIN_Y, SCREEN_WIDTH, MAIN_H * 3 / 5 };
+constexpr Rect VOLTAGE = { 0, POWER.bottom(), SCREEN_WIDTH / 2, MAIN_H - POWER.h };
+constexpr Rect CURRENT = { SCREEN_WIDTH / 2, POWER.bottom(), SCREEN_WIDTH / 2, MAIN_H - POWER.h };
+constexpr Rect METERS = { 0, POWER.bottom(), SCREEN_WIDTH, MAIN_H - POWER.h };
+
+constexpr int16_t ENERGY_X = TIME.right() + ENERGY_AREA_GAP;
+constexpr Rect ENERGY = { ENERGY_X, 0, TEMP.x - ENERGY_AREA_GAP - ENERGY_X, STATUS_BAR_HEIGHT };
+
+static_assert(POWER.bottom() + VOLTAGE.h == SCREEN_HEIGHT, "main area rows");
+
+#endif
+
+// Two rows of ENERGY_FONT_SIZE text, centered as a block
+constexpr int16_t ENERGY_LINE_GAP = 4;
+constexpr int16_t ENERGY_TODAY_Y = ENERGY.y +
+    (ENERGY.h - 2 * textHeight(ENERGY_FONT_SIZE) - ENERGY_LINE_GAP) / 2 + 1;
+constexpr int16_t ENERGY_MONTH_Y = ENERGY_TODAY_Y + textHeight(ENERGY_FONT_SIZE) + ENERGY_LINE_GAP;
+
+/**
+ * Power value and unit placed as one centered run
+ */
+struct PowerText {
+    int16_t x, y;               // Value
+    int16_t unit_x, unit_y;     // Unit, bottom-aligned and raised by a tenth
+    int16_t w, h;               // Whole run (dirty rectangle)
+};
+
+constexpr int16_t POWER_TEXT_Y = POWER.y + (POWER.h - textHeight(POWER_VALUE_FONT_SIZE)) / 2;
+constexpr int16_t POWER_UNIT_Y = POWER_TEXT_Y +
+    (textHeight(POWER_VALUE_FONT_SIZE) - textHeight(POWER_UNIT_FONT_SIZE)) -
+    textHeight(POWER_VALUE_FONT_SIZE) / 10;
+
+constexpr int16_t powerUnitGap(bool kw) {
+    return kw ? 2 : 3;
+}
+
+constexpr int16_t powerTextWidth(int value_chars, bool kw) {
+    return textWidth(value_chars, POWER_VALUE_FONT_SIZE) + powerUnitGap(kw) +
+           textWidth(kw ? 2 : 1, POWER_UNIT_FONT_SIZE);
+}
+
+constexpr int16_t powerTextX(int value_chars, bool kw) {
+    return POWER.x + (POWER.w - powerTextWidth(value_chars, kw)) / 2;
+}
+
+/**
+ * value_chars characters of value followed by "kW" (kw) or "W"
+ */
+constexpr PowerText powerText(int value_chars, bool kw) {
+    return { powerTextX(value_chars, kw), POWER_TEXT_Y,
+             (int16_t)(powerTextX(value_chars, kw) + textWidth(value_chars, POWER_VALUE_FONT_SIZE) +
+                       powerUnitGap(kw)),
+             POWER_UNIT_Y,
+             powerTextWidth(value_chars, kw), textHeight(POWER_VALUE_FONT_SIZE) };
+}
+
+// Every placement the power widget can need, by [kW][value length]
+#define POWER_TEXT_MAX_CHARS  6     // "-999.9"
+constexpr PowerText POWER_TEXT[2][POWER_TEXT_MAX_CHARS + 1] = {
+    { powerText(0, false), powerText(1, false), powerText(2, false), powerText(3, false),
+      powerText(4, false), powerText(5, false), powerText(6, false) },
+    { powerText(0, true), powerText(1, true), powerText(2, true), powerText(3, true),
+      powerText(4, true), powerText(5, true), powerText(6, true) }
+};
+
+// Voltage and current: the cursor for each string length, centered in their halves
+#define VA_TEXT_MAX_CHARS  8
+constexpr TextPos VOLTAGE_TEXT[VA_TEXT_MAX_CHARS + 1] = {
+    centerText(VOLTAGE, 0, VA_FONT_SIZE), centerText(VOLTAGE, 1, VA_FONT_SIZE),
+    centerText(VOLTAGE, 2, VA_FONT_SIZE), centerText(VOLTAGE, 3, VA_FONT_SIZE),
+    centerText(VOLTAGE, 4, VA_FONT_SIZE), centerText(VOLTAGE, 5, VA_FONT_SIZE),
+    centerText(VOLTAGE, 6, VA_FONT_SIZE), centerText(VOLTAGE, 7, VA_FONT_SIZE),
+    centerText(VOLTAGE, 8, VA_FONT_SIZE)
+};
+constexpr TextPos CURRENT_TEXT[VA_TEXT_MAX_CHARS + 1] = {
+    centerText(CURRENT, 0, VA_FONT_SIZE), centerText(CURRENT, 1, VA_FONT_SIZE),
+    centerText(CURRENT, 2, VA_FONT_SIZE), centerText(CURRENT, 3, VA_FONT_SIZE),
+    centerText(CURRENT, 4, VA_FONT_SIZE), centerText(CURRENT, 5, VA_FONT_SIZE),
+    centerText(CURRENT, 6, VA_FONT_SIZE), centerText(CURRENT, 7, VA_FONT_SIZE),
+    centerText(CURRENT, 8, VA_FONT_SIZE)
+};
+
+// --- Meter Cells (several meters: one per meter in METERS, in place of voltage and current) ---
+
+/**
+ * Cell of meter (0-based) when the row is split count ways
+ */
+constexpr Rect meterCell(int meter, int count) {
+    return { (int16_t)(METERS.x + meter * METERS.w / count), METERS.y,
+             (int16_t)((meter + 1) * METERS.w / count - meter * METERS.w / count), METERS.h };
+}
+
+// Label/voltage line above the meter's power, centered as a block
+constexpr int16_t METER_LINE_GAP = 6;
+constexpr int16_t METER_LABEL_Y = METERS.y + (METERS.h - textHeight(METER_LABEL_FONT_SIZE) -
+    METER_LINE_GAP - textHeight(METER_VALUE_FONT_SIZE)) / 2 + 1;
+constexpr int16_t METER_VALUE_Y = METER_LABEL_Y + textHeight(METER_LABEL_FONT_SIZE) + METER_LINE_GAP;
+
+// --- Graph Strip (padding band, 1 px clear of the line and the digits) ---
+
+constexpr Rect GRAPH = { 0, STATUS_BAR_HEIGHT + 2, SCREEN_WIDTH, STATUS_BAR_V_PADDING - 2 };
+
+// Right end of the graph strip, room for "R99.9/99.9ms"
+constexpr int16_t PROFILER_OVERLAY_W = textWidth(12, 1) + 2;
+constexpr Rect PROFILER = {
+    SCREEN_WIDTH - PROFILER_OVERLAY_W, GRAPH.y, PROFILER_OVERLAY_W, textHeight(1) + 2
+};
+
+static_assert(ENERGY.w > 0, "no room for the energy totals");
+static_assert(DATA_AGE.bottom() <= STATUS_LINE.y && textWidth(3, DATA_AGE_FONT_SIZE) <= DATA_AGE.w,
+              "no room for the sample age under the WiFi icon");
+static_assert(POWER_TEXT[1][4].w <= SCREEN_WIDTH, "power value does not fit");
+static_assert(textHeight(VA_FONT_SIZE) <= VOLTAGE.h, "voltage and current rows too low");
+static_assert(textWidth(7, METER_LABEL_FONT_SIZE) <= SCREEN_WIDTH / METER_MAX &&
+              textWidth(5, METER_VALUE_FONT_SIZE) <= SCREEN_WIDTH / METER_MAX,
+              "meter cells too narrow for \"L1 230V\" / \"9999W\"");
+
+} // namespace Layout
+
+#endif // LAYOUT_H
@@ -0,0 +1,26 @@
+/*
+ * Little-Endian Writers
+ * Shared by the binary wire formats (/api/history.bin, telemetry
+ * batches), which store every multi-byte field little-endian
+ */
+
+#ifndef LITTLE_ENDIAN_H
+#define LITTLE_ENDIAN_H
+
+#include <stdint.h>
+
+namespace LittleEndian {
+
+inline void put16(uint8_t* p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+inline void put32(uint8_t* p, uint32_t v) {
+    put16(p, v & 0xFFFF);
+    put16(p + 2, v >> 16);
+}
+
+} // namespace LittleEndian
+
+#endif // LITTLE_ENDIAN_H
@@ -0,0 +1,254 @@
+/*
+ * Meter Set
+ * Polls every meter in METER_URLS at the same time, each from its own
+ * fetch task over its own keep-alive connection, so a round costs the
+ * slowest meter's latency rather than the sum. Keeps the latest reading
+ * per meter and combines them into the dashboard total.
+ */
+
+#ifndef METER_SET_H
+#define METER_SET_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "types.h"
+#include "data_fetcher.h"
+#include "fetch_task.h"
+#include "wifi_manager.h"
+#include "firmware_stats.h"
+
+static const char* const METER_URL_LIST[] = METER_URLS;
+#define METER_COUNT  (int)(sizeof(METER_URL_LIST) / sizeof(METER_URL_LIST[0]))
+
+static_assert(METER_COUNT <= METER_MAX, "more METER_URLS than METER_MAX");
+static_assert(METER_COUNT == 1 || DATA_TRANSPORT == TRANSPORT_HTTP_POLL,
+              "several meters need the HTTP transport");
+
+class MeterSet {
+public:
+    MeterSet() :
+        interval_ms(LOOP_DELAY_MS),
+        next_poll(0),
+        stats(nullptr) {
+        memset(last_good, 0, sizeof(last_good));
+        memset(failures, 0, sizeof(failures));
+    }
+    
+    /**
+     * Record fetch latencies and per-meter state (may be nullptr)
+     */
+    void setStats(FirmwareStats* firmware_stats) {
+        stats = firmware_stats;
+        for (int i = 0; i < METER_COUNT; i++) {
+            fetchers[i].setStats(firmware_stats);
+        }
+        if (stats) stats->meter_count = METER_COUNT;
+    }
+    
+    int count() {
+        return METER_COUNT;
+    }
+    
+    /**
+     * One meter's fetcher; only for use before begin() (benchmark mode)
+     */
+    DataFetcher& getFetcher(int meter) {
+        return fetchers[meter];
+    }
+    
+    /**
+     * Start one fetch task per meter
+     * Call from the UI task: every task wakes it when it publishes a sample
+     */
+    bool begin(WiFiManager* wifi) {
+        bool ok = true;
+        for (int i = 0; i < METER_COUNT; i++) {
+            ok = tasks[i].begin(&fetchers[i], wifi, METER_URL_LIST[i]) && ok;
+        }
+        if (METER_COUNT > 1) {
+            Serial.printf("Polling %d meters concurrently\n", METER_COUNT);
+        }
+        return ok;
+    }
+    
+    /**
+     * Take the next sample from any meter and record it (UI side)
+     * Meters are visited in turn so a fast one cannot starve the others.
+     * sample.meter tells which one it came from.
+     */
+    bool poll(PowerSample& sample) {
+        for (int n = 0; n < METER_COUNT; n++) {
+            int i = next_poll;
+            next_poll = (next_poll + 1) % METER_COUNT;
+            if (tasks[i].poll(sample)) {
+                sample.meter = i;
+                record(sample);
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    /**
+     * Combined reading: power and current add up, voltage is the mean
+     * (the phase voltages of a three-phase install). Stale meters keep
+     * contributing their last reading. With one meter this is its reading.
+     * Returns false until some meter has reported.
+     */
+    bool getTotal(PowerData& total) {
+        total = PowerData();
+        int reporting = 0;
+        for (int i = 0; i < METER_COUNT; i++) {
+            if (!readings[i].has_data) continue;
+            total.voltage += readings[i].data.voltage;
+            total.current += readings[i].data.current;
+            total.power_active += readings[i].data.power_active;
+            reporting++;
+        }
+        if (reporting == 0) return false;
+        total.voltage /= reporting;
+        return true;
+    }
+    
+    /**
+     * Latest reading of each meter, METER_COUNT entries
+     */
+    const MeterReading* getReadings() {
+        return readings;
+    }
+    
+    /**
+     * Gray out meters without a valid sample for METER_STALE_MS (once a second)
+     */
+    void updateStaleness(unsigned long now) {
+        for (int i = 0; i < METER_COUNT; i++) {
+            bool stale = !readings[i].has_data || now - last_good[i] >= METER_STALE_MS;
+            if (stale && !readings[i].stale && METER_COUNT > 1) {
+                Serial.printf("Meter %d stale, showing its last reading\n", i + 1);
+            }
+            readings[i].stale = stale;
+        }
+    }
+    
+    /**
+     * Longest failure streak of any meter
+     */
+    int getConsecutiveFailures() {
+        int worst = 0;
+        for (int i = 0; i < METER_COUNT; i++) {
+            worst = max(worst, failures[i]);
+        }
+        return worst;
+    }
+    
+    /**
+     * Poll interval of every meter that is not backing off
+     */
+    void setInterval(uint32_t ms) {
+        interval_ms = ms;
+        for (int i = 0; i < METER_COUNT; i++) {
+            if (failures[i] == 0) tasks[i].setInterval(ms);
+        }
+    }
+    
+    /**
+     * Slow down one failing meter; it rejoins the common interval with
+     * its next valid sample
+     */
+    void backOff(int meter, uint32_t ms) {
+        if (tasks[meter].getInterval() == ms) return;
+        Serial.printf("Meter %d poll interval: %lu -> %lu ms (backoff)\n", meter + 1,
+                     (unsigned long)tasks[meter].getInterval(), (unsigned long)ms);
+        tasks[meter].setInterval(ms);
+    }
+    
+    // --- Fan-out of the FetchTask controls ---
+    
+    /**
+     * Sleep until any meter publishes a sample or the timeout expires (UI side)
+     */
+    void waitForSample(uint32_t timeout_ms) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeout_ms));
+    }
+    
+    void wake() {
+        for (int i = 0; i < METER_COUNT; i++) tasks[i].wake();
+    }
+    
+    void resetFailures() {
+        for (int i = 0; i < METER_COUNT; i++) tasks[i].resetFailures();
+    }
+    
+    bool isBusy() {
+        for (int i = 0; i < METER_COUNT; i++) {
+            if (tasks[i].isBusy()) return true;
+        }
+        return false;
+    }
+    
+    bool hasSample() {
+        for (int i = 0; i < METER_COUNT; i++) {
+            if (tasks[i].hasSample()) return true;
+        }
+        return false;
+    }
+    
+    /**
+     * Time until the earliest due poll
+     */
+    uint32_t msUntilNextFetch() {
+        uint32_t soonest = UINT32_MAX;
+        for (int i = 0; i < METER_COUNT; i++) {
+            soonest = min(soonest, tasks[i].msUntilNextFetch());
+        }
+        return soonest;
+    }
+    
+    uint32_t getDroppedSamples() {
+        uint32_t dropped = 0;
+        for (int i = 0; i < METER_COUNT; i++) {
+            dropped += tasks[i].getDroppedSamples();
+        }
+        return dropped;
+    }
+    
+    TaskHandle_t getTaskHandle(int meter) {
+        return tasks[meter].getTaskHandle();
+    }
+
+private:
+    DataFetcher fetchers[METER_COUNT];
+    FetchTask tasks[METER_COUNT];
+    MeterReading readings[METER_COUNT];
+    unsigned long last_good[METER_COUNT];   // fetch_time of the last valid sample
+    int failures[METER_COUNT];              // As of the newest sample
+    uint32_t interval_ms;                   // Common poll interval
+    int next_poll;
+    FirmwareStats* stats;
+    
+    void record(const PowerSample& sample) {
+        int i = sample.meter;
+        
+        if (sample.valid) {
+            if (failures[i] > 0) {
+                tasks[i].setInterval(interval_ms); // Recovered, end the backoff
+            }
+            if (readings[i].stale && readings[i].has_data && METER_COUNT > 1) {
+                Serial.printf("Meter %d reporting again\n", i + 1);
+            }
+            readings[i].data = sample.data;
+            readings[i].has_data = true;
+            readings[i].stale = false;
+            last_good[i] = sample.fetch_time;
+        }
+        failures[i] = sample.consecutive_failures;
+        
+        if (stats) {
+            stats->meter_power_w[i] = readings[i].data.power_active;
+            stats->meter_sample_ms[i] = readings[i].has_data ? max(last_good[i], 1UL) : 0;
+            stats->meter_failures[i] = failures[i];
+        }
+    }
+};
+
+#endif // METER_SET_H
@@ -0,0 +1,721 @@
+/*
+ * Local Metrics Server
+ * Serves the latest sample and history to desktop clients, so the meter
+ * only ever sees one poller (this display). /api/stream pushes each new
+ * sample as a Server-Sent Event, /api/history.bin is the history as
+ * compact binary records, /metrics exports readings and firmware timings
+ * in the Prometheus text format.
+ */
+
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <stdarg.h>
+#include <new>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include "config.h"
+#include "types.h"
+#include "power_history.h"
+#include "firmware_stats.h"
+#include "buffer_arena.h"
+#include "little_endian.h"
+
+#define METRICS_JSON_MAX      256   // Cached /api/current body
+#define METRICS_REQUEST_MAX   128   // Request line buffer
+#define METRICS_TEXT_MAX      14336 // /metrics exposition buffer (reused per scrape, ~10.5 KB used, ~11.5 KB with 3 meters)
+
+/*
+ * /api/history.bin, version 1 (all fields little-endian)
+ *   Header, 16 bytes:
+ *     0  "FXH"            magic
+ *     3  uint8   version  1
+ *     4  uint16  interval seconds between records
+ *     6  uint16  count    records that follow
+ *     8  uint32  end      Unix time of the newest record (record k is at
+ *                         end - (count - 1 - k) * interval)
+ *    12  uint8   size     bytes per record (6; skip any extra bytes)
+ *    13  uint8   channels 3
+ *    14  uint16  reserved 0
+ *   Records, oldest first: uint16 voltage (0.1 V), uint16 current
+ *   (0.01 A), uint16 power (1 W), the scales of HistoryRecord
+ */
+#define HISTORY_BIN_MAGIC        "FXH"
+#define HISTORY_BIN_VERSION      1
+#define HISTORY_BIN_HEADER_SIZE  16
+#define HISTORY_BIN_RECORD_SIZE  (HISTORY_CHANNELS * 2)
+
+// The binary history is assembled in metrics_text
+static_assert(HISTORY_BIN_HEADER_SIZE + MinuteHistory::capacity() * HISTORY_BIN_RECORD_SIZE <= METRICS_TEXT_MAX &&
+              HISTORY_BIN_HEADER_SIZE + SecondHistory::capacity() * HISTORY_BIN_RECORD_SIZE <= METRICS_TEXT_MAX,
+              "metrics buffer too small for a binary history tier");
+
+// Longest JSON history sample: ",[v,a,w]" with three full-width longs
+#define HISTORY_JSON_SAMPLE_MAX  (2 + HISTORY_CHANNELS * 11 + (HISTORY_CHANNELS - 1) + 1)
+
+// The JSON history copies a tier into metrics_text and formats one
+// worst-case block after it
+static_assert(sizeof(MinuteHistory) + MinuteHistory::blockSamples() * HISTORY_JSON_SAMPLE_MAX < METRICS_TEXT_MAX &&
+              sizeof(SecondHistory) + SecondHistory::blockSamples() * HISTORY_JSON_SAMPLE_MAX < METRICS_TEXT_MAX,
+              "metrics buffer too small for a JSON history tier");
+
+class MetricsServer {
+public:
+    MetricsServer() :
+        server(METRICS_SERVER_PORT),
+        history(nullptr),
+        stats(nullptr),
+        task(nullptr),
+        lock(nullptr),
+        body_len(0),
+        seq(0),
+        streamed_seq(0),
+        last_ping(0),
+        have_reading(false),
+        latest_today_kwh(0),
+        latest_month_kwh(0),
+        metrics_len(0) {
+        body[0] = '\0';
+    }
+    
+    /**
+     * Start listening and spawn the server task
+     * firmware_stats may be nullptr (then /metrics has readings only)
+     */
+    bool begin(PowerHistory* power_history, const FirmwareStats* firmware_stats) {
+        history = power_history;
+        stats = firmware_stats;
+        lock = xSemaphoreCreateMutex();
+        if (!lock) {
+            Serial.println("Metrics server: mutex allocation failed");
+            return false;
+        }
+        
+        body_len = snprintf(body, sizeof(body), "{\"status\":\"waiting\"}");
+        server.begin();
+        server.setNoDelay(true);
+        
+        BaseType_t result = xTaskCreate(taskEntry, "metrics", METRICS_TASK_STACK,
+                                        this, METRICS_TASK_PRIORITY, &task);
+        if (result != pdPASS) {
+            Serial.println("Failed to start metrics server task");
+            server.end();
+            return false;
+        }
+        
+        Serial.printf("Metrics server listening on port %d\n", METRICS_SERVER_PORT);
+        return true;
+    }
+    
+    /**
+     * Re-render the cached /api/current response (UI task, once per new sample)
+     * The body is serialised outside the lock; only the copy is guarded
+     */
+    void publish(const PowerData& power, float energy_today, float energy_month) {
+        if (!lock) return;
+        
+        time_t now = time(nullptr);
+        char next[METRICS_JSON_MAX];
+        int len = snprintf(next, sizeof(next),
+                           "{\"status\":\"ok\",\"seq\":%lu,\"timestamp\":%ld,"
+                           "\"voltage\":\"%.1f\",\"current\":\"%.2f\",\"power_active\":\"%.1f\","
+                           "\"energy_today\":\"%.3f\",\"energy_month\":\"%.3f\"}",
+                           (unsigned long)(seq + 1), (long)(now > 1600000000 ? now : 0),
+                           power.voltage, power.current, power.power_active,
+                           energy_today, energy_month);
+        if (len <= 0 || len >= (int)sizeof(next)) return;
+        
+        xSemaphoreTake(lock, portMAX_DELAY);
+        memcpy(body, next, len + 1);
+        body_len = len;
+        seq++;
+        latest = power;
+        latest_today_kwh = energy_today;
+        latest_month_kwh = energy_month;
+        have_reading = true;
+        xSemaphoreGive(lock);
+        
+        // Wake the server task so stream clients get the sample right away
+        if (task) xTaskNotifyGive(task);
+    }
+    
+    TaskHandle_t getTaskHandle() {
+        return task;
+    }
+
+private:
+    WiFiServer server;
+    PowerHistory* history;
+    const FirmwareStats* stats;
+    TaskHandle_t task;
+    SemaphoreHandle_t lock;
+    char body[METRICS_JSON_MAX];
+    int body_len;
+    uint32_t seq;
+    
+    // Server-Sent Events clients (kept open between samples)
+    WiFiClient stream_clients[METRICS_SSE_MAX_CLIENTS];
+    uint32_t streamed_seq;
+    unsigned long last_ping;
+    
+    // Newest reading for /metrics (guarded by lock)
+    bool have_reading;
+    PowerData latest;
+    float latest_today_kwh;
+    float latest_month_kwh;
+    
+    // Exposition text, only touched by the server task (aligned so a
+    // history tier can be copied into it)
+    alignas(MinuteHistory) char metrics_text[METRICS_TEXT_MAX];
+    int metrics_len;
+    
+    static void taskEntry(void* arg) {
+        static_cast<MetricsServer*>(arg)->run();
+    }
+    
+    /**
+     * Accept loop - one request at a time, never touches the display
+     * Woken early by publish() so stream clients see new samples at once
+     */
+    void run() {
+        for (;;) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(20));
+            
+            WiFiClient client = server.available();
+            if (client) {
+                client.setTimeout(METRICS_CLIENT_TIMEOUT_MS);
+                if (!handleClient(client)) {
+                    client.stop();
+                }
+            }
+            
+            pushStreamEvents();
+        }
+    }
+    
+    /**
+     * Serve one request
+     * Returns true if the connection was kept as a stream client
+     */
+    bool handleClient(WiFiClient& client) {
+        char request[METRICS_REQUEST_MAX];
+        int n = client.readBytesUntil('\n', request, sizeof(request) - 1);
+        if (n <= 0) return false;
+        request[n] = '\0';
+        
+        // Skip headers until the blank line
+        char line[METRICS_REQUEST_MAX];
+        while (client.connected()) {
+            int len = client.readBytesUntil('\n', line, sizeof(line) - 1);
+            if (len <= 1) break; // "\r" or timeout
+        }
+        
+        // "GET /path?query HTTP/1.1"
+        if (strncmp(request, "GET ", 4) != 0) {
+            sendStatus(client, "405 Method Not Allowed");
+            return false;
+        }
+        char* path = request + 4;
+        char* end = strchr(path, ' ');
+        if (end) *end = '\0';
+        
+        if (strcmp(path, "/api/stream") == 0) {
+            return openStream(client);
+        } else if (strcmp(path, "/metrics") == 0) {
+            sendMetrics(client);
+        } else if (strcmp(path, "/api/current") == 0) {
+            sendCurrent(client);
+        } else if (strncmp(path, "/api/history.bin", 16) == 0) {
+            bool minutes = strstr(path, "tier=minutes") != nullptr;
+            sendHistoryBinary(client, minutes);
+        } else if (strncmp(path, "/api/history", 12) == 0) {
+            bool minutes = strstr(path, "tier=minutes") != nullptr;
+            sendHistory(client, minutes);
+        } else {
+            sendStatus(client, "404 Not Found");
+        }
+        return false;
+    }
+    
+    /**
+     * Register an SSE client and send it the current sample at once
+     */
+    bool openStream(WiFiClient& client) {
+        for (uint8_t i = 0; i < METRICS_SSE_MAX_CLIENTS; i++) {
+            if (stream_clients[i].connected()) continue;
+            
+            const char* header = "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\n"
+                                 "Cache-Control: no-cache\r\nConnection: keep-alive\r\n\r\n";
+            client.write((const uint8_t*)header, strlen(header));
+            
+            char event[METRICS_JSON_MAX + 32];
+            int len = formatEvent(event, sizeof(event), nullptr);
+            client.write((const uint8_t*)event, len);
+            
+            stream_clients[i] = client;
+            Serial.printf("Stream client %u connected\n", i);
+            return true;
+        }
+        
+        sendStatus(client, "503 Service Unavailable");
+        return false;
+    }
+    
+    /**
+     * Format the cached sample as an SSE event ("id: <seq>" lets clients
+     * notice missed samples); stores its seq in event_seq if given
+     */
+    int formatEvent(char* event, size_t size, uint32_t* event_seq) {
+        xSemaphoreTake(lock, portMAX_DELAY);
+        int len = snprintf(event, size, "id: %lu\ndata: %s\n\n", (unsigned long)seq, body);
+        if (event_seq) *event_seq = seq;
+        xSemaphoreGive(lock);
+        return min(len, (int)size - 1);
+    }
+    
+    /**
+     * Push a new sample (or a keep-alive comment) to all stream clients
+     */
+    void pushStreamEvents() {
+        char event[METRICS_JSON_MAX + 32];
+        int len = 0;
+        
+        uint32_t current_seq;
+        xSemaphoreTake(lock, portMAX_DELAY);
+        current_seq = seq;
+        xSemaphoreGive(lock);
+        
+        if (current_seq != streamed_seq) {
+            len = formatEvent(event, sizeof(event), &streamed_seq);
+        } else if (millis() - last_ping >= METRICS_SSE_PING_MS) {
+            len = snprintf(event, sizeof(event), ": ping\n\n");
+        } else {
+            return;
+        }
+        last_ping = millis();
+        
+        for (uint8_t i = 0; i < METRICS_SSE_MAX_CLIENTS; i++) {
+            WiFiClient& client = stream_clients[i];
+            if (!client.connected()) continue;
+            
+            if (client.write((const uint8_t*)event, len) != (size_t)len) {
+                Serial.printf("Stream client %u dropped\n", i);
+                client.stop();
+            }
+        }
+    }
+    
+    void sendStatus(WiFiClient& client, const char* status) {
+        char header[96];
+        int len = snprintf(header, sizeof(header),
+                           "HTTP/1.1 %s\r\nContent-Length: 0\r\nConnection: close\r\n\r\n", status);
+        client.write((const uint8_t*)header, len);
+    }
+    
+    void sendJsonHeader(WiFiClient& client, int content_length) {
+        sendHeader(client, "application/json", content_length);
+    }
+    
+    /**
+     * 200 OK; content_length < 0 means the body ends when the connection closes
+     */
+    void sendHeader(WiFiClient& client, const char* content_type, int content_length) {
+        char header[160];
+        int len;
+        if (content_length >= 0) {
+            len = snprintf(header, sizeof(header),
+                           "HTTP/1.1 200 OK\r\nContent-Type: %s\r\n"
+                           "Content-Length: %d\r\nConnection: close\r\n\r\n",
+                           content_type, content_length);
+        } else {
+            len = snprintf(header, sizeof(header),
+                           "HTTP/1.1 200 OK\r\nContent-Type: %s\r\n"
+                           "Connection: close\r\n\r\n", content_type);
+        }
+        client.write((const uint8_t*)header, len);
+    }
+    
+    /**
+     * Cached latest sample - just a copy, no serialisation per request
+     */
+    void sendCurrent(WiFiClient& client) {
+        char copy[METRICS_JSON_MAX];
+        xSemaphoreTake(lock, portMAX_DELAY);
+        int len = body_len;
+        memcpy(copy, body, len + 1);
+        xSemaphoreGive(lock);
+        
+        sendJsonHeader(client, len);
+        client.write((const uint8_t*)copy, len);
+    }
+    
+    /**
+     * Stream one history tier block by block
+     * Values are fixed point; "scale" gives the divisors for V, A and W.
+     * The tier is copied into metrics_text under the history lock, so the
+     * blocks and "end" come from one snapshot; the copy is decoded and
+     * sent without holding the lock.
+     */
+    void sendHistory(WiFiClient& client, bool minutes) {
+        if (!history) {
+            sendStatus(client, "503 Service Unavailable");
+            return;
+        }
+        
+        if (minutes) {
+            streamHistory(client, history->getMinutes(), true);
+        } else {
+            streamHistory(client, history->getSeconds(), false);
+        }
+    }
+    
+    template<typename Tier>
+    void streamHistory(WiFiClient& client, const Tier& tier, bool minutes) {
+        history->lock();
+        const Tier* copy = new (metrics_text) Tier(tier);
+        long end_time = minutes ? (long)(history->getNewestTime() - history->getPendingSeconds())
+                                : (long)history->getNewestTime();
+        history->unlock();
+        
+        // The JSON for one block goes after the copy
+        char* chunk = metrics_text + sizeof(Tier);
+        const size_t chunk_size = sizeof(metrics_text) - sizeof(Tier);
+        
+        sendJsonHeader(client, -1);
+        int len = snprintf(chunk, chunk_size,
+                           "{\"interval\":%d,\"end\":%ld,\"scale\":[%g,%g,%g],\"samples\":[",
+                           minutes ? 60 : 1, end_time, HISTORY_VOLTAGE_SCALE,
+                           HISTORY_CURRENT_SCALE, HISTORY_POWER_SCALE);
+        client.write((const uint8_t*)chunk, len);
+        
+        bool first = true;
+        auto append = [&](const HistoryRecord& r) {
+            len += snprintf(chunk + len, chunk_size - len, "%s[%ld,%ld,%ld]",
+                            first ? "" : ",", (long)r.value[0], (long)r.value[1],
+                            (long)r.value[2]);
+            first = false;
+            return true;
+        };
+        for (uint8_t b = 0; b < copy->blockCount() && client.connected(); b++) {
+            len = 0;
+            copy->forEachInBlock(b, append);
+            client.write((const uint8_t*)chunk, len);
+        }
+        
+        client.write((const uint8_t*)"]}", 2);
+    }
+    
+    /**
+     * One history tier as fixed-size binary records (HISTORY_BIN_*)
+     * The whole tier is decoded into metrics_text under the history lock,
+     * so the header always matches the records that follow, and a day of
+     * minutes goes out as one 8.6 KB response.
+     */
+    void sendHistoryBinary(WiFiClient& client, bool minutes) {
+        if (!history) {
+            sendStatus(client, "503 Service Unavailable");
+            return;
+        }
+        
+        uint8_t* out = (uint8_t*)metrics_text;
+        size_t len = HISTORY_BIN_HEADER_SIZE;
+        auto append = [&](const HistoryRecord& r) {
+            for (uint8_t c = 0; c < HISTORY_CHANNELS; c++) {
+                LittleEndian::put16(out + len, (uint16_t)constrain(r.value[c], (int32_t)0, (int32_t)UINT16_MAX));
+                len += 2;
+            }
+            return true;
+        };
+        
+        history->lock();
+        uint32_t end_time = minutes ? (uint32_t)(history->getNewestTime() - history->getPendingSeconds())
+                                    : (uint32_t)history->getNewestTime();
+        if (minutes) {
+            history->getMinutes().forEach(append);
+        } else {
+            history->getSeconds().forEach(append);
+        }
+        history->unlock();
+        
+        memcpy(out, HISTORY_BIN_MAGIC, 3);
+        out[3] = HISTORY_BIN_VERSION;
+        LittleEndian::put16(out + 4, minutes ? 60 : 1);
+        LittleEndian::put16(out + 6, (len - HISTORY_BIN_HEADER_SIZE) / HISTORY_BIN_RECORD_SIZE);
+        LittleEndian::put32(out + 8, end_time);
+        out[12] = HISTORY_BIN_RECORD_SIZE;
+        out[13] = HISTORY_CHANNELS;
+        LittleEndian::put16(out + 14, 0);
+        
+        sendHeader(client, "application/octet-stream", len);
+        client.write(out, len);
+    }
+    
+    /**
+     * Prometheus text exposition, rendered into metrics_text
+     * Histogram counters are snapshotted one at a time, so buckets of
+     * different series may be a few samples apart; each series is consistent.
+     */
+    void sendMetrics(WiFiClient& client) {
+        bool reading;
+        PowerData power;
+        float today_kwh, month_kwh;
+        uint32_t samples;
+        xSemaphoreTake(lock, portMAX_DELAY);
+        reading = have_reading;
+        power = latest;
+        today_kwh = latest_today_kwh;
+        month_kwh = latest_month_kwh;
+        samples = seq;
+        xSemaphoreGive(lock);
+        
+        metrics_len = 0;
+        metrics_text[0] = '\0';
+        
+        if (reading) {
+            appendHeader("foxmon_voltage_volts", "gauge", "Mains voltage");
+            appendMetric("foxmon_voltage_volts %.1f\n", power.voltage);
+            appendHeader("foxmon_current_amperes", "gauge", "Current");
+            appendMetric("foxmon_current_amperes %.2f\n", power.current);
+            appendHeader("foxmon_power_watts", "gauge", "Active power");
+            appendMetric("foxmon_power_watts %.1f\n", power.power_active);
+            appendHeader("foxmon_energy_today_kilowatt_hours", "gauge", "Energy since local midnight");
+            appendMetric("foxmon_energy_today_kilowatt_hours %.3f\n", today_kwh);
+            appendHeader("foxmon_energy_month_kilowatt_hours", "gauge", "Energy since the first of the month");
+            appendMetric("foxmon_energy_month_kilowatt_hours %.3f\n", month_kwh);
+        }
+        appendHeader("foxmon_samples_total", "counter", "Valid samples received");
+        appendMetric("foxmon_samples_total %lu\n", (unsigned long)samples);
+        
+        if (stats) {
+            appendHeader("foxmon_fetch_duration_seconds", "histogram",
+                         "Meter request phases (connect only for new connections)");
+            for (uint8_t i = 0; i < FETCH_PHASE_COUNT; i++) {
+                appendHistogram("foxmon_fetch_duration_seconds", "phase",
+                                FETCH_PHASE_NAMES[i], stats->fetch[i]);
+            }
+            appendHeader("foxmon_render_duration_seconds", "histogram",
+                         "Dirty-region render passes including flush");
+            for (uint8_t i = 0; i < RENDER_TARGET_COUNT; i++) {
+                appendHistogram("foxmon_render_duration_seconds", "target",
+                                RENDER_TARGET_NAMES[i], stats->render[i]);
+            }
+            appendHeader("foxmon_flush_duration_seconds", "histogram",
+                         "CPU time spent flushing pixels per render pass");
+            appendHistogram("foxmon_flush_duration_seconds", nullptr, nullptr, stats->flush);
+            
+            appendHeader("foxmon_fetch_failures_total", "counter", "Failed fetches");
+            appendMetric("foxmon_fetch_failures_total %lu\n", (unsigned long)stats->fetch_failures);
+            appendHeader("foxmon_fetch_consecutive_failures", "gauge", "Failures since the last valid sample");
+            appendMetric("foxmon_fetch_consecutive_failures %ld\n", (long)stats->consecutive_failures);
+            appendHeader("foxmon_samples_dropped_total", "counter", "Samples lost to a full queue");
+            appendMetric("foxmon_samples_dropped_total %lu\n", (unsigned long)stats->samples_dropped);
+            appendHeader("foxmon_wifi_reconnect_attempts_total", "counter", "WiFi reconnection attempts");
+            appendMetric("foxmon_wifi_reconnect_attempts_total %lu\n",
+                         (unsigned long)stats->wifi_reconnect_attempts);
+            appendHeader("foxmon_wifi_reconnects_total", "counter", "Successful WiFi reconnections");
+            appendMetric("foxmon_wifi_reconnects_total %lu\n", (unsigned long)stats->wifi_reconnects);
+            appendHeader("foxmon_loop_overruns_total", "counter", "UI frames longer than the frame interval");
+            appendMetric("foxmon_loop_overruns_total %lu\n", (unsigned long)stats->loop_overruns);
+            appendHeader("foxmon_light_sleeps_total", "counter", "Light sleeps between frames");
+            appendMetric("foxmon_light_sleeps_total %lu\n", (unsigned long)stats->light_sleeps);
+            appendHeader("foxmon_light_sleep_seconds_total", "counter", "Time spent in light sleep");
+            appendMetric("foxmon_light_sleep_seconds_total %.3f\n", stats->light_sleep_ms / 1000.0);
+            appendHeader("foxmon_backlight_level", "gauge", "Backlight PWM level (0-255)");
+            appendMetric("foxmon_backlight_level %u\n", (unsigned)stats->backlight_level);
+            appendHeader("foxmon_current_estimate_milliamperes", "gauge",
+                         "Average current since boot, modelled from time per power state");
+            appendMetric("foxmon_current_estimate_milliamperes %.1f\n", stats->current_estimate_ma);
+            appendPipelineMetrics();
+            if (stats->meter_count > 1) {
+                appendMeterMetrics();
+            }
+            if (ENABLE_TELEMETRY) {
+                appendTelemetryMetrics();
+            }
+        }
+        
+        appendHeader("foxmon_heap_free_bytes", "gauge", "Free heap");
+        appendMetric("foxmon_heap_free_bytes %lu\n", (unsigned long)ESP.getFreeHeap());
+        appendHeader("foxmon_heap_min_free_bytes", "gauge", "Lowest free heap since boot");
+        appendMetric("foxmon_heap_min_free_bytes %lu\n", (unsigned long)ESP.getMinFreeHeap());
+        appendHeader("foxmon_heap_largest_free_block_bytes", "gauge", "Largest allocatable block");
+        appendMetric("foxmon_heap_largest_free_block_bytes %lu\n", (unsigned long)ESP.getMaxAllocHeap());
+        if (stats && stats->task_count > 0) {
+            appendHealthMetrics();
+        }
+        appendHeader("foxmon_wifi_rssi_dbm", "gauge", "WiFi signal strength");
+        appendMetric("foxmon_wifi_rssi_dbm %d\n", (int)WiFi.RSSI());
+        appendHeader("foxmon_stream_clients", "gauge", "Open /api/stream connections");
+        appendMetric("foxmon_stream_clients %u\n", countStreamClients());
+        appendHeader("foxmon_uptime_seconds", "counter", "Time since boot");
+        appendMetric("foxmon_uptime_seconds %lu\n", millis() / 1000UL);
+        
+        char header[160];
+        int len = snprintf(header, sizeof(header),
+                           "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                           "Content-Length: %d\r\nConnection: close\r\n\r\n", metrics_len);
+        client.write((const uint8_t*)header, len);
+        client.write((const uint8_t*)metrics_text, metrics_len);
+    }
+    
+    /**
+     * Append formatted text; a line that does not fit is dropped whole
+     */
+    __attribute__((format(printf, 2, 3)))
+    void appendMetric(const char* format, ...) {
+        int space = sizeof(metrics_text) - metrics_len;
+        va_list args;
+        va_start(args, format);
+        int n = vsnprintf(metrics_text + metrics_len, space, format, args);
+        va_end(args);
+        
+        if (n < 0 || n >= space) {
+            metrics_text[metrics_len] = '\0';
+            Serial.println("Metrics buffer full, output truncated");
+            return;
+        }
+        metrics_len += n;
+    }
+    
+    void appendHeader(const char* name, const char* type, const char* help) {
+        appendMetric("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+    }
+    
+    /**
+     * One histogram series; label may be nullptr for an unlabelled metric
+     */
+    void appendHistogram(const char* name, const char* label, const char* value,
+                         const LatencyHistogram& histogram) {
+        LatencyHistogram::Snapshot snap;
+        histogram.snapshot(snap);
+        
+        char labels[32];
+        if (label) {
+            snprintf(labels, sizeof(labels), "%s=\"%s\",", label, value);
+        } else {
+            labels[0] = '\0';
+        }
+        
+        uint32_t cumulative = 0;
+        for (uint8_t i = 0; i < histogram.getBoundCount(); i++) {
+            cumulative += snap.buckets[i];
+            appendMetric("%s_bucket{%sle=\"%g\"} %lu\n", name, labels,
+                         histogram.getBound(i) / 1e6, (unsigned long)cumulative);
+        }
+        appendMetric("%s_bucket{%sle=\"+Inf\"} %lu\n", name, labels, (unsigned long)snap.count);
+        
+        if (label) {
+            labels[strlen(labels) - 1] = '\0'; // Drop the trailing comma
+            appendMetric("%s_sum{%s} %.6f\n", name, labels, snap.sum_us / 1e6);
+            appendMetric("%s_count{%s} %lu\n", name, labels, (unsigned long)snap.count);
+        } else {
+            appendMetric("%s_sum %.6f\n", name, snap.sum_us / 1e6);
+            appendMetric("%s_count %lu\n", name, (unsigned long)snap.count);
+        }
+    }
+    
+    /**
+     * Stage latency percentiles over the newest drawn samples, and how old
+     * the newest valid sample is
+     */
+    void appendPipelineMetrics() {
+        static const float quantiles[] = {0.5f, 0.9f, 0.99f};
+        static const char* const quantile_labels[] = {"0.5", "0.9", "0.99"};
+        const uint8_t n = sizeof(quantiles) / sizeof(quantiles[0]);
+        
+        appendHeader("foxmon_pipeline_latency_seconds", "gauge",
+                     "Sample latency per stage, percentiles over the newest drawn samples");
+        for (uint8_t i = 0; i < PIPELINE_STAGE_COUNT; i++) {
+            uint32_t us[n];
+            if (stats->pipeline[i].percentiles(quantiles, n, us) == 0) continue;
+            for (uint8_t q = 0; q < n; q++) {
+                appendMetric("foxmon_pipeline_latency_seconds{stage=\"%s\",quantile=\"%s\"} %.6f\n",
+                             PIPELINE_STAGE_NAMES[i], quantile_labels[q], us[q] / 1e6);
+            }
+        }
+        
+        uint32_t at = stats->last_sample_ms;
+        if (at != 0) {
+            appendHeader("foxmon_sample_age_seconds", "gauge", "Time since the newest valid sample");
+            appendMetric("foxmon_sample_age_seconds %.1f\n", (millis() - at) / 1000.0);
+        }
+    }
+    
+    /**
+     * Per-meter series, labelled meter="1".. in METER_URLS order
+     */
+    void appendMeterMetrics() {
+        uint8_t count = min(stats->meter_count, (uint8_t)METER_MAX);
+        unsigned long now = millis();
+        
+        appendHeader("foxmon_meter_power_watts", "gauge", "Active power of one meter (last valid sample)");
+        for (uint8_t i = 0; i < count; i++) {
+            appendMetric("foxmon_meter_power_watts{meter=\"%u\"} %.1f\n", i + 1, stats->meter_power_w[i]);
+        }
+        appendHeader("foxmon_meter_sample_age_seconds", "gauge", "Time since the meter's last valid sample");
+        for (uint8_t i = 0; i < count; i++) {
+            uint32_t at = stats->meter_sample_ms[i];
+            if (at == 0) continue; // Not reported yet
+            appendMetric("foxmon_meter_sample_age_seconds{meter=\"%u\"} %.1f\n", i + 1, (now - at) / 1000.0);
+        }
+        appendHeader("foxmon_meter_consecutive_failures", "gauge", "Failures since the meter's last valid sample");
+        for (uint8_t i = 0; i < count; i++) {
+            appendMetric("foxmon_meter_consecutive_failures{meter=\"%u\"} %ld\n", i + 1,
+                         (long)stats->meter_failures[i]);
+        }
+    }
+    
+    /**
+     * Fragmentation and stack headroom from the health monitor
+     */
+    void appendHealthMetrics() {
+        appendHeader("foxmon_heap_largest_free_block_min_bytes", "gauge",
+                     "Smallest largest-free-block seen since boot");
+        appendMetric("foxmon_heap_largest_free_block_min_bytes %lu\n",
+                     (unsigned long)stats->heap_largest_block_min);
+        appendHeader("foxmon_heap_allocated_blocks", "gauge", "Allocated heap blocks");
+        appendMetric("foxmon_heap_allocated_blocks %lu\n", (unsigned long)stats->heap_allocated_blocks);
+        appendHeader("foxmon_heap_free_blocks", "gauge", "Free heap fragments");
+        appendMetric("foxmon_heap_free_blocks %lu\n", (unsigned long)stats->heap_free_blocks);
+        appendHeader("foxmon_heap_growth_windows", "gauge",
+                     "Leak-check windows in a row whose fewest allocated blocks grew");
+        appendMetric("foxmon_heap_growth_windows %u\n", (unsigned)stats->heap_growth_windows);
+        appendHeader("foxmon_arena_bytes", "gauge", "Static buffer arena (band and DMA buffers)");
+        appendMetric("foxmon_arena_bytes %lu\n", (unsigned long)BufferArena::capacity());
+        
+        uint8_t count = min(stats->task_count, (uint8_t)HEALTH_MAX_TASKS);
+        appendHeader("foxmon_task_stack_free_bytes", "gauge", "Least unused stack seen per task");
+        for (uint8_t i = 0; i < count; i++) {
+            appendMetric("foxmon_task_stack_free_bytes{task=\"%s\"} %lu\n", stats->task_names[i],
+                         (unsigned long)stats->task_stack_free[i]);
+        }
+    }
+    
+    /**
+     * Uplink counters (ENABLE_TELEMETRY)
+     */
+    void appendTelemetryMetrics() {
+        appendHeader("foxmon_telemetry_batches_sent_total", "counter", "Telemetry batches accepted by the collector");
+        appendMetric("foxmon_telemetry_batches_sent_total %lu\n", (unsigned long)stats->telemetry_batches_sent);
+        appendHeader("foxmon_telemetry_send_failures_total", "counter", "Telemetry POSTs that failed");
+        appendMetric("foxmon_telemetry_send_failures_total %lu\n", (unsigned long)stats->telemetry_send_failures);
+        appendHeader("foxmon_telemetry_records_dropped_total", "counter",
+                     "Telemetry records overwritten while the collector was unreachable");
+        appendMetric("foxmon_telemetry_records_dropped_total %lu\n", (unsigned long)stats->telemetry_records_dropped);
+        appendHeader("foxmon_telemetry_backlog_records", "gauge", "Telemetry records waiting to be sent");
+        appendMetric("foxmon_telemetry_backlog_records %u\n", (unsigned)stats->telemetry_backlog);
+    }
+    
+    unsigned countStreamClients() {
+        unsigned n = 0;
+        for (uint8_t i = 0; i < METRICS_SSE_MAX_CLIENTS; i++) {
+            if (stream_clients[i].connected()) n++;
+        }
+        return n;
+    }
+};
+
+#endif // METRICS_SERVER_H
@@ -0,0 +1,324 @@
+/*
+ * Power History Store
+ * Delta-encoded ring buffers: last 10 minutes at 1 s, last 24 h at 1 min
+ */
+
+#ifndef POWER_HISTORY_H
+#define POWER_HISTORY_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "config.h"
+#include "types.h"
+
+// Fixed-point scales (values are stored as integers in these units)
+#define HISTORY_VOLTAGE_SCALE  10.0f    // 0.1 V
+#define HISTORY_CURRENT_SCALE  100.0f   // 0.01 A
+#define HISTORY_POWER_SCALE    1.0f     // 1 W
+
+#define HISTORY_CHANNELS       3        // voltage, current, power_active
+#define HISTORY_MAX_RECORD     (HISTORY_CHANNELS * 5)  // Worst-case varint bytes per sample
+
+/**
+ * One history sample in fixed point
+ */
+struct HistoryRecord {
+    int32_t value[HISTORY_CHANNELS];
+    
+    void fromPowerData(const PowerData& data) {
+        value[0] = lroundf(data.voltage * HISTORY_VOLTAGE_SCALE);
+        value[1] = lroundf(data.current * HISTORY_CURRENT_SCALE);
+        value[2] = lroundf(data.power_active * HISTORY_POWER_SCALE);
+    }
+    
+    void toPowerData(PowerData& data) const {
+        data.voltage = value[0] / HISTORY_VOLTAGE_SCALE;
+        data.current = value[1] / HISTORY_CURRENT_SCALE;
+        data.power_active = value[2] / HISTORY_POWER_SCALE;
+    }
+};
+
+/**
+ * Ring of fixed-size blocks. Each block starts with a full keyframe and
+ * stores following samples as zigzag varint deltas, so a steady reading
+ * costs one byte per channel. A block is closed when it holds BLOCK_SAMPLES
+ * samples or its byte pool is nearly full; the oldest block is then
+ * reused. BLOCK_BYTES sets the average budget, so large swings shorten the
+ * covered time instead of failing.
+ */
+template<uint8_t BLOCKS, uint8_t BLOCK_SAMPLES, uint16_t BLOCK_BYTES>
+class HistoryTier {
+public:
+    HistoryTier() {
+        clear();
+    }
+    
+    void clear() {
+        head = 0;
+        block_count = 0;
+        sample_count = 0;
+    }
+    
+    /**
+     * Append the newest sample
+     */
+    void append(const HistoryRecord& record) {
+        Block* block = block_count ? &blocks[head] : nullptr;
+        
+        if (!block || block->count >= BLOCK_SAMPLES ||
+            block->used + HISTORY_MAX_RECORD > BLOCK_BYTES) {
+            block = startBlock(record);
+        } else {
+            for (uint8_t c = 0; c < HISTORY_CHANNELS; c++) {
+                int32_t delta = record.value[c] - last.value[c];
+                block->used += writeVarint(block->data + block->used, zigzag(delta));
+            }
+            block->count++;
+            sample_count++;
+        }
+        
+        last = record;
+    }
+    
+    /**
+     * Number of samples currently stored
+     */
+    uint16_t size() const {
+        return sample_count;
+    }
+    
+    /**
+     * Latest sample (only valid if size() > 0)
+     */
+    const HistoryRecord& newest() const {
+        return last;
+    }
+    
+    /**
+     * Decode all samples from oldest to newest
+     * The callback takes (const HistoryRecord&) and returns false to stop
+     */
+    template<typename Callback>
+    void forEach(Callback callback) const {
+        for (uint8_t b = 0; b < block_count; b++) {
+            const Block& block = blocks[(head + BLOCKS - block_count + 1 + b) % BLOCKS];
+            if (!decodeBlock(block, callback)) return;
+        }
+    }
+    
+    /**
+     * Decode one block (0 = oldest); used to stream history in pieces
+     * Returns false if the callback stopped or the block does not exist
+     */
+    template<typename Callback>
+    bool forEachInBlock(uint8_t index, Callback callback) const {
+        if (index >= block_count) return false;
+        return decodeBlock(blocks[(head + BLOCKS - block_count + 1 + index) % BLOCKS], callback);
+    }
+    
+    uint8_t blockCount() const {
+        return block_count;
+    }
+    
+    /**
+     * Most samples in one block
+     */
+    static constexpr uint8_t blockSamples() {
+        return BLOCK_SAMPLES;
+    }
+    
+    /**
+     * Most samples the tier can hold
+     */
+    static constexpr uint16_t capacity() {
+        return (uint16_t)BLOCKS * BLOCK_SAMPLES;
+    }
+    
+    /**
+     * Bytes of RAM used by this tier
+     */
+    static constexpr size_t memoryUsage() {
+        return sizeof(HistoryTier);
+    }
+
+private:
+    struct Block {
+        HistoryRecord key;      // First sample, stored in full
+        uint8_t count;          // Samples in this block incl. the keyframe
+        uint16_t used;          // Bytes used in data
+        uint8_t data[BLOCK_BYTES];
+    };
+    
+    Block blocks[BLOCKS];
+    uint8_t head;               // Block currently being written
+    uint8_t block_count;        // Blocks in use
+    uint16_t sample_count;      // Samples across all blocks in use
+    HistoryRecord last;         // Newest sample (delta base)
+    
+    Block* startBlock(const HistoryRecord& record) {
+        if (block_count > 0) {
+            head = (head + 1) % BLOCKS;
+        }
+        if (block_count < BLOCKS) {
+            block_count++;
+        } else {
+            sample_count -= blocks[head].count; // Oldest block is overwritten
+        }
+        
+        Block* block = &blocks[head];
+        block->key = record;
+        block->count = 1;
+        block->used = 0;
+        sample_count++;
+        return block;
+    }
+    
+    template<typename Callback>
+    static bool decodeBlock(const Block& block, Callback callback) {
+        HistoryRecord record = block.key;
+        if (!callback(record)) return false;
+        
+        const uint8_t* p = block.data;
+        for (uint8_t i = 1; i < block.count; i++) {
+            for (uint8_t c = 0; c < HISTORY_CHANNELS; c++) {
+                record.value[c] += unzigzag(readVarint(p));
+            }
+            if (!callback(record)) return false;
+        }
+        return true;
+    }
+    
+    static uint32_t zigzag(int32_t v) {
+        return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+    }
+    
+    static int32_t unzigzag(uint32_t v) {
+        return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+    }
+    
+    static uint8_t writeVarint(uint8_t* out, uint32_t v) {
+        uint8_t n = 0;
+        while (v >= 0x80) {
+            out[n++] = (uint8_t)(v | 0x80);
+            v >>= 7;
+        }
+        out[n++] = (uint8_t)v;
+        return n;
+    }
+    
+    static uint32_t readVarint(const uint8_t*& p) {
+        uint32_t v = 0;
+        uint8_t shift = 0;
+        uint8_t b;
+        do {
+            b = *p++;
+            v |= (uint32_t)(b & 0x7F) << shift;
+            shift += 7;
+        } while (b & 0x80);
+        return v;
+    }
+};
+
+// 10 min at 1 s: 10 blocks of 60 s, ~3.3 bytes per sample budget (~2.2 KB)
+typedef HistoryTier<10, 60, 200> SecondHistory;
+// 24 h at 1 min: 24 blocks of 60 min, ~4.8 bytes per sample budget (~7.3 KB)
+typedef HistoryTier<24, 60, 288> MinuteHistory;
+
+/**
+ * Two-tier power history fed once per second
+ * Minute samples are the average of the seconds in that minute
+ */
+class PowerHistory {
+public:
+    PowerHistory() :
+        minute_ticks(0),
+        newest_time(0),
+        mutex(nullptr) {
+        memset(minute_sum, 0, sizeof(minute_sum));
+    }
+    
+    /**
+     * Create the lock used when other tasks read the history
+     */
+    void begin() {
+        mutex = xSemaphoreCreateMutex();
+    }
+    
+    /**
+     * Guard reads from other tasks (tick() takes the lock itself)
+     */
+    void lock() {
+        if (mutex) xSemaphoreTake(mutex, portMAX_DELAY);
+    }
+    
+    void unlock() {
+        if (mutex) xSemaphoreGive(mutex);
+    }
+    
+    /**
+     * Record one second (call once per wall-clock second with the
+     * latest valid reading)
+     */
+    void tick(const PowerData& data, time_t now) {
+        HistoryRecord record;
+        record.fromPowerData(data);
+        
+        lock();
+        seconds.append(record);
+        newest_time = now;
+        
+        for (uint8_t c = 0; c < HISTORY_CHANNELS; c++) {
+            minute_sum[c] += record.value[c];
+        }
+        
+        if (++minute_ticks >= 60) {
+            HistoryRecord average;
+            for (uint8_t c = 0; c < HISTORY_CHANNELS; c++) {
+                average.value[c] = (int32_t)(minute_sum[c] / minute_ticks);
+                minute_sum[c] = 0;
+            }
+            minutes.append(average);
+            minute_ticks = 0;
+        }
+        unlock();
+    }
+    
+    const SecondHistory& getSeconds() const {
+        return seconds;
+    }
+    
+    const MinuteHistory& getMinutes() const {
+        return minutes;
+    }
+    
+    /**
+     * Wall-clock time of the newest second sample
+     * Sample k back from the newest is at newest - k (seconds tier) and
+     * the minute tier ends at the last completed minute
+     */
+    time_t getNewestTime() const {
+        return newest_time;
+    }
+    
+    /**
+     * Seconds accumulated into the minute currently being averaged
+     */
+    uint8_t getPendingSeconds() const {
+        return minute_ticks;
+    }
+    
+    static constexpr size_t memoryUsage() {
+        return sizeof(PowerHistory);
+    }
+
+private:
+    SecondHistory seconds;
+    MinuteHistory minutes;
+    int64_t minute_sum[HISTORY_CHANNELS];
+    uint8_t minute_ticks;
+    time_t newest_time;
+    SemaphoreHandle_t mutex;
+};
+
+#endif // POWER_HISTORY_H
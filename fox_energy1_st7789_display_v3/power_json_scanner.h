@@ -0,0 +1,231 @@
+/*
+ * Streaming Key Scanner for the Fox energy1 Payload
+ * Extracts voltage/current/power_active byte by byte, without allocations
+ */
+
+#ifndef POWER_JSON_SCANNER_H
+#define POWER_JSON_SCANNER_H
+
+#include <Arduino.h>
+#include <stdlib.h>
+#include "types.h"
+
+#define SCANNER_KEY_MAX    16   // Longer keys are skipped (none of ours are)
+#define SCANNER_VALUE_MAX  16   // Enough for any float the meter sends
+
+#define SCANNER_FOUND_VOLTAGE  0x1
+#define SCANNER_FOUND_CURRENT  0x2
+#define SCANNER_FOUND_POWER    0x4
+#define SCANNER_FOUND_ALL      0x7
+
+/**
+ * Minimal JSON scanner for a flat object of numbers or numeric strings.
+ * Bytes are fed one at a time, so it works on a network stream as well as
+ * on a datagram buffer. Only the three wanted values are ever buffered;
+ * everything else is skipped. Values may be bare numbers or quoted
+ * strings ("230.5"). Nested objects are scanned for keys as well.
+ */
+class PowerJsonScanner {
+public:
+    PowerJsonScanner() {
+        reset();
+    }
+    
+    /**
+     * Start a new document
+     */
+    void reset() {
+        state = SEEK_KEY;
+        key_len = 0;
+        value_len = 0;
+        key_overflow = false;
+        escaped = false;
+        field = FIELD_NONE;
+        found = 0;
+        voltage = current = power_active = 0;
+    }
+    
+    /**
+     * Feed one byte
+     * Returns true once all three fields have been found
+     */
+    bool feed(char c) {
+        switch (state) {
+            case SEEK_KEY:
+                if (c == '"') {
+                    state = IN_KEY;
+                    key_len = 0;
+                    key_overflow = false;
+                    escaped = false;
+                }
+                break;
+            
+            case IN_KEY:
+                if (escaped) {
+                    escaped = false;
+                    key_overflow = true; // None of our keys contain escapes
+                } else if (c == '\\') {
+                    escaped = true;
+                } else if (c == '"') {
+                    key[key_len] = '\0';
+                    field = key_overflow ? FIELD_NONE : lookupField(key);
+                    state = AFTER_KEY;
+                } else if (key_len < SCANNER_KEY_MAX - 1) {
+                    key[key_len++] = c;
+                } else {
+                    key_overflow = true;
+                }
+                break;
+            
+            case AFTER_KEY:
+                if (c == ':') {
+                    state = BEFORE_VALUE;
+                } else if (!isSpace(c)) {
+                    state = SEEK_KEY; // Was a string in an array, not a key
+                }
+                break;
+            
+            case BEFORE_VALUE:
+                if (isSpace(c)) break;
+                value_len = 0;
+                if (c == '"') {
+                    state = IN_STRING_VALUE;
+                    escaped = false;
+                } else if (c == '{' || c == '[') {
+                    state = SEEK_KEY;
+                } else {
+                    state = IN_BARE_VALUE;
+                    appendValue(c);
+                }
+                break;
+            
+            case IN_STRING_VALUE:
+                if (escaped) {
+                    escaped = false;
+                    appendValue(c);
+                } else if (c == '\\') {
+                    escaped = true;
+                } else if (c == '"') {
+                    finishValue();
+                } else {
+                    appendValue(c);
+                }
+                break;
+            
+            case IN_BARE_VALUE:
+                if (c == ',' || c == '}' || c == ']' || isSpace(c)) {
+                    finishValue();
+                } else {
+                    appendValue(c);
+                }
+                break;
+        }
+        
+        return found == SCANNER_FOUND_ALL;
+    }
+    
+    /**
+     * Feed a buffer
+     * Returns true once all three fields have been found
+     */
+    bool feed(const char* data, size_t len) {
+        for (size_t i = 0; i < len; i++) {
+            if (feed(data[i])) return true;
+        }
+        return isComplete();
+    }
+    
+    bool isComplete() {
+        return found == SCANNER_FOUND_ALL;
+    }
+    
+    /**
+     * Bitmask of SCANNER_FOUND_* for diagnostics
+     */
+    uint8_t getFound() {
+        return found;
+    }
+    
+    /**
+     * Copy the extracted values (only meaningful when complete)
+     */
+    void getData(PowerData& data) {
+        data.voltage = voltage;
+        data.current = current;
+        data.power_active = power_active;
+    }
+
+private:
+    enum State : uint8_t {
+        SEEK_KEY,
+        IN_KEY,
+        AFTER_KEY,
+        BEFORE_VALUE,
+        IN_STRING_VALUE,
+        IN_BARE_VALUE
+    };
+    
+    enum Field : uint8_t {
+        FIELD_NONE,
+        FIELD_VOLTAGE,
+        FIELD_CURRENT,
+        FIELD_POWER
+    };
+    
+    State state;
+    Field field;
+    char key[SCANNER_KEY_MAX];
+    char value[SCANNER_VALUE_MAX];
+    uint8_t key_len;
+    uint8_t value_len;
+    bool key_overflow;
+    bool escaped;
+    uint8_t found;
+    float voltage;
+    float current;
+    float power_active;
+    
+    static bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+    
+    static Field lookupField(const char* name) {
+        if (strcmp(name, "voltage") == 0) return FIELD_VOLTAGE;
+        if (strcmp(name, "current") == 0) return FIELD_CURRENT;
+        if (strcmp(name, "power_active") == 0) return FIELD_POWER;
+        return FIELD_NONE;
+    }
+    
+    void appendValue(char c) {
+        // Only wanted values are buffered; an overlong one fails to parse
+        if (field == FIELD_NONE) return;
+        if (value_len < SCANNER_VALUE_MAX - 1) {
+            value[value_len++] = c;
+        } else {
+            field = FIELD_NONE;
+        }
+    }
+    
+    /**
+     * Convert the buffered value if it is a complete number
+     */
+    void finishValue() {
+        state = SEEK_KEY;
+        if (field == FIELD_NONE || value_len == 0) return;
+        
+        value[value_len] = '\0';
+        char* end;
+        float parsed = strtof(value, &end);
+        if (*end != '\0') return; // null, true, "n/a", ...
+        
+        switch (field) {
+            case FIELD_VOLTAGE: voltage = parsed;      found |= SCANNER_FOUND_VOLTAGE; break;
+            case FIELD_CURRENT: current = parsed;      found |= SCANNER_FOUND_CURRENT; break;
+            case FIELD_POWER:   power_active = parsed; found |= SCANNER_FOUND_POWER;   break;
+            default: break;
+        }
+        field = FIELD_NONE;
+    }
+};
+
+#endif // POWER_JSON_SCANNER_H
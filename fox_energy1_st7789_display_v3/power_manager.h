@@ -0,0 +1,201 @@
+/*
+ * Power Manager
+ * Modem sleep, light sleep between frames and backlight dimming for
+ * battery-powered units, plus a running estimate of the current draw
+ * The loop decides when a sleep is safe; this class only performs it.
+ */
+
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_sleep.h>
+#include <time.h>
+#include "config.h"
+#include "firmware_stats.h"
+
+#define POWER_SLEEP_MAX_REJECTS  5   // Failed sleeps in a row before light sleep is turned off
+
+class PowerManager {
+public:
+    PowerManager() :
+        light_sleep(ENABLE_POWER_SAVE && POWER_LIGHT_SLEEP),
+        sleep_rejects(0),
+        backlight_level(BACKLIGHT_LEVEL_ACTIVE),
+        last_activity(0),
+        last_update(0),
+        sleep_ms(0),
+        accounted_sleep_ms(0),
+        charge_mas(0),
+        elapsed_ms(0),
+        stats(nullptr) {}
+    
+    /**
+     * Publish sleep time, backlight level and the current estimate (may be nullptr)
+     */
+    void setStats(FirmwareStats* firmware_stats) {
+        stats = firmware_stats;
+    }
+    
+    /**
+     * Set up the backlight PWM and the CPU clock
+     * Call after WiFiManager::begin() (modem sleep needs the STA interface)
+     */
+    void begin() {
+        if (TFT_BL >= 0) {
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+            ledcAttach(TFT_BL, BACKLIGHT_PWM_FREQ, BACKLIGHT_PWM_BITS);
+#else
+            ledcSetup(0, BACKLIGHT_PWM_FREQ, BACKLIGHT_PWM_BITS);
+            ledcAttachPin(TFT_BL, 0);
+#endif
+            writeBacklight(BACKLIGHT_LEVEL_ACTIVE);
+        }
+        
+        if (ENABLE_POWER_SAVE) {
+            // Radio sleeps between DTIM beacons; the AP buffers frames meanwhile
+            WiFi.setSleep(WIFI_PS_MIN_MODEM);
+            setCpuFrequencyMhz(POWER_CPU_FREQ_MHZ);
+            Serial.printf("Power save: modem sleep, CPU %lu MHz, light sleep %s\n",
+                         (unsigned long)getCpuFrequencyMhz(), light_sleep ? "on" : "off");
+        }
+        
+        last_activity = last_update = millis();
+        publish();
+    }
+    
+    /**
+     * Something worth looking at happened (a large power step)
+     */
+    void noteActivity(unsigned long now) {
+        last_activity = now;
+    }
+    
+    /**
+     * Once per second: pick the backlight level and account the current
+     * timeinfo: local time, nullptr until NTP has synced
+     */
+    void update(const struct tm* timeinfo, unsigned long now) {
+        if (TFT_BL >= 0) {
+            uint8_t level = BACKLIGHT_LEVEL_ACTIVE;
+            if (now - last_activity >= BACKLIGHT_IDLE_MS) {
+                level = BACKLIGHT_LEVEL_IDLE;
+            }
+            if (timeinfo && isNight(timeinfo->tm_hour)) {
+                level = min(level, (uint8_t)BACKLIGHT_LEVEL_NIGHT);
+            }
+            if (level != backlight_level) {
+                Serial.printf("Backlight: %u -> %u\n", backlight_level, level);
+                writeBacklight(level);
+            }
+        }
+        
+        accountCurrent(now);
+        publish();
+    }
+    
+    bool isLightSleepEnabled() {
+        return light_sleep;
+    }
+    
+    /**
+     * Light sleep for up to ms (timer wakeup)
+     * Returns false without sleeping if the gap is too short or the
+     * chip refused; the caller then waits awake as usual. Task timeouts
+     * run on the RTOS tick, which may not advance across the sleep.
+     */
+    bool lightSleep(uint32_t ms) {
+        if (!light_sleep || ms < POWER_LIGHT_SLEEP_MIN_MS) return false;
+        
+        Serial.flush(); // The UART is clock-gated while asleep
+        esp_sleep_enable_timer_wakeup((uint64_t)ms * 1000ULL);
+        
+        unsigned long start = millis();
+        esp_err_t err = esp_light_sleep_start();
+        if (err != ESP_OK) {
+            if (++sleep_rejects >= POWER_SLEEP_MAX_REJECTS) {
+                light_sleep = false;
+                Serial.printf("Light sleep rejected (%d), disabled\n", (int)err);
+            }
+            return false;
+        }
+        
+        sleep_rejects = 0;
+        sleep_ms += millis() - start;
+        if (stats) stats->light_sleeps++;
+        return true;
+    }
+    
+    /**
+     * Estimated average draw since boot
+     */
+    float getAverageCurrent() {
+        return elapsed_ms > 0 ? (float)(charge_mas * 1000.0 / elapsed_ms) : 0.0f;
+    }
+    
+    /**
+     * One line for the profiler window
+     */
+    void printReport() {
+        Serial.printf("power: ~%.1f mA avg, light sleep %lu ms, backlight %u\n",
+                     getAverageCurrent(), (unsigned long)sleep_ms, backlight_level);
+    }
+
+private:
+    bool light_sleep;
+    int sleep_rejects;
+    uint8_t backlight_level;
+    unsigned long last_activity;
+    unsigned long last_update;
+    uint32_t sleep_ms;             // Total time in light sleep
+    uint32_t accounted_sleep_ms;   // Part of sleep_ms already in charge_mas
+    double charge_mas;             // Estimated charge since boot (mA * s)
+    uint64_t elapsed_ms;
+    FirmwareStats* stats;
+    
+    static bool isNight(int hour) {
+        if (BACKLIGHT_NIGHT_START <= BACKLIGHT_NIGHT_END) {
+            return hour >= BACKLIGHT_NIGHT_START && hour < BACKLIGHT_NIGHT_END;
+        }
+        return hour >= BACKLIGHT_NIGHT_START || hour < BACKLIGHT_NIGHT_END; // Spans midnight
+    }
+    
+    void writeBacklight(uint8_t level) {
+        backlight_level = level;
+        uint32_t duty = ((uint32_t)level * ((1UL << BACKLIGHT_PWM_BITS) - 1)) / 255;
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+        ledcWrite(TFT_BL, duty);
+#else
+        ledcWrite(0, duty);
+#endif
+    }
+    
+    /**
+     * Integrate the per-state currents over the time since the last call
+     */
+    void accountCurrent(unsigned long now) {
+        uint32_t span = now - last_update;
+        last_update = now;
+        
+        uint32_t asleep = min(sleep_ms - accounted_sleep_ms, span);
+        accounted_sleep_ms = sleep_ms;
+        uint32_t awake = span - asleep;
+        
+        float awake_ma = ENABLE_POWER_SAVE ? POWER_EST_MODEM_SLEEP_MA : POWER_EST_AWAKE_MA;
+        float backlight_ma = POWER_EST_BACKLIGHT_MA * backlight_level / 255.0f;
+        
+        charge_mas += (awake * awake_ma + asleep * POWER_EST_LIGHT_SLEEP_MA +
+                       span * (POWER_EST_PANEL_MA + backlight_ma)) / 1000.0;
+        elapsed_ms += span;
+    }
+    
+    void publish() {
+        if (!stats) return;
+        stats->light_sleep_ms = sleep_ms;
+        stats->backlight_level = backlight_level;
+        stats->current_estimate_ma = getAverageCurrent();
+    }
+};
+
+#endif // POWER_MANAGER_H
@@ -0,0 +1,247 @@
+/*
+ * Cycle-Counter Profiler (development builds)
+ * Per-window min/avg/max/p99 of render, flush and fetch sections
+ * With ENABLE_PROFILER false every PROFILE_* macro compiles to nothing
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include "config.h"
+
+#define PROFILER_MAX_WIDGETS  12    // Widget slots reserved for DisplayManager
+#define PROFILER_BUCKETS      124   // Quarter-octave buckets over 32-bit cycle counts
+
+/**
+ * Timed sections
+ */
+enum ProfileSlot {
+    PROF_RENDER,        // One dirty render pass
+    PROF_FLUSH,         // One band rectangle pushed to the panel
+    PROF_FETCH,         // fetchPowerData() end to end
+    PROF_PARSE,         // Response body read and parsed
+    PROF_WIDGET_BASE,   // + WidgetId: one widget drawn into one band
+    PROF_SLOT_COUNT = PROF_WIDGET_BASE + PROFILER_MAX_WIDGETS
+};
+
+/**
+ * Plain counters summed per window
+ */
+enum ProfileCounter {
+    PROF_PIXELS_PUSHED,
+    PROF_COUNTER_COUNT
+};
+
+/**
+ * Results of the last completed window (microseconds)
+ */
+struct ProfileSummary {
+    uint32_t count;
+    float min_us;
+    float avg_us;
+    float max_us;
+    float p99_us;       // Upper edge of the p99 bucket (within ~19%)
+};
+
+class Profiler {
+public:
+    Profiler() :
+        window_start(0),
+        window_ms(0) {
+        mux = portMUX_INITIALIZER_UNLOCKED;
+        memset(windows, 0, sizeof(windows));
+        memset(counters, 0, sizeof(counters));
+        memset(last_counters, 0, sizeof(last_counters));
+        memset(summaries, 0, sizeof(summaries));
+        for (int i = 0; i < PROF_SLOT_COUNT; i++) {
+            windows[i].min = UINT32_MAX;
+            names[i] = nullptr;
+        }
+        names[PROF_RENDER] = "render";
+        names[PROF_FLUSH] = "flush";
+        names[PROF_FETCH] = "fetch";
+        names[PROF_PARSE] = "parse";
+    }
+    
+    static uint32_t now() {
+        return ESP.getCycleCount();
+    }
+    
+    void record(int slot, uint32_t cycles) {
+        uint8_t bucket = bucketOf(cycles);
+        
+        portENTER_CRITICAL(&mux);
+        Window& w = windows[slot];
+        w.count++;
+        w.sum += cycles;
+        if (cycles < w.min) w.min = cycles;
+        if (cycles > w.max) w.max = cycles;
+        if (w.buckets[bucket] < UINT16_MAX) w.buckets[bucket]++;
+        portEXIT_CRITICAL(&mux);
+    }
+    
+    void count(int counter, uint32_t n) {
+        portENTER_CRITICAL(&mux);
+        counters[counter] += n;
+        portEXIT_CRITICAL(&mux);
+    }
+    
+    /**
+     * Name a slot for the report (widget slots are unnamed by default)
+     */
+    void setName(int slot, const char* name) {
+        names[slot] = name;
+    }
+    
+    /**
+     * Close the window if PROFILER_REPORT_MS has passed: summarise every
+     * slot, print the table and start a new window
+     * Returns true when a new summary is available
+     */
+    bool report(unsigned long now_ms) {
+        if (now_ms - window_start < PROFILER_REPORT_MS) return false;
+        window_ms = now_ms - window_start;
+        window_start = now_ms;
+        
+        for (int i = 0; i < PROF_SLOT_COUNT; i++) {
+            Window w;
+            portENTER_CRITICAL(&mux);
+            w = windows[i];
+            memset(&windows[i], 0, sizeof(Window));
+            windows[i].min = UINT32_MAX;
+            portEXIT_CRITICAL(&mux);
+            summarise(w, summaries[i]);
+        }
+        portENTER_CRITICAL(&mux);
+        memcpy(last_counters, counters, sizeof(counters));
+        memset(counters, 0, sizeof(counters));
+        portEXIT_CRITICAL(&mux);
+        
+        print();
+        return true;
+    }
+    
+    const ProfileSummary& getSummary(int slot) const {
+        return summaries[slot];
+    }
+    
+    uint32_t getCounter(int counter) const {
+        return last_counters[counter];
+    }
+
+private:
+    struct Window {
+        uint32_t count;
+        uint64_t sum;
+        uint32_t min;
+        uint32_t max;
+        uint16_t buckets[PROFILER_BUCKETS];
+    };
+    
+    portMUX_TYPE mux;
+    Window windows[PROF_SLOT_COUNT];
+    ProfileSummary summaries[PROF_SLOT_COUNT];
+    const char* names[PROF_SLOT_COUNT];
+    uint32_t counters[PROF_COUNTER_COUNT];
+    uint32_t last_counters[PROF_COUNTER_COUNT];
+    unsigned long window_start;
+    unsigned long window_ms;
+    
+    /**
+     * 0..3 exact, then four buckets per power of two
+     */
+    static uint8_t bucketOf(uint32_t cycles) {
+        if (cycles < 4) return cycles;
+        int msb = 31 - __builtin_clz(cycles);
+        return 4 + (msb - 2) * 4 + ((cycles >> (msb - 2)) & 3);
+    }
+    
+    static uint32_t bucketUpper(uint8_t bucket) {
+        if (bucket < 4) return bucket;
+        int shift = (bucket - 4) / 4;
+        uint32_t lower = (uint32_t)(4 + (bucket - 4) % 4) << shift;
+        return lower + ((1UL << shift) - 1);
+    }
+    
+    static void summarise(const Window& w, ProfileSummary& out) {
+        float cycles_per_us = ESP.getCpuFreqMHz();
+        out.count = w.count;
+        if (w.count == 0) {
+            out.min_us = out.avg_us = out.max_us = out.p99_us = 0;
+            return;
+        }
+        
+        uint32_t target = w.count - w.count / 100; // Samples at or below p99
+        uint32_t seen = 0;
+        uint32_t p99 = w.max;
+        for (int b = 0; b < PROFILER_BUCKETS; b++) {
+            seen += w.buckets[b];
+            if (seen >= target) {
+                p99 = min(bucketUpper(b), w.max);
+                break;
+            }
+        }
+        
+        out.min_us = w.min / cycles_per_us;
+        out.avg_us = (float)(w.sum / w.count) / cycles_per_us;
+        out.max_us = w.max / cycles_per_us;
+        out.p99_us = p99 / cycles_per_us;
+    }
+    
+    void print() {
+        Serial.printf("--- profile %lu ms ---\n", window_ms);
+        Serial.println("section      count    min_us    avg_us    max_us    p99_us");
+        for (int i = 0; i < PROF_SLOT_COUNT; i++) {
+            const ProfileSummary& s = summaries[i];
+            if (s.count == 0 || !names[i]) continue;
+            Serial.printf("%-10s %7lu %9.1f %9.1f %9.1f %9.1f\n", names[i],
+                         (unsigned long)s.count, s.min_us, s.avg_us, s.max_us, s.p99_us);
+        }
+        Serial.printf("pixels pushed: %lu\n", (unsigned long)last_counters[PROF_PIXELS_PUSHED]);
+    }
+};
+
+#if ENABLE_PROFILER
+
+inline Profiler& profiler() {
+    static Profiler instance;
+    return instance;
+}
+
+/**
+ * Times the enclosing scope into a slot
+ */
+class ProfileScope {
+public:
+    explicit ProfileScope(int profile_slot) :
+        slot(profile_slot),
+        start(Profiler::now()) {}
+    
+    ~ProfileScope() {
+        profiler().record(slot, Profiler::now() - start);
+    }
+
+private:
+    int slot;
+    uint32_t start;
+};
+
+#define PROFILE_CONCAT_(a, b)       a##b
+#define PROFILE_CONCAT(a, b)        PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(slot)         ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(slot)
+#define PROFILE_COUNT(counter, n)   profiler().count((counter), (n))
+#define PROFILE_NAME(slot, name)    profiler().setName((slot), (name))
+#define PROFILE_REPORT(now_ms)      profiler().report(now_ms)
+
+#else
+
+#define PROFILE_SCOPE(slot)         ((void)0)
+#define PROFILE_COUNT(counter, n)   ((void)0)
+#define PROFILE_NAME(slot, name)    ((void)0)
+#define PROFILE_REPORT(now_ms)      false
+
+#endif // ENABLE_PROFILER
+
+#endif // PROFILER_H
@@ -0,0 +1,130 @@
+/*
+ * Reading Cache
+ * Keeps the last valid reading across resets so the dashboard can show
+ * it (grayed out) in the first frame, before WiFi and the meter are up
+ */
+
+#ifndef READING_CACHE_H
+#define READING_CACHE_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <esp_attr.h>
+#include <time.h>
+#include "config.h"
+#include "types.h"
+
+#define READING_NVS_KEY      "reading"
+#define READING_CACHE_MAGIC  0x46524331  // "FRC1"
+
+/**
+ * One cached reading (RTC memory and the NVS blob share the layout)
+ * Plain fields only: a constructor would run at boot and wipe the RTC copy
+ */
+struct CachedReading {
+    uint32_t magic;
+    float voltage;
+    float current;
+    float power_active;
+    int64_t time;           // Unix time of the reading, 0 if the clock was not set
+};
+
+// Survives software, watchdog and brownout resets (not a power cycle)
+RTC_NOINIT_ATTR static CachedReading rtc_reading;
+
+/**
+ * Every valid sample goes to RTC memory (free to write); NVS gets a copy
+ * every READING_CHECKPOINT_MS for boots after a power cut. A few writes
+ * per hour, like the energy checkpoints.
+ */
+class ReadingCache {
+public:
+    ReadingCache() :
+        prefs(nullptr),
+        last_checkpoint(0),
+        dirty(false) {}
+    
+    /**
+     * prefs must stay open for the lifetime of the cache (may be nullptr)
+     */
+    void begin(Preferences* preferences) {
+        prefs = preferences;
+        last_checkpoint = millis();
+    }
+    
+    /**
+     * Last reading from before this boot; RTC memory wins over NVS
+     * Returns false if neither holds one
+     */
+    bool restore(PowerData& power) {
+        CachedReading cached = rtc_reading;
+        const char* source = "RTC";
+        
+        if (!isValid(cached)) {
+            source = "NVS";
+            if (!prefs || prefs->getBytes(READING_NVS_KEY, &cached, sizeof(cached)) != sizeof(cached) ||
+                !isValid(cached)) {
+                return false;
+            }
+        }
+        
+        power = PowerData(cached.voltage, cached.current, cached.power_active);
+        time_t now = time(nullptr);
+        if (cached.time > 0 && now >= cached.time) {
+            Serial.printf("Last reading from %s: P=%.1fW, %ld s old\n", source, power.power_active,
+                         (long)(now - cached.time));
+        } else {
+            Serial.printf("Last reading from %s: P=%.1fW\n", source, power.power_active);
+        }
+        return true;
+    }
+    
+    /**
+     * Remember a valid sample (call once per sample)
+     */
+    void update(const PowerData& power, unsigned long now_ms) {
+        time_t now = time(nullptr);
+        rtc_reading.magic = READING_CACHE_MAGIC;
+        rtc_reading.voltage = power.voltage;
+        rtc_reading.current = power.current;
+        rtc_reading.power_active = power.power_active;
+        rtc_reading.time = now > 1600000000 ? now : 0;
+        dirty = true;
+        
+        if (prefs && now_ms - last_checkpoint >= READING_CHECKPOINT_MS) {
+            checkpoint(now_ms);
+        }
+    }
+    
+    /**
+     * Write the newest reading to NVS now (if there is one since the last write)
+     */
+    void checkpoint(unsigned long now_ms) {
+        last_checkpoint = now_ms;
+        if (!prefs || !dirty) return;
+        
+        if (prefs->putBytes(READING_NVS_KEY, &rtc_reading, sizeof(rtc_reading)) == sizeof(rtc_reading)) {
+            dirty = false;
+        } else {
+            Serial.println("Reading checkpoint write failed");
+        }
+    }
+
+private:
+    Preferences* prefs;
+    unsigned long last_checkpoint;
+    bool dirty;
+    
+    /**
+     * RTC memory holds noise after a power cycle; the magic and the
+     * DataFetcher ranges (which NaN fails too) keep it from being shown
+     */
+    static bool isValid(const CachedReading& c) {
+        return c.magic == READING_CACHE_MAGIC &&
+               c.voltage >= 0 && c.voltage <= 500 &&
+               c.current >= 0 && c.current <= 100 &&
+               c.power_active >= 0 && c.power_active <= 50000;
+    }
+};
+
+#endif // READING_CACHE_H
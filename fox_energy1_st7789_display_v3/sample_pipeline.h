@@ -0,0 +1,119 @@
+/*
+ * Sample Pipeline
+ * Follows the newest sample from its request to the pixels on the panel
+ * and records every stage in the FirmwareStats sliding windows, so
+ * /metrics shows where the time between the meter and the screen goes.
+ */
+
+#ifndef SAMPLE_PIPELINE_H
+#define SAMPLE_PIPELINE_H
+
+#include <Arduino.h>
+#include <esp_attr.h>
+#include "config.h"
+#include "types.h"
+#include "firmware_stats.h"
+
+/**
+ * UI-side end of the pipeline; the fetch task stamps the first stages
+ * into PowerSample::timing. Only samples that are drawn are recorded.
+ */
+class SamplePipeline {
+public:
+    SamplePipeline() :
+        stats(nullptr),
+        taken_us(0),
+        drawn_taken_us(0),
+        rendered_us(0),
+        flushed_us(0),
+        pending(false) {}
+    
+    /**
+     * Record the stage latencies (may be nullptr)
+     */
+    void setStats(FirmwareStats* firmware_stats) {
+        stats = firmware_stats;
+    }
+    
+    /**
+     * For DisplayManager::setFlushCompleteCallback(), arg = this pipeline
+     * Runs in interrupt context
+     */
+    static void IRAM_ATTR onFlushComplete(void* arg) {
+        static_cast<SamplePipeline*>(arg)->flushed_us = micros();
+    }
+    
+    /**
+     * The UI loop took a valid sample off the queue
+     * Of several samples in one frame, the last one taken is the one drawn
+     */
+    void taken(const PowerSample& sample) {
+        next = sample.timing;
+        taken_us = micros();
+    }
+    
+    /**
+     * The sample taken last is rasterised
+     * flushing: DMA transfers are still on their way to the panel
+     */
+    void rendered(bool flushing) {
+        // A previous record still waiting for its flush ends here
+        if (pending) {
+            finish(flushDoneUs());
+        }
+        
+        drawn = next;
+        drawn_taken_us = taken_us;
+        rendered_us = micros();
+        if (flushing) {
+            pending = true;
+        } else {
+            finish(rendered_us);
+        }
+    }
+    
+    /**
+     * Call every frame: completes the record once its flush has drained
+     */
+    void update(bool flushing) {
+        if (pending && !flushing) {
+            finish(flushDoneUs());
+        }
+    }
+
+private:
+    FirmwareStats* stats;
+    SampleTiming next;                  // Taken, not drawn yet
+    SampleTiming drawn;                 // Waiting for its flush
+    uint32_t taken_us;
+    uint32_t drawn_taken_us;
+    uint32_t rendered_us;
+    volatile uint32_t flushed_us;       // Last DMA completion (ISR)
+    bool pending;
+    
+    /**
+     * End of the drawn frame's flush; a completion stamped before the
+     * render belongs to an earlier pass (nothing was left to transfer)
+     */
+    uint32_t flushDoneUs() {
+        uint32_t done = flushed_us;
+        return (int32_t)(done - rendered_us) > 0 ? done : rendered_us;
+    }
+    
+    void finish(uint32_t done_us) {
+        pending = false;
+        if (!stats) return;
+        
+        // Push mode has no request phase: the datagram arrives unasked
+        if (DATA_TRANSPORT == TRANSPORT_HTTP_POLL) {
+            stats->pipeline[STAGE_REQUEST].record(drawn.first_byte_us - drawn.request_us);
+        }
+        stats->pipeline[STAGE_PARSE].record(drawn.parsed_us - drawn.first_byte_us);
+        stats->pipeline[STAGE_QUEUE].record(drawn_taken_us - drawn.parsed_us);
+        stats->pipeline[STAGE_RENDER].record(rendered_us - drawn_taken_us);
+        stats->pipeline[STAGE_FLUSH].record(done_us - rendered_us);
+        stats->pipeline[STAGE_TOTAL].record(done_us - drawn.request_us);
+    }
+};
+
+#endif // SAMPLE_PIPELINE_H
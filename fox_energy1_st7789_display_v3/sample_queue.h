@@ -0,0 +1,77 @@
+/*
+ * Lock-free Single-Producer/Single-Consumer Ring
+ * Hands samples from the fetch task to the UI loop without locking
+ */
+
+#ifndef SAMPLE_QUEUE_H
+#define SAMPLE_QUEUE_H
+
+#include <Arduino.h>
+#include <atomic>
+
+/**
+ * Fixed-capacity SPSC ring buffer
+ * One task may call push(), one other task may call pop()
+ * Capacity must be a power of two
+ */
+template <typename T, uint8_t CAPACITY>
+class SpscRing {
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+
+public:
+    SpscRing() : head(0), tail(0), dropped(0) {}
+    
+    /**
+     * Add an item (producer side)
+     * Returns false and counts a drop if the ring is full
+     */
+    bool push(const T& item) {
+        uint8_t h = head.load(std::memory_order_relaxed);
+        uint8_t t = tail.load(std::memory_order_acquire);
+        
+        if ((uint8_t)(h - t) >= CAPACITY) {
+            dropped++;
+            return false;
+        }
+        
+        items[h & (CAPACITY - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+    
+    /**
+     * Take the oldest item (consumer side)
+     * Returns false if the ring is empty
+     */
+    bool pop(T& item) {
+        uint8_t t = tail.load(std::memory_order_relaxed);
+        uint8_t h = head.load(std::memory_order_acquire);
+        
+        if (h == t) {
+            return false;
+        }
+        
+        item = items[t & (CAPACITY - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+    
+    bool isEmpty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+    
+    /**
+     * Number of items rejected because the consumer fell behind
+     */
+    uint32_t getDropped() const {
+        return dropped;
+    }
+
+private:
+    T items[CAPACITY];
+    std::atomic<uint8_t> head;
+    std::atomic<uint8_t> tail;
+    volatile uint32_t dropped;
+};
+
+#endif // SAMPLE_QUEUE_H
@@ -0,0 +1,268 @@
+/*
+ * Telemetry Uplink
+ * Records device diagnostics at a fixed interval into a ring and POSTs
+ * them to a collector in binary batches from its own task, so a fleet
+ * sends one small request every few minutes instead of one per sample
+ * and the render path never waits on the collector.
+ */
+
+#ifndef TELEMETRY_UPLINK_H
+#define TELEMETRY_UPLINK_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <HTTPClient.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <atomic>
+#include "config.h"
+#include "firmware_stats.h"
+#include "wifi_manager.h"
+#include "little_endian.h"
+
+/*
+ * POST body, version 1 (all fields little-endian)
+ *   Header, 16 bytes:
+ *     0  "FXT"            magic
+ *     3  uint8   version  1
+ *     4  uint8[6] mac     station MAC, identifies the device
+ *    10  uint16  interval seconds between records
+ *    12  uint16  count    records that follow
+ *    14  uint8   size     bytes per record (20; skip any extra bytes)
+ *    15  uint8   reserved 0
+ *   Records, oldest first:
+ *     0  uint32  uptime   seconds since boot
+ *     4  uint32  heap     free heap bytes
+ *     8  uint32  block    largest free heap block bytes
+ *    12  uint16  fetch    average time to first byte over the interval (0.1 ms)
+ *    14  uint16  render   average main-area render over the interval (0.1 ms)
+ *    16  uint16  failures fetch failures during the interval
+ *    18  int8    rssi     dBm (0 while disconnected)
+ *    19  uint8   reserved 0
+ * Gaps in uptime mark records dropped while the collector was unreachable.
+ */
+#define TELEMETRY_MAGIC        "FXT"
+#define TELEMETRY_VERSION      1
+#define TELEMETRY_HEADER_SIZE  16
+#define TELEMETRY_RECORD_SIZE  20
+
+static_assert(TELEMETRY_BATCH_RECORDS <= TELEMETRY_RING_SIZE, "telemetry ring smaller than a batch");
+
+class TelemetryUplink {
+public:
+    TelemetryUplink() :
+        wifi(nullptr),
+        stats(nullptr),
+        task(nullptr),
+        busy(false),
+        head(0),
+        count(0),
+        backoff_ms(TELEMETRY_BACKOFF_MS),
+        last_fetch_count(0),
+        last_fetch_sum(0),
+        last_render_count(0),
+        last_render_sum(0),
+        last_failures(0) {}
+    
+    /**
+     * Spawn the uplink task
+     * firmware_stats is read for the timings and receives the uplink counters
+     */
+    bool begin(WiFiManager* wifi_manager, FirmwareStats* firmware_stats) {
+        wifi = wifi_manager;
+        stats = firmware_stats;
+        
+        BaseType_t result = xTaskCreate(taskEntry, "telemetry", TELEMETRY_TASK_STACK,
+                                        this, TELEMETRY_TASK_PRIORITY, &task);
+        if (result != pdPASS) {
+            Serial.println("Failed to start telemetry task");
+            task = nullptr;
+            return false;
+        }
+        
+        Serial.printf("Telemetry: %d records per batch every %lu s to %s\n", TELEMETRY_BATCH_RECORDS,
+                     (unsigned long)(TELEMETRY_BATCH_RECORDS * TELEMETRY_SAMPLE_MS / 1000), TELEMETRY_URL);
+        return true;
+    }
+    
+    /**
+     * True while a batch is being sent (keeps the chip out of light sleep)
+     */
+    bool isBusy() {
+        return busy.load(std::memory_order_relaxed);
+    }
+    
+    TaskHandle_t getTaskHandle() {
+        return task;
+    }
+
+private:
+    struct Record {
+        uint32_t uptime_s;
+        uint32_t heap_free;
+        uint32_t heap_largest;
+        uint16_t fetch_100us;
+        uint16_t render_100us;
+        uint16_t failures;
+        int8_t rssi;
+    };
+    
+    WiFiManager* wifi;
+    FirmwareStats* stats;
+    TaskHandle_t task;
+    std::atomic<bool> busy;
+    
+    // Ring of unsent records, only touched by the uplink task
+    Record ring[TELEMETRY_RING_SIZE];
+    uint16_t head;                      // Oldest record
+    uint16_t count;
+    uint8_t batch[TELEMETRY_HEADER_SIZE + TELEMETRY_BATCH_RECORDS * TELEMETRY_RECORD_SIZE];
+    uint32_t backoff_ms;
+    
+    // Counters at the previous record, for per-interval averages
+    uint32_t last_fetch_count;
+    uint64_t last_fetch_sum;
+    uint32_t last_render_count;
+    uint64_t last_render_sum;
+    uint32_t last_failures;
+    
+    static void taskEntry(void* arg) {
+        static_cast<TelemetryUplink*>(arg)->run();
+    }
+    
+    /**
+     * Record every TELEMETRY_SAMPLE_MS; send once a batch is full and the
+     * previous attempt's backoff has passed. While the collector is
+     * unreachable the ring keeps the newest TELEMETRY_RING_SIZE records.
+     */
+    void run() {
+        unsigned long next_send = 0;
+        
+        for (;;) {
+            vTaskDelay(pdMS_TO_TICKS(TELEMETRY_SAMPLE_MS));
+            record();
+            
+            if (count < TELEMETRY_BATCH_RECORDS || !wifi->isConnected() ||
+                (long)(millis() - next_send) < 0) {
+                continue;
+            }
+            
+            // Drain the backlog a batch at a time while the collector keeps up
+            while (count >= TELEMETRY_BATCH_RECORDS) {
+                if (!sendBatch()) {
+                    next_send = millis() + backoff_ms;
+                    backoff_ms = min(backoff_ms * 2, (uint32_t)TELEMETRY_BACKOFF_MAX_MS);
+                    break;
+                }
+                backoff_ms = TELEMETRY_BACKOFF_MS;
+            }
+            if (stats) stats->telemetry_backlog = count;
+        }
+    }
+    
+    /**
+     * Append the current diagnostics; overwrites the oldest record when full
+     */
+    void record() {
+        if (count == TELEMETRY_RING_SIZE) {
+            head = (head + 1) % TELEMETRY_RING_SIZE;
+            count--;
+            if (stats) stats->telemetry_records_dropped++;
+        }
+        
+        Record& r = ring[(head + count) % TELEMETRY_RING_SIZE];
+        r.uptime_s = millis() / 1000;
+        r.heap_free = ESP.getFreeHeap();
+        r.heap_largest = ESP.getMaxAllocHeap();
+        r.rssi = wifi->isConnected() ? (int8_t)WiFi.RSSI() : 0;
+        r.fetch_100us = 0;
+        r.render_100us = 0;
+        r.failures = 0;
+        
+        if (stats) {
+            LatencyHistogram::Snapshot snap;
+            stats->fetch[FETCH_TTFB].snapshot(snap);
+            r.fetch_100us = average100us(snap, last_fetch_count, last_fetch_sum);
+            stats->render[RENDER_MAIN].snapshot(snap);
+            r.render_100us = average100us(snap, last_render_count, last_render_sum);
+            
+            uint32_t failures = stats->fetch_failures;
+            r.failures = (uint16_t)min(failures - last_failures, (uint32_t)UINT16_MAX);
+            last_failures = failures;
+        }
+        count++;
+        if (stats) stats->telemetry_backlog = count;
+    }
+    
+    /**
+     * Mean of the samples recorded since the last call, in 0.1 ms
+     */
+    static uint16_t average100us(const LatencyHistogram::Snapshot& snap,
+                                 uint32_t& last_count, uint64_t& last_sum) {
+        uint32_t n = snap.count - last_count;
+        uint64_t sum = snap.sum_us - last_sum;
+        last_count = snap.count;
+        last_sum = snap.sum_us;
+        if (n == 0) return 0;
+        return (uint16_t)min(sum / n / 100, (uint64_t)UINT16_MAX);
+    }
+    
+    /**
+     * POST the oldest TELEMETRY_BATCH_RECORDS; they leave the ring only
+     * once the collector answered 2xx
+     */
+    bool sendBatch() {
+        uint8_t* out = batch;
+        size_t len = TELEMETRY_HEADER_SIZE;
+        for (uint16_t i = 0; i < TELEMETRY_BATCH_RECORDS; i++) {
+            const Record& r = ring[(head + i) % TELEMETRY_RING_SIZE];
+            LittleEndian::put32(out + len, r.uptime_s);
+            LittleEndian::put32(out + len + 4, r.heap_free);
+            LittleEndian::put32(out + len + 8, r.heap_largest);
+            LittleEndian::put16(out + len + 12, r.fetch_100us);
+            LittleEndian::put16(out + len + 14, r.render_100us);
+            LittleEndian::put16(out + len + 16, r.failures);
+            out[len + 18] = (uint8_t)r.rssi;
+            out[len + 19] = 0;
+            len += TELEMETRY_RECORD_SIZE;
+        }
+        
+        memcpy(out, TELEMETRY_MAGIC, 3);
+        out[3] = TELEMETRY_VERSION;
+        WiFi.macAddress(out + 4);
+        LittleEndian::put16(out + 10, TELEMETRY_SAMPLE_MS / 1000);
+        LittleEndian::put16(out + 12, TELEMETRY_BATCH_RECORDS);
+        out[14] = TELEMETRY_RECORD_SIZE;
+        out[15] = 0;
+        
+        busy.store(true, std::memory_order_relaxed);
+        HTTPClient http;
+        http.setTimeout(HTTP_TIMEOUT_MS);
+        http.setConnectTimeout(HTTP_TIMEOUT_MS);
+        http.setReuse(false);   // One request every few minutes
+        
+        bool ok = false;
+        int code = -1;
+        if (http.begin(TELEMETRY_URL)) {
+            http.addHeader("Content-Type", "application/octet-stream");
+            code = http.POST(out, len);
+            ok = code >= 200 && code < 300;
+            http.end();
+        }
+        busy.store(false, std::memory_order_relaxed);
+        
+        if (!ok) {
+            Serial.printf("Telemetry POST failed (%d), %u records queued, retry in %lu s\n",
+                         code, (unsigned)count, (unsigned long)(backoff_ms / 1000));
+            if (stats) stats->telemetry_send_failures++;
+            return false;
+        }
+        
+        head = (head + TELEMETRY_BATCH_RECORDS) % TELEMETRY_RING_SIZE;
+        count -= TELEMETRY_BATCH_RECORDS;
+        if (stats) stats->telemetry_batches_sent++;
+        return true;
+    }
+};
+
+#endif // TELEMETRY_UPLINK_H
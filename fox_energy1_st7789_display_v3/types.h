@@ -7,6 +7,7 @@
 #define TYPES_H
 
 #include <Arduino.h>
+#include "config.h"
 
 // =========================================================================
 // ===                        DATA STRUCTURES                            ===
@@ -27,21 +28,91 @@ struct PowerData {
         : voltage(v), current(c), power_active(p) {}
 };
 
+/**
+ * micros() stamps of one sample on its way through the fetch task
+ * The meter's JSON carries no timestamp of its own, so the pipeline
+ * starts when the request goes out (or the datagram lands, push mode).
+ * Compare stamps by difference only: micros() wraps every ~71 minutes.
+ */
+struct SampleTiming {
+    uint32_t request_us;        // Request started (push: datagram received)
+    uint32_t first_byte_us;     // Response headers parsed (push: same as request_us)
+    uint32_t parsed_us;         // Body read, parsed and validated
+    
+    SampleTiming() : request_us(0), first_byte_us(0), parsed_us(0) {}
+};
+
+/**
+ * Result of one fetch, handed from the fetch task to the UI loop
+ */
+struct PowerSample {
+    PowerData data;
+    bool valid;                 // Fetch and parse succeeded
+    unsigned long fetch_time;   // millis() when the fetch completed
+    int consecutive_failures;   // Failure streak including this fetch
+    uint8_t meter;              // Source, index into METER_URLS
+    SampleTiming timing;        // Valid samples only
+    
+    PowerSample() : valid(false), fetch_time(0), consecutive_failures(0), meter(0) {}
+};
+
+/**
+ * Latest reading of one meter, as shown in its dashboard cell
+ */
+struct MeterReading {
+    PowerData data;             // Last valid sample
+    bool has_data;              // At least one valid sample since boot
+    bool stale;                 // No valid sample for METER_STALE_MS
+    
+    MeterReading() : has_data(false), stale(true) {}
+};
+
 /**
  * Status bar display data
  */
 struct StatusData {
     float internal_temp;  // ESP32 internal temperature in °C
     long rssi;            // WiFi signal strength in dBm
-    String time_str;      // Full time string "HH:MM:SS"
-    String hours;         // Hours component "HH"
-    String minutes;       // Minutes component "MM"
-    String seconds;       // Seconds component "SS"
+    int8_t hour;          // 0-23, -1 while time is unknown
+    int8_t minute;        // 0-59, -1 while time is unknown
+    int8_t second;        // 0-59, -1 while time is unknown
+    char time_str[9];     // Full time string "HH:MM:SS" (for logging)
+    float energy_today;   // Energy used today in kWh
+    float energy_month;   // Energy used this month in kWh
+    long data_age_s;      // Seconds since the newest valid sample, -1 = none this boot
     
     // Constructor with default values
-    StatusData() : internal_temp(0.0f), rssi(-100), 
-                   time_str("--:--:--"), hours("--"), 
-                   minutes("--"), seconds("--") {}
+    StatusData() : internal_temp(0.0f), rssi(-100), energy_today(0.0f), energy_month(0.0f), data_age_s(-1) {
+        clearTime();
+    }
+    
+    void setTime(int h, int m, int s) {
+        hour = h;
+        minute = m;
+        second = s;
+        formatSegment(time_str, hour);
+        formatSegment(time_str + 3, minute);
+        formatSegment(time_str + 6, second);
+        time_str[2] = time_str[5] = ':';
+    }
+    
+    void clearTime() {
+        hour = minute = second = -1;
+        memcpy(time_str, "--:--:--", sizeof(time_str));
+    }
+    
+    /**
+     * Write a time component as two characters ("07", or "--" if unknown)
+     * Does not terminate the string
+     */
+    static void formatSegment(char* out, int8_t value) {
+        if (value < 0) {
+            out[0] = out[1] = '-';
+        } else {
+            out[0] = '0' + value / 10;
+            out[1] = '0' + value % 10;
+        }
+    }
 };
 
 /**
@@ -54,7 +125,8 @@ enum BufferMode {
 };
 
 /**
- * WiFi connection state
+ * WiFi connection state (WiFiManager::tick())
+ * FAILED still retries, at the slowest backoff
  */
 enum WiFiState {
     WIFI_DISCONNECTED,
@@ -87,6 +159,89 @@ struct DirtyRegion {
     void clear() {
         is_dirty = false;
     }
+    
+    /**
+     * Grow region so it also covers the given rectangle
+     */
+    void include(int16_t x_, int16_t y_, int16_t w_, int16_t h_) {
+        if (!is_dirty) {
+            mark(x_, y_, w_, h_);
+            return;
+        }
+        int16_t x2 = max(x + width, x_ + w_);
+        int16_t y2 = max(y + height, y_ + h_);
+        x = min(x, x_);
+        y = min(y, y_);
+        width = x2 - x;
+        height = y2 - y;
+    }
+    
+    /**
+     * Check if region overlaps or touches the given rectangle
+     */
+    bool touches(int16_t x_, int16_t y_, int16_t w_, int16_t h_) const {
+        return is_dirty &&
+               x_ <= x + width && x <= x_ + w_ &&
+               y_ <= y + height && y <= y_ + h_;
+    }
+    
+    int32_t area() const {
+        return is_dirty ? (int32_t)width * height : 0;
+    }
+};
+
+/**
+ * Fixed-size set of dirty regions for one canvas
+ * Overlapping rectangles are merged; when full, the new rectangle is
+ * merged into the region that grows the least
+ */
+struct DirtyRegionList {
+    DirtyRegion regions[MAX_DIRTY_REGIONS];
+    uint8_t count;
+    
+    DirtyRegionList() : count(0) {}
+    
+    void mark(int16_t x, int16_t y, int16_t w, int16_t h) {
+        if (w <= 0 || h <= 0) return;
+        
+        // Merge with an overlapping region if possible
+        for (uint8_t i = 0; i < count; i++) {
+            if (regions[i].touches(x, y, w, h)) {
+                regions[i].include(x, y, w, h);
+                return;
+            }
+        }
+        
+        if (count < MAX_DIRTY_REGIONS) {
+            regions[count++].mark(x, y, w, h);
+            return;
+        }
+        
+        // List full - merge into the region with the smallest growth
+        uint8_t best = 0;
+        int32_t best_growth = INT32_MAX;
+        for (uint8_t i = 0; i < count; i++) {
+            DirtyRegion merged = regions[i];
+            merged.include(x, y, w, h);
+            int32_t growth = merged.area() - regions[i].area();
+            if (growth < best_growth) {
+                best_growth = growth;
+                best = i;
+            }
+        }
+        regions[best].include(x, y, w, h);
+    }
+    
+    bool isEmpty() const {
+        return count == 0;
+    }
+    
+    void clear() {
+        for (uint8_t i = 0; i < count; i++) {
+            regions[i].clear();
+        }
+        count = 0;
+    }
 };
 
 #endif // TYPES_H
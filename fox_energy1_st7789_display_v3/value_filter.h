@@ -0,0 +1,153 @@
+/*
+ * Display Value Filter
+ * Smooths readings for the dashboard and holds the shown value until a
+ * change is real, so meter jitter does not redraw digits every poll
+ */
+
+#ifndef VALUE_FILTER_H
+#define VALUE_FILTER_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "types.h"
+
+static_assert(FILTER_MEDIAN_SIZE % 2 == 1 && FILTER_MEDIAN_SIZE <= 7,
+              "FILTER_MEDIAN_SIZE must be odd and at most 7");
+
+/**
+ * One channel: optional median of the last FILTER_MEDIAN_SIZE samples,
+ * then an EMA (DISPLAY_FILTER selects the stages)
+ */
+class SmoothedValue {
+public:
+    SmoothedValue() : value(0.0f), count(0), next(0) {}
+    
+    /**
+     * Add a sample, returns the filtered value
+     */
+    float update(float sample) {
+        if (DISPLAY_FILTER == FILTER_NONE || count == 0) {
+            reset(sample);
+            return value;
+        }
+        
+        float input = sample;
+        if (DISPLAY_FILTER == FILTER_MEDIAN) {
+            window[next] = sample;
+            next = (next + 1) % FILTER_MEDIAN_SIZE;
+            if (count < FILTER_MEDIAN_SIZE) count++;
+            input = median();
+        }
+        
+        value += FILTER_EMA_ALPHA * (input - value);
+        return value;
+    }
+    
+    /**
+     * Jump to sample (no history)
+     */
+    void reset(float sample) {
+        for (uint8_t i = 0; i < FILTER_MEDIAN_SIZE; i++) {
+            window[i] = sample;
+        }
+        value = sample;
+        count = 1;
+        next = 1 % FILTER_MEDIAN_SIZE;
+    }
+    
+    float get() const {
+        return value;
+    }
+    
+    bool hasValue() const {
+        return count > 0;
+    }
+
+private:
+    float value;
+    float window[FILTER_MEDIAN_SIZE];
+    uint8_t count;              // Samples in window (1..FILTER_MEDIAN_SIZE)
+    uint8_t next;               // Slot for the next sample
+    
+    float median() const {
+        float sorted[FILTER_MEDIAN_SIZE];
+        for (uint8_t i = 0; i < count; i++) {
+            float v = window[i];
+            uint8_t j = i;
+            for (; j > 0 && sorted[j - 1] > v; j--) {
+                sorted[j] = sorted[j - 1];
+            }
+            sorted[j] = v;
+        }
+        return sorted[count / 2];
+    }
+};
+
+/**
+ * Schmitt trigger on a display resolution: the held value is a multiple
+ * of step and moves only once the input is band beyond the rounding edge
+ * between two steps
+ */
+class HeldValue {
+public:
+    HeldValue() : held(0.0f), has_value(false) {}
+    
+    float update(float input, float step, float band) {
+        if (!has_value || fabsf(input - held) > step / 2 + band) {
+            held = roundf(input / step) * step;
+            has_value = true;
+        }
+        return held;
+    }
+    
+    float get() const {
+        return held;
+    }
+
+private:
+    float held;
+    bool has_value;
+};
+
+/**
+ * Voltage, current and power as the dashboard should show them
+ * Steps match the DisplayManager formats: 1 V, 0.1 A, 1 W below 1 kW and
+ * 0.1 kW above. Raw samples still go to energy, history and /metrics.
+ */
+class DisplayFilter {
+public:
+    /**
+     * Add a valid sample and write the values to draw into shown
+     */
+    void update(const PowerData& raw, PowerData& shown) {
+        // A load switching on or off is shown at once, not eased in
+        if (power.hasValue() && fabsf(raw.power_active - power.get()) > FILTER_STEP_W) {
+            voltage.reset(raw.voltage);
+            current.reset(raw.current);
+            power.reset(raw.power_active);
+        } else {
+            voltage.update(raw.voltage);
+            current.update(raw.current);
+            power.update(raw.power_active);
+        }
+        
+        // The finer W step applies until both the held and the new value
+        // are in kW, so the switch to kW is not delayed by a 0.1 kW band
+        float p = power.get();
+        bool kw = p >= 1000.0f && shown_power.get() >= 1000.0f;
+        shown.voltage = shown_voltage.update(voltage.get(), 1.0f, VOLTAGE_HYSTERESIS_V);
+        shown.current = shown_current.update(current.get(), 0.1f, CURRENT_HYSTERESIS_A);
+        shown.power_active = shown_power.update(p, kw ? 100.0f : 1.0f,
+                                                kw ? POWER_HYSTERESIS_KW * 1000.0f : POWER_HYSTERESIS_W);
+    }
+
+private:
+    SmoothedValue voltage;
+    SmoothedValue current;
+    SmoothedValue power;
+    HeldValue shown_voltage;
+    HeldValue shown_current;
+    HeldValue shown_power;
+};
+
+#endif // VALUE_FILTER_H
@@ -1,6 +1,10 @@
 /*
  * WiFi Manager with NVS Persistence
  * Handles WiFi connection, reconnection, and credential storage
+ * Connecting is a non-blocking state machine advanced by tick() and the
+ * driver's events, so the UI keeps running while the link is down
+ * The last association (BSSID, channel, IP config) is cached in NVS so a
+ * reconnect can skip the scan and DHCP
  */
 
 #ifndef WIFI_MANAGER_H
@@ -8,16 +12,57 @@
 
 #include <WiFi.h>
 #include <Preferences.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
 #include "config.h"
 #include "types.h"
+#include "firmware_stats.h"
+
+#define WIFI_FAST_NVS_KEY      "wifi_fast"
+#define WIFI_FAST_NVS_VERSION  1
+
+// Event group bits set from the WiFi event task
+#define WIFI_BIT_GOT_IP        (1 << 0)
+#define WIFI_BIT_DISCONNECTED  (1 << 1)
+
+/**
+ * Last successful association, persisted as one blob
+ */
+struct WiFiFastConnect {
+    uint32_t version;
+    uint8_t bssid[6];
+    int32_t channel;
+    uint32_t ip;          // IP config in use when the record was written
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns;
+};
 
 class WiFiManager {
 public:
     WiFiManager() : 
         state(WIFI_DISCONNECTED),
         reconnect_attempts(0),
-        last_reconnect_attempt(0),
-        preferences_initialized(false) {}
+        next_attempt_at(0),
+        attempt_start(0),
+        attempt_timeout(0),
+        attempt_fast(false),
+        attempt_lease(false),
+        lease_renewing(false),
+        ever_connected(false),
+        preferences_initialized(false),
+        fast_valid(false),
+        events(nullptr),
+        stats(nullptr) {
+        memset(&fast, 0, sizeof(fast));
+    }
+    
+    /**
+     * Count reconnection attempts (may be nullptr)
+     */
+    void setStats(FirmwareStats* firmware_stats) {
+        stats = firmware_stats;
+    }
     
     /**
      * Initialize WiFi manager and load credentials from NVS
@@ -36,58 +81,39 @@ public:
             saveCredentials(saved_ssid.c_str(), saved_password.c_str());
         }
         
+        loadFastConnect();
+        
+        // Connection waits block on these bits instead of polling WiFi.status()
+        events = xEventGroupCreate();
+        WiFi.onEvent([this](arduino_event_id_t event, arduino_event_info_t info) {
+            onWiFiEvent(event);
+        });
+        
+        WiFi.persistent(false); // Our own record replaces the SDK's flash copy
         WiFi.mode(WIFI_STA);
         WiFi.setHostname("ESP32-EnergyMon");
     }
     
     /**
-     * Connect to WiFi using saved credentials
-     * Returns true if connected, false otherwise
+     * Start connecting with the saved credentials (returns immediately)
+     * Progress is driven by tick()
      */
-    bool connect() {
-        return connect(saved_ssid.c_str(), saved_password.c_str());
+    void connect() {
+        connect(saved_ssid.c_str(), saved_password.c_str());
     }
     
     /**
-     * Connect to WiFi using provided credentials
-     * Saves credentials to NVS if connection successful
+     * Start connecting with the provided credentials (returns immediately)
+     * They are saved to NVS once the connection succeeds
      */
-    bool connect(const char* ssid, const char* password) {
-        state = WIFI_CONNECTING;
+    void connect(const char* ssid, const char* password) {
+        target_ssid = ssid;
+        target_password = password;
+        reconnect_attempts = 0;
+        
         Serial.print("Connecting to WiFi: ");
         Serial.println(ssid);
-        
-        WiFi.begin(ssid, password);
-        
-        int timeout = WIFI_CONNECT_TIMEOUT;
-        while (WiFi.status() != WL_CONNECTED && timeout > 0) {
-            delay(500);
-            Serial.print(".");
-            timeout--;
-        }
-        Serial.println();
-        
-        if (WiFi.status() == WL_CONNECTED) {
-            state = WIFI_CONNECTED;
-            Serial.println("WiFi connected!");
-            Serial.print("  IP: ");
-            Serial.println(WiFi.localIP());
-            Serial.print("  RSSI: ");
-            Serial.print(WiFi.RSSI());
-            Serial.println(" dBm");
-            
-            // Save credentials if they're different from what's stored
-            if (String(ssid) != saved_ssid || String(password) != saved_password) {
-                saveCredentials(ssid, password);
-            }
-            
-            reconnect_attempts = 0;
-            return true;
-        } else {
-            state = WIFI_FAILED;
-            Serial.println("WiFi connection failed!");
-            return false;
-        }
+        startAttempt(millis());
     }
     
     /**
@@ -98,60 +124,61 @@ public:
     }
     
     /**
-     * Attempt to reconnect to WiFi
-     * Uses exponential backoff to avoid overwhelming the network
+     * Advance the connection state machine; call once per loop
+     * Never blocks: attempts run in the WiFi driver, their outcome arrives
+     * as events and retries wait out an exponential backoff.
+     * Returns the state after this step.
      */
-    bool reconnect() {
-        // Check if we're already connected
-        if (isConnected()) {
-            state = WIFI_CONNECTED;
-            return true;
-        }
+    WiFiState tick() {
+        unsigned long now = millis();
         
-        // Implement exponential backoff
-        unsigned long current_time = millis();
-        unsigned long backoff_delay = WIFI_RECONNECT_BACKOFF_MS * (1 << reconnect_attempts);
-        backoff_delay = min(backoff_delay, 16000UL); // Max 16 second delay
-        
-        if (current_time - last_reconnect_attempt < backoff_delay) {
-            return false; // Too soon to retry
+        switch (state) {
+            case WIFI_CONNECTING:
+            case WIFI_RECONNECTING:
+                checkAttempt(now);
+                break;
+                
+            case WIFI_CONNECTED:
+                if (WiFi.status() != WL_CONNECTED ||
+                    (xEventGroupGetBits(events) & WIFI_BIT_DISCONNECTED)) {
+                    Serial.println("WiFi link lost");
+                    reconnect_attempts = 0;
+                    lease_renewing = false;
+                    next_attempt_at = now; // First retry right away
+                    state = WIFI_DISCONNECTED;
+                } else if (lease_renewing && (xEventGroupGetBits(events) & WIFI_BIT_GOT_IP)) {
+                    // Only a lease the DHCP server handed out is worth caching
+                    lease_renewing = false;
+                    Serial.print("DHCP lease confirmed: ");
+                    Serial.println(WiFi.localIP());
+                    saveFastConnect(true);
+                }
+                break;
+                
+            case WIFI_DISCONNECTED:
+            case WIFI_FAILED:
+                if (target_ssid.length() > 0 && (long)(now - next_attempt_at) >= 0) {
+                    startAttempt(now);
+                }
+                break;
         }
         
-        last_reconnect_attempt = current_time;
-        state = WIFI_RECONNECTING;
-        
-        Serial.println("Attempting WiFi reconnection...");
-        Serial.print("  Attempt: ");
-        Serial.print(reconnect_attempts + 1);
-        Serial.print("/");
-        Serial.println(WIFI_RECONNECT_MAX_ATTEMPTS);
-        
-        WiFi.begin(saved_ssid.c_str(), saved_password.c_str());
-        
-        int timeout = WIFI_RECONNECT_TIMEOUT;
-        while (WiFi.status() != WL_CONNECTED && timeout > 0) {
-            delay(500);
-            Serial.print("*");
-            timeout--;
-        }
-        Serial.println();
+        return state;
+    }
+    
+    /**
+     * Forget the cached IP config so the next connect runs DHCP
+     * For a link that is up while nothing gets through, e.g. a cached
+     * lease now owned by another host or a changed subnet
+     */
+    void dropCachedLease() {
+        if (!WIFI_FAST_REUSE_LEASE || !fast_valid || fast.ip == 0) return;
         
-        if (WiFi.status() == WL_CONNECTED) {
-            state = WIFI_CONNECTED;
-            reconnect_attempts = 0;
-            Serial.println("WiFi reconnected!");
-            Serial.print("  RSSI: ");
-            Serial.print(WiFi.RSSI());
-            Serial.println(" dBm");
-            return true;
-        } else {
-            reconnect_attempts++;
-            if (reconnect_attempts >= WIFI_RECONNECT_MAX_ATTEMPTS) {
-                state = WIFI_FAILED;
-                Serial.println("Max reconnection attempts reached");
-            }
-            return false;
+        fast.ip = fast.gateway = fast.subnet = fast.dns = 0;
+        if (preferences_initialized) {
+            preferences.putBytes(WIFI_FAST_NVS_KEY, &fast, sizeof(fast));
         }
+        Serial.println("Cached DHCP lease dropped");
     }
     
     /**
@@ -220,12 +247,24 @@ public:
             return;
         }
         
-        preferences.clear();
+        // Only our keys - other modules keep state in this namespace too
+        preferences.remove("ssid");
+        preferences.remove("password");
+        preferences.remove(WIFI_FAST_NVS_KEY);
+        fast_valid = false;
         saved_ssid = "";
         saved_password = "";
         Serial.println("WiFi credentials cleared from NVS");
     }
     
+    /**
+     * Shared NVS handle ("wifi_config" namespace) for other modules
+     * Returns nullptr before begin()
+     */
+    Preferences* getPreferences() {
+        return preferences_initialized ? &preferences : nullptr;
+    }
+    
     /**
      * Get saved SSID
      */
@@ -238,9 +277,217 @@ private:
     String saved_ssid;
     String saved_password;
     WiFiState state;
+    String target_ssid;       // Network the state machine is joining
+    String target_password;
     int reconnect_attempts;
-    unsigned long last_reconnect_attempt;
+    unsigned long next_attempt_at;
+    unsigned long attempt_start;
+    unsigned long attempt_timeout;
+    bool attempt_fast;
+    bool attempt_lease;       // Attempt runs on the cached lease instead of DHCP
+    bool lease_renewing;      // Connected on the cached lease, DHCP not confirmed yet
+    bool ever_connected;
     bool preferences_initialized;
+    WiFiFastConnect fast;
+    bool fast_valid;
+    EventGroupHandle_t events;
+    FirmwareStats* stats;
+    
+    void onWiFiEvent(arduino_event_id_t event) {
+        if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP) {
+            xEventGroupSetBits(events, WIFI_BIT_GOT_IP);
+        } else if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) {
+            xEventGroupSetBits(events, WIFI_BIT_DISCONNECTED);
+        }
+    }
+    
+    /**
+     * Begin a connection attempt: a directed fast connect from the cached
+     * record when it matches, otherwise a full scan with DHCP
+     */
+    void startAttempt(unsigned long now) {
+        state = ever_connected ? WIFI_RECONNECTING : WIFI_CONNECTING;
+        
+        if (state == WIFI_RECONNECTING) {
+            if (stats) stats->wifi_reconnect_attempts++;
+            Serial.printf("Attempting WiFi reconnection (attempt %d)\n", reconnect_attempts + 1);
+        }
+        
+        bool use_cache = WIFI_FAST_CONNECT && fast_valid && target_ssid == saved_ssid;
+        beginAttempt(use_cache, now);
+    }
+    
+    /**
+     * One WiFi.begin(); checkAttempt() picks up the result
+     */
+    void beginAttempt(bool use_cache, unsigned long now) {
+        xEventGroupClearBits(events, WIFI_BIT_GOT_IP | WIFI_BIT_DISCONNECTED);
+        
+        IPAddress ip, gateway, subnet, dns;
+        attempt_lease = false;
+        if (getStaticConfig(ip, gateway, subnet, dns)) {
+            WiFi.config(ip, gateway, subnet, dns);
+        } else if (use_cache && WIFI_FAST_REUSE_LEASE && fast.ip != 0) {
+            WiFi.config(IPAddress(fast.ip), IPAddress(fast.gateway),
+                        IPAddress(fast.subnet), IPAddress(fast.dns));
+            attempt_lease = true;
+        } else {
+            WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE); // DHCP
+        }
+        
+        if (use_cache) {
+            WiFi.begin(target_ssid.c_str(), target_password.c_str(), fast.channel, fast.bssid, true);
+            attempt_timeout = WIFI_FAST_CONNECT_TIMEOUT_MS;
+        } else {
+            WiFi.begin(target_ssid.c_str(), target_password.c_str());
+            attempt_timeout = (ever_connected ? WIFI_RECONNECT_TIMEOUT : WIFI_CONNECT_TIMEOUT) * 500UL;
+        }
+        
+        attempt_fast = use_cache;
+        attempt_start = now;
+    }
+    
+    /**
+     * Resolve the running attempt from the event bits
+     * A fast attempt gives up on the first disconnect (wrong channel, AP
+     * gone) and falls through to a full one; a full attempt lets the driver
+     * retry until its timeout.
+     */
+    void checkAttempt(unsigned long now) {
+        EventBits_t bits = xEventGroupGetBits(events);
+        
+        if ((bits & WIFI_BIT_GOT_IP) && WiFi.status() == WL_CONNECTED) {
+            onConnected(now);
+            return;
+        }
+        
+        bool rejected = attempt_fast && (bits & WIFI_BIT_DISCONNECTED);
+        if (!rejected && now - attempt_start < attempt_timeout) {
+            return; // Still in progress
+        }
+        
+        Serial.printf("%s connect failed after %lu ms\n",
+                     attempt_fast ? "Fast" : "Full", now - attempt_start);
+        WiFi.disconnect();
+        
+        if (attempt_fast) {
+            Serial.println("Fast connect failed, falling back to a full scan");
+            beginAttempt(false, now);
+            return;
+        }
+        
+        // Exponential backoff before the next try
+        reconnect_attempts++;
+        unsigned long backoff = (unsigned long)WIFI_RECONNECT_BACKOFF_MS << min(reconnect_attempts - 1, 5);
+        backoff = min(backoff, (unsigned long)WIFI_RECONNECT_BACKOFF_MAX_MS);
+        next_attempt_at = now + backoff;
+        
+        if (reconnect_attempts >= WIFI_RECONNECT_MAX_ATTEMPTS) {
+            if (state != WIFI_FAILED) {
+                Serial.println("Max reconnection attempts reached, still retrying");
+            }
+            state = WIFI_FAILED;
+        } else {
+            state = WIFI_DISCONNECTED;
+        }
+        Serial.printf("WiFi connection failed, next attempt in %lu ms\n", backoff);
+    }
+    
+    void onConnected(unsigned long now) {
+        Serial.printf("%s connect succeeded after %lu ms\n",
+                     attempt_fast ? "Fast" : "Full", now - attempt_start);
+        
+        // Drop disconnects the driver reported while it was still retrying
+        xEventGroupClearBits(events, WIFI_BIT_GOT_IP | WIFI_BIT_DISCONNECTED);
+        
+        if (ever_connected && stats) stats->wifi_reconnects++;
+        Serial.println(ever_connected ? "WiFi reconnected!" : "WiFi connected!");
+        Serial.print("  IP: ");
+        Serial.println(WiFi.localIP());
+        Serial.print("  RSSI: ");
+        Serial.print(WiFi.RSSI());
+        Serial.println(" dBm");
+        
+        // Save credentials if they're different from what's stored
+        if (target_ssid != saved_ssid || target_password != saved_password) {
+            saveCredentials(target_ssid.c_str(), target_password.c_str());
+        }
+        saveFastConnect(!attempt_lease);
+        
+        // The borrowed lease only bridges the first samples; hand the
+        // address back to DHCP so it is renewed (or replaced) as usual
+        if (attempt_lease) {
+            Serial.println("Connected on the cached lease, renewing via DHCP");
+            WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+            lease_renewing = true;
+        }
+        
+        state = WIFI_CONNECTED;
+        ever_connected = true;
+        reconnect_attempts = 0;
+    }
+    
+    /**
+     * WIFI_STATIC_IP and friends, if configured
+     */
+    bool getStaticConfig(IPAddress& ip, IPAddress& gateway, IPAddress& subnet, IPAddress& dns) {
+        if (strlen(WIFI_STATIC_IP) == 0) return false;
+        if (!ip.fromString(WIFI_STATIC_IP) || !gateway.fromString(WIFI_STATIC_GATEWAY) ||
+            !subnet.fromString(WIFI_STATIC_SUBNET)) {
+            Serial.println("Invalid static IP config, using DHCP");
+            return false;
+        }
+        if (!dns.fromString(WIFI_STATIC_DNS)) {
+            dns = gateway;
+        }
+        return true;
+    }
+    
+    void loadFastConnect() {
+        WiFiFastConnect stored;
+        if (preferences.getBytes(WIFI_FAST_NVS_KEY, &stored, sizeof(stored)) == sizeof(stored) &&
+            stored.version == WIFI_FAST_NVS_VERSION && stored.channel > 0) {
+            fast = stored;
+            fast_valid = true;
+            Serial.printf("Cached AP %02x:%02x:%02x:%02x:%02x:%02x on channel %ld\n",
+                         fast.bssid[0], fast.bssid[1], fast.bssid[2],
+                         fast.bssid[3], fast.bssid[4], fast.bssid[5], (long)fast.channel);
+        }
+    }
+    
+    /**
+     * Record the current association (NVS is written only when it changed)
+     * with_lease: the IP config came from DHCP (or WIFI_STATIC_IP); a
+     * borrowed lease is never written back, the stored one is kept
+     */
+    void saveFastConnect(bool with_lease) {
+        if (!preferences_initialized) return;
+        
+        WiFiFastConnect current;
+        memset(&current, 0, sizeof(current));
+        current.version = WIFI_FAST_NVS_VERSION;
+        memcpy(current.bssid, WiFi.BSSID(), sizeof(current.bssid));
+        current.channel = WiFi.channel();
+        if (with_lease) {
+            current.ip = WiFi.localIP();
+            current.gateway = WiFi.gatewayIP();
+            current.subnet = WiFi.subnetMask();
+            current.dns = WiFi.dnsIP(0);
+        } else if (fast_valid) {
+            current.ip = fast.ip;
+            current.gateway = fast.gateway;
+            current.subnet = fast.subnet;
+            current.dns = fast.dns;
+        }
+        
+        if (fast_valid && memcmp(&current, &fast, sizeof(current)) == 0) return;
+        
+        if (preferences.putBytes(WIFI_FAST_NVS_KEY, &current, sizeof(current)) == sizeof(current)) {
+            fast = current;
+            fast_valid = true;
+            Serial.printf("Fast connect record saved (channel %ld)\n", (long)current.channel);
+        }
+    }
 };
 
 #endif // WIFI_MANAGER_H
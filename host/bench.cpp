@@ -0,0 +1,501 @@
+/*
+ * Host Benchmarks for the v3 Display
+ * Microbenchmarks of the parse, layout and render paths, and golden-image
+ * diffs of the mock panel framebuffer. See host/README.md for the build.
+ */
+
+#include <Arduino.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <functional>
+#include <vector>
+#include "display_manager.h"
+#include "data_fetcher.h"
+#include "benchmark.h"
+#include "value_filter.h"
+
+#define HOST_MIN_BENCH_NS     200000000ULL   // Run each microbenchmark for at least 200 ms
+#define HOST_MAX_ITERATIONS   ((uint64_t)1 << 30)
+#define HOST_FETCH_URL        "http://meter.host/api/data"
+
+static volatile uint32_t bench_sink;         // Keeps results observable to the optimiser
+
+/**
+ * Friend of DisplayManager and DataFetcher (HOST_BUILD only)
+ */
+class HostBench {
+public:
+    struct Options {
+        bool update = false;            // Record goldens instead of comparing
+        bool scenarios = false;         // Also run the device Benchmark scenarios
+        bool verbose = false;           // Keep firmware Serial output
+        const char* out_dir = "host/out";
+        const char* filter = nullptr;   // Only names containing this
+    };
+    
+    explicit HostBench(const Options& options) : opt(options), failures(0) {}
+    
+    int run() {
+        runMicrobenchmarks();
+        runGoldens();
+        if (opt.scenarios) runScenarios();
+        return failures ? 1 : 0;
+    }
+
+private:
+    struct Scene {
+        const char* name;
+        std::function<void(DisplayManager&)> draw;
+    };
+    
+    Options opt;
+    int failures;
+    
+    bool selected(const char* name) {
+        return !opt.filter || strstr(name, opt.filter);
+    }
+    
+    void quiet() {
+        if (!opt.verbose) Serial.setOutput(nullptr);
+    }
+    
+    void loud() {
+        Serial.setOutput(stdout);
+    }
+    
+    static uint64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    
+    // =====================================================================
+    // ===                       MICROBENCHMARKS                         ===
+    // =====================================================================
+    
+    /**
+     * Time fn() with the iteration count grown until the run lasts
+     * HOST_MIN_BENCH_NS; panel traffic per call is reported when a panel is given
+     */
+    template<typename Fn>
+    void measure(const char* name, Fn fn, Adafruit_ST7789* panel = nullptr) {
+        if (!selected(name)) return;
+        
+        uint64_t iterations = 1;
+        for (;;) {
+            if (panel) panel->resetCounters();
+            uint64_t start = nowNs();
+            for (uint64_t i = 0; i < iterations; i++) fn(i);
+            uint64_t elapsed = nowNs() - start;
+            
+            if (elapsed >= HOST_MIN_BENCH_NS || iterations >= HOST_MAX_ITERATIONS) {
+                double pixels = panel ? (double)panel->getPixelsWritten() / iterations : 0.0;
+                double windows = panel ? (double)panel->getWindowsSet() / iterations : 0.0;
+                double wire_us = pixels * 16.0 * 1e6 / TFT_SPI_FREQ_HZ;
+                printf("HOST,%s,%llu,%.1f,%.0f,%.1f,%.1f\n", name, (unsigned long long)iterations,
+                       (double)elapsed / iterations, pixels, windows, wire_us);
+                return;
+            }
+            
+            // Aim 20% past the target from the last measurement
+            uint64_t next = elapsed > 0 ? iterations * HOST_MIN_BENCH_NS * 6 / 5 / elapsed : iterations * 10;
+            iterations = min(HOST_MAX_ITERATIONS, max(iterations * 2, next));
+        }
+    }
+    
+    void runMicrobenchmarks() {
+        printf("HOST,benchmark,iterations,ns_per_op,pixels_per_op,windows_per_op,wire_us_per_op\n");
+        quiet();
+        
+        const HostHttpResponse canned;
+        const String payload(canned.body);
+        DataFetcher fetcher;
+        PowerData data;
+        
+        measure("parse_json", [&](uint64_t) {
+            bench_sink += fetcher.parseJSON(payload, data);
+        });
+        
+        measure("parse_scanner", [&](uint64_t) {
+            PowerJsonScanner scanner;
+            scanner.feed(canned.body.data(), canned.body.size());
+            scanner.getData(data);
+            bench_sink += scanner.isComplete();
+        });
+        
+        hostHttpResponse = canned;
+        measure("fetch_streamed", [&](uint64_t) {
+            bench_sink += fetcher.fetchPowerData(HOST_FETCH_URL, data);
+        });
+        
+        hostHttpResponse.chunked = true;
+        measure("fetch_buffered", [&](uint64_t) {
+            bench_sink += fetcher.fetchPowerData(HOST_FETCH_URL, data);
+        });
+        
+        hostHttpResponse = canned;
+        hostHttpResponse.keep_alive = false;
+        measure("fetch_reconnect", [&](uint64_t) {
+            bench_sink += fetcher.fetchPowerData(HOST_FETCH_URL, data);
+        });
+        hostHttpResponse = canned;
+        
+        DisplayManager display;
+        display.begin();
+        display.drawInitialUI();
+        Adafruit_ST7789* panel = display.renderer.panel();
+        
+        // Table lookup that replaced text_bounds_power in the update path
+        measure("layout_power_text", [&](uint64_t i) {
+            const Layout::PowerText& pos = Layout::POWER_TEXT[i & 1][3 + (i & 1)];
+            bench_sink += pos.x + pos.y + pos.w + pos.unit_x;
+        });
+        
+        measure("text_bounds_power", [&](uint64_t) {
+            int16_t x1, y1;
+            uint16_t w, h;
+            panel->setTextSize(POWER_VALUE_FONT_SIZE);
+            panel->getTextBounds("2.75", 0, 0, &x1, &y1, &w, &h);
+            bench_sink += w + h;
+        });
+        
+        // Own canvas: the band canvas does not exist without the double buffer
+        GFXcanvas16 text_canvas(SCREEN_WIDTH, 8 * POWER_VALUE_FONT_SIZE);
+        measure("draw_text_cached", [&](uint64_t) {
+            display.renderer.drawText(&text_canvas, "1234", POWER_VALUE_FONT_SIZE, POWER_COLOR_NORMAL, 0, 0, 0);
+        });
+        
+        measure("draw_text_gfx", [&](uint64_t) {
+            text_canvas.setTextSize(POWER_VALUE_FONT_SIZE);
+            text_canvas.setTextColor(POWER_COLOR_NORMAL);
+            text_canvas.setCursor(0, 0);
+            text_canvas.print("1234");
+        });
+        
+        PowerData power(230.4f, 3.12f, 734.0f);
+        display.drawMainDisplay(power, true);
+        measure("render_digit_change", [&](uint64_t i) {
+            power.power_active = (i & 1) ? 734.0f : 735.0f;
+            display.drawMainDisplay(power, false);
+        }, panel);
+        
+        measure("render_kw_switch", [&](uint64_t i) {
+            power.power_active = (i & 1) ? 980.0f : 1020.0f;
+            display.drawMainDisplay(power, false);
+        }, panel);
+        
+        // A steady load with a few watts of meter noise: raw readings,
+        // then through the dashboard filter (one sample per call)
+        auto jitter = [](uint64_t i) {
+            static const float noise[8] = { 0.0f, 2.6f, -1.8f, 3.4f, -2.9f, 1.1f, -0.4f, -3.1f };
+            return PowerData(230.4f + noise[(i + 3) % 8] * 0.1f, 3.18f + noise[i % 8] * 0.01f,
+                             734.0f + noise[i % 8]);
+        };
+        measure("render_jitter_raw", [&](uint64_t i) {
+            display.drawMainDisplay(jitter(i), false);
+        }, panel);
+        
+        DisplayFilter filter;
+        PowerData shown;
+        measure("render_jitter_filtered", [&](uint64_t i) {
+            filter.update(jitter(i), shown);
+            display.drawMainDisplay(shown, false);
+        }, panel);
+        
+        StatusData status;
+        status.internal_temp = 45.0f;
+        status.rssi = -60;
+        measure("render_status_tick", [&](uint64_t i) {
+            status.setTime(12, (i / 60) % 60, i % 60);
+            display.drawStatusBar(status, false);
+        }, panel);
+        
+        measure("render_graph_column", [&](uint64_t i) {
+            display.addGraphSample(500.0f + (i * 97) % 3000);
+        }, panel);
+        
+        measure("render_full", [&](uint64_t) {
+            display.drawInitialUI();
+        }, panel);
+        
+        loud();
+    }
+    
+    // =====================================================================
+    // ===                        GOLDEN IMAGES                          ===
+    // =====================================================================
+    
+    static std::vector<Scene> scenes() {
+        return {
+            {"boot", [](DisplayManager& d) {
+                d.drawInitialUI();
+            }},
+            {"dashboard", [](DisplayManager& d) {
+                d.drawInitialUI();
+                StatusData status;
+                status.internal_temp = 47.0f;
+                status.rssi = -58;
+                status.setTime(12, 34, 56);
+                status.energy_today = 3.2f;
+                status.energy_month = 85.4f;
+                d.drawStatusBar(status, false);
+                d.drawMainDisplay(PowerData(230.4f, 3.12f, 734.0f), false);
+                for (int i = 0; i < 120; i++) {
+                    d.addGraphSample(700.0f + 400.0f * sinf(i * 0.15f));
+                }
+            }},
+            {"dashboard_kw", [](DisplayManager& d) {
+                d.drawInitialUI();
+                StatusData status;
+                status.internal_temp = 66.0f;
+                status.rssi = -80;
+                status.setTime(7, 5, 9);
+                status.energy_today = 12.75f;
+                status.energy_month = 312.0f;
+                d.drawStatusBar(status, false);
+                d.drawMainDisplay(PowerData(231.1f, 11.9f, 2750.0f), false);
+                for (int i = 0; i < SCREEN_WIDTH + 40; i++) {
+                    d.addGraphSample((i * 131) % 4200);
+                }
+            }},
+            {"dashboard_meters", [](DisplayManager& d) {
+                d.setMeterCount(3);
+                d.drawInitialUI();
+                StatusData status;
+                status.internal_temp = 52.0f;
+                status.rssi = -62;
+                status.setTime(18, 2, 41);
+                status.energy_today = 21.4f;
+                status.energy_month = 402.9f;
+                d.drawStatusBar(status, false);
+                
+                MeterReading meters[3];
+                const PowerData phases[3] = {
+                    PowerData(229.8f, 4.1f, 912.0f),
+                    PowerData(231.6f, 12.4f, 2840.0f),
+                    PowerData(233.0f, 0.6f, 96.0f)
+                };
+                for (int i = 0; i < 3; i++) {
+                    meters[i].data = phases[i];
+                    meters[i].has_data = true;
+                    meters[i].stale = (i == 2);   // Last reading, grayed out
+                }
+                d.drawMainDisplay(PowerData(231.5f, 17.1f, 3848.0f), false);
+                d.drawMeters(meters, false);
+            }},
+            {"fast_boot", [](DisplayManager& d) {
+                StatusData status;
+                status.internal_temp = 38.0f;
+                status.rssi = -100;
+                status.setTime(6, 41, 3);
+                status.energy_today = 0.4f;
+                status.energy_month = 122.6f;
+                d.setStale(true);   // Cached reading, WiFi not up yet
+                d.drawInitialUI(status, PowerData(231.0f, 2.5f, 577.0f));
+            }},
+            {"stale_data", [](DisplayManager& d) {
+                d.drawInitialUI();
+                StatusData status;
+                status.internal_temp = 44.0f;
+                status.rssi = -55;
+                status.setTime(21, 17, 30);
+                status.energy_today = 5.8f;
+                status.energy_month = 140.3f;
+                status.data_age_s = 45;   // Meter stopped answering, WiFi still up
+                d.drawMainDisplay(PowerData(229.9f, 1.8f, 402.0f), false);
+                d.setStale(true);
+                d.drawStatusBar(status, false);
+            }},
+            {"message", [](DisplayManager& d) {
+                d.drawFullScreenMessage("WiFi Failed!\nRetrying in 30s...", 2, ST77XX_RED);
+            }},
+        };
+    }
+    
+    void runGoldens() {
+        std::string golden_dir = std::string(opt.out_dir) + "/golden";
+        if (!makeDir(opt.out_dir) || !makeDir(golden_dir.c_str())) {
+            failures++;
+            return;
+        }
+        
+        printf("GOLDEN,scene,result,diff_pixels,diff_box\n");
+        for (const Scene& scene : scenes()) {
+            if (!selected(scene.name)) continue;
+            
+            quiet();
+            DisplayManager display;
+            display.begin();
+            scene.draw(display);
+            display.waitFlush();
+            loud();
+            
+            const Adafruit_ST7789* panel = display.renderer.panel();
+            int w = panel->width();
+            int h = panel->height();
+            std::vector<uint16_t> actual(panel->getFramebuffer(), panel->getFramebuffer() + w * h);
+            
+            std::string golden_path = golden_dir + "/" + scene.name + ".ppm";
+            std::string actual_path = std::string(opt.out_dir) + "/" + scene.name + ".ppm";
+            writePpm(actual_path.c_str(), actual, w, h);
+            
+            if (opt.update) {
+                bool ok = writePpm(golden_path.c_str(), actual, w, h);
+                printf("GOLDEN,%s,%s,0,\n", scene.name, ok ? "updated" : "write_failed");
+                if (!ok) failures++;
+                continue;
+            }
+            
+            std::vector<uint16_t> golden;
+            if (!readPpm(golden_path.c_str(), golden, w, h)) {
+                printf("GOLDEN,%s,missing,0,\n", scene.name);
+                failures++;
+                continue;
+            }
+            compare(scene.name, golden, actual, w, h);
+        }
+    }
+    
+    /**
+     * Count differing pixels; on a mismatch write <scene>.diff.ppm with the
+     * differences in red over a dimmed copy of the new frame
+     */
+    void compare(const char* name, const std::vector<uint16_t>& golden,
+                 const std::vector<uint16_t>& actual, int w, int h) {
+        int diff_pixels = 0;
+        int x0 = w, y0 = h, x1 = -1, y1 = -1;
+        std::vector<uint16_t> diff(actual.size());
+        
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                int i = y * w + x;
+                if (golden[i] != actual[i]) {
+                    diff_pixels++;
+                    x0 = min(x0, x);
+                    y0 = min(y0, y);
+                    x1 = max(x1, x);
+                    y1 = max(y1, y);
+                    diff[i] = ST77XX_RED;
+                } else {
+                    diff[i] = (actual[i] >> 2) & 0x39E7;    // Each channel / 4
+                }
+            }
+        }
+        
+        if (diff_pixels == 0) {
+            printf("GOLDEN,%s,match,0,\n", name);
+            return;
+        }
+        
+        std::string diff_path = std::string(opt.out_dir) + "/" + name + ".diff.ppm";
+        writePpm(diff_path.c_str(), diff, w, h);
+        printf("GOLDEN,%s,differs,%d,%dx%d+%d+%d\n", name, diff_pixels,
+               x1 - x0 + 1, y1 - y0 + 1, x0, y0);
+        failures++;
+    }
+    
+    static bool makeDir(const char* path) {
+        if (mkdir(path, 0755) == 0 || errno == EEXIST) return true;
+        fprintf(stderr, "Cannot create %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    
+    /**
+     * Binary PPM (8-bit RGB, RGB565 expanded so reading it back is lossless)
+     */
+    static bool writePpm(const char* path, const std::vector<uint16_t>& pixels, int w, int h) {
+        FILE* f = fopen(path, "wb");
+        if (!f) {
+            fprintf(stderr, "Cannot write %s: %s\n", path, strerror(errno));
+            return false;
+        }
+        fprintf(f, "P6\n%d %d\n255\n", w, h);
+        for (uint16_t c : pixels) {
+            uint8_t r = (c >> 11) & 0x1F;
+            uint8_t g = (c >> 5) & 0x3F;
+            uint8_t b = c & 0x1F;
+            uint8_t rgb[3] = {
+                (uint8_t)((r << 3) | (r >> 2)),
+                (uint8_t)((g << 2) | (g >> 4)),
+                (uint8_t)((b << 3) | (b >> 2))
+            };
+            fwrite(rgb, 1, sizeof(rgb), f);
+        }
+        return fclose(f) == 0;
+    }
+    
+    static bool readPpm(const char* path, std::vector<uint16_t>& pixels, int w, int h) {
+        FILE* f = fopen(path, "rb");
+        if (!f) return false;
+        
+        int file_w, file_h, max_value;
+        bool ok = fscanf(f, "P6 %d %d %d", &file_w, &file_h, &max_value) == 3 &&
+                  fgetc(f) != EOF &&
+                  file_w == w && file_h == h && max_value == 255;
+        
+        pixels.assign(w * h, 0);
+        for (int i = 0; ok && i < w * h; i++) {
+            uint8_t rgb[3];
+            ok = fread(rgb, 1, sizeof(rgb), f) == sizeof(rgb);
+            pixels[i] = ((rgb[0] >> 3) << 11) | ((rgb[1] >> 2) << 5) | (rgb[2] >> 3);
+        }
+        fclose(f);
+        return ok;
+    }
+    
+    // =====================================================================
+    // ===                       DEVICE SCENARIOS                        ===
+    // =====================================================================
+    
+    /**
+     * The boot-time benchmark (ENABLE_BENCHMARK), same BENCH CSV as on the device
+     */
+    void runScenarios() {
+        quiet();
+        DisplayManager display;
+        DataFetcher fetcher;
+        display.begin();
+        display.drawInitialUI();
+        Benchmark benchmark(&display, &fetcher);
+        loud();
+        benchmark.run(HOST_FETCH_URL);
+    }
+};
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+            "Usage: %s [--update] [--scenarios] [--verbose] [--out DIR] [--filter NAME]\n"
+            "  --update     record golden images instead of comparing\n"
+            "  --scenarios  also run the boot benchmark scenarios (BENCH CSV)\n"
+            "  --verbose    keep firmware Serial output\n"
+            "  --out DIR    output directory, goldens in DIR/golden (default host/out)\n"
+            "  --filter S   only benchmarks and scenes whose name contains S\n",
+            argv0);
+}
+
+int main(int argc, char** argv) {
+    HostBench::Options options;
+    
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--update")) {
+            options.update = true;
+        } else if (!strcmp(argv[i], "--scenarios")) {
+            options.scenarios = true;
+        } else if (!strcmp(argv[i], "--verbose")) {
+            options.verbose = true;
+        } else if (!strcmp(argv[i], "--out") && i + 1 < argc) {
+            options.out_dir = argv[++i];
+        } else if (!strcmp(argv[i], "--filter") && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    
+    if (!HOST_GFX_REAL_FONT) {
+        fprintf(stderr, "Note: glcdfont.c not on the include path, text uses placeholder glyphs\n");
+    }
+    
+    HostBench bench(options);
+    return bench.run();
+}
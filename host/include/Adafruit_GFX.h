@@ -0,0 +1,327 @@
+/*
+ * Host Shim: Adafruit GFX
+ * Classic-font text and the primitives the v3 display uses, following the
+ * Adafruit_GFX implementation so the output matches the device pixel for pixel
+ *
+ * The classic 5x7 font is taken from the Adafruit GFX library when its
+ * directory is on the include path (glcdfont.c). Without it every glyph is
+ * drawn as a deterministic placeholder: layout and timing stay the same,
+ * golden images only compare against goldens recorded the same way.
+ */
+
+#ifndef HOST_ADAFRUIT_GFX_H
+#define HOST_ADAFRUIT_GFX_H
+
+#include <Arduino.h>
+
+#if __has_include(<glcdfont.c>)
+#include <glcdfont.c>
+#define HOST_GFX_REAL_FONT 1
+#else
+#define HOST_GFX_REAL_FONT 0
+#endif
+
+/**
+ * Column c of glyph ch, bit 0 = top row (same layout as glcdfont.c)
+ */
+inline uint8_t hostFontColumn(unsigned char ch, uint8_t c) {
+#if HOST_GFX_REAL_FONT
+    return font[ch * 5 + c];
+#else
+    if (ch == ' ') return 0;
+    // Outlined cell with a per-character pattern inside
+    if (c == 0 || c == 4) return 0x7F;
+    return 0x41 | (((ch * 7 + c * 13) & 0x1F) << 1);
+#endif
+}
+
+class Adafruit_GFX : public Print {
+public:
+    Adafruit_GFX(int16_t w, int16_t h) :
+        WIDTH(w), HEIGHT(h),
+        _width(w), _height(h),
+        cursor_x(0), cursor_y(0),
+        textcolor(0xFFFF), textbgcolor(0xFFFF),
+        textsize_x(1), textsize_y(1),
+        rotation(0),
+        wrap(true),
+        _cp437(false) {}
+    
+    virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+    
+    virtual void startWrite() {}
+    virtual void endWrite() {}
+    
+    virtual void writePixel(int16_t x, int16_t y, uint16_t color) {
+        drawPixel(x, y, color);
+    }
+    
+    virtual void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+        fillRect(x, y, w, h, color);
+    }
+    
+    virtual void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+        drawFastVLine(x, y, h, color);
+    }
+    
+    virtual void writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+        drawFastHLine(x, y, w, color);
+    }
+    
+    virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+        startWrite();
+        for (int16_t i = y; i < y + h; i++) writePixel(x, i, color);
+        endWrite();
+    }
+    
+    virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+        startWrite();
+        for (int16_t i = x; i < x + w; i++) writePixel(i, y, color);
+        endWrite();
+    }
+    
+    virtual void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+        startWrite();
+        for (int16_t i = x; i < x + w; i++) writeFastVLine(i, y, h, color);
+        endWrite();
+    }
+    
+    virtual void fillScreen(uint16_t color) {
+        fillRect(0, 0, _width, _height, color);
+    }
+    
+    void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+        startWrite();
+        writeFastHLine(x, y, w, color);
+        writeFastHLine(x, y + h - 1, w, color);
+        writeFastVLine(x, y, h, color);
+        writeFastVLine(x + w - 1, y, h, color);
+        endWrite();
+    }
+    
+    virtual void setRotation(uint8_t r) {
+        rotation = r & 3;
+        if (rotation & 1) {
+            _width = HEIGHT;
+            _height = WIDTH;
+        } else {
+            _width = WIDTH;
+            _height = HEIGHT;
+        }
+    }
+    
+    /**
+     * Classic font glyph, 6x8 cell including the spacing column
+     */
+    void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg,
+                  uint8_t size_x, uint8_t size_y) {
+        if (x >= _width || y >= _height ||
+            (x + 6 * size_x - 1) < 0 || (y + 8 * size_y - 1) < 0) {
+            return;
+        }
+        if (!_cp437 && c >= 176) c++; // Matches the library's historical offset
+        
+        startWrite();
+        for (int8_t i = 0; i < 5; i++) {
+            uint8_t line = hostFontColumn(c, i);
+            for (int8_t j = 0; j < 8; j++, line >>= 1) {
+                if (line & 1) {
+                    if (size_x == 1 && size_y == 1) {
+                        writePixel(x + i, y + j, color);
+                    } else {
+                        writeFillRect(x + i * size_x, y + j * size_y, size_x, size_y, color);
+                    }
+                } else if (bg != color) {
+                    if (size_x == 1 && size_y == 1) {
+                        writePixel(x + i, y + j, bg);
+                    } else {
+                        writeFillRect(x + i * size_x, y + j * size_y, size_x, size_y, bg);
+                    }
+                }
+            }
+        }
+        if (bg != color) {
+            if (size_x == 1 && size_y == 1) {
+                writeFastVLine(x + 5, y, 8, bg);
+            } else {
+                writeFillRect(x + 5 * size_x, y, size_x, 8 * size_y, bg);
+            }
+        }
+        endWrite();
+    }
+    
+    void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size) {
+        drawChar(x, y, c, color, bg, size, size);
+    }
+    
+    size_t write(uint8_t c) override {
+        if (c == '\n') {
+            cursor_x = 0;
+            cursor_y += textsize_y * 8;
+        } else if (c != '\r') {
+            if (wrap && (cursor_x + textsize_x * 6) > _width) {
+                cursor_x = 0;
+                cursor_y += textsize_y * 8;
+            }
+            drawChar(cursor_x, cursor_y, c, textcolor, textbgcolor, textsize_x, textsize_y);
+            cursor_x += textsize_x * 6;
+        }
+        return 1;
+    }
+    
+    using Print::write;
+    
+    void getTextBounds(const char* str, int16_t x, int16_t y,
+                       int16_t* x1, int16_t* y1, uint16_t* w, uint16_t* h) {
+        int16_t minx = 0x7FFF, miny = 0x7FFF, maxx = -1, maxy = -1;
+        *x1 = x;
+        *y1 = y;
+        *w = *h = 0;
+        
+        for (unsigned char c; (c = *str++);) {
+            charBounds(c, &x, &y, &minx, &miny, &maxx, &maxy);
+        }
+        if (maxx >= minx) {
+            *x1 = minx;
+            *w = maxx - minx + 1;
+        }
+        if (maxy >= miny) {
+            *y1 = miny;
+            *h = maxy - miny + 1;
+        }
+    }
+    
+    void getTextBounds(const String& str, int16_t x, int16_t y,
+                       int16_t* x1, int16_t* y1, uint16_t* w, uint16_t* h) {
+        getTextBounds(str.c_str(), x, y, x1, y1, w, h);
+    }
+    
+    void setCursor(int16_t x, int16_t y) { cursor_x = x; cursor_y = y; }
+    void setTextColor(uint16_t c) { textcolor = textbgcolor = c; }
+    void setTextColor(uint16_t c, uint16_t bg) { textcolor = c; textbgcolor = bg; }
+    void setTextSize(uint8_t s) { setTextSize(s, s); }
+    void setTextSize(uint8_t sx, uint8_t sy) { textsize_x = sx > 0 ? sx : 1; textsize_y = sy > 0 ? sy : 1; }
+    void setTextWrap(bool w) { wrap = w; }
+    void cp437(bool x = true) { _cp437 = x; }
+    
+    int16_t width() const { return _width; }
+    int16_t height() const { return _height; }
+    uint8_t getRotation() const { return rotation; }
+    int16_t getCursorX() const { return cursor_x; }
+    int16_t getCursorY() const { return cursor_y; }
+
+protected:
+    int16_t WIDTH, HEIGHT;
+    int16_t _width, _height;
+    int16_t cursor_x, cursor_y;
+    uint16_t textcolor, textbgcolor;
+    uint8_t textsize_x, textsize_y;
+    uint8_t rotation;
+    bool wrap;
+    bool _cp437;
+    
+    void charBounds(unsigned char c, int16_t* x, int16_t* y,
+                    int16_t* minx, int16_t* miny, int16_t* maxx, int16_t* maxy) {
+        if (c == '\n') {
+            *x = 0;
+            *y += textsize_y * 8;
+        } else if (c != '\r') {
+            if (wrap && (*x + textsize_x * 6) > _width) {
+                *x = 0;
+                *y += textsize_y * 8;
+            }
+            int x2 = *x + textsize_x * 6 - 1;
+            int y2 = *y + textsize_y * 8 - 1;
+            if (x2 > *maxx) *maxx = x2;
+            if (y2 > *maxy) *maxy = y2;
+            if (*x < *minx) *minx = *x;
+            if (*y < *miny) *miny = *y;
+            *x += textsize_x * 6;
+        }
+    }
+};
+
+/**
+ * 1-bit canvas (glyph cache atlas)
+ */
+class GFXcanvas1 : public Adafruit_GFX {
+public:
+    GFXcanvas1(uint16_t w, uint16_t h) : Adafruit_GFX(w, h) {
+        buffer = (uint8_t*)calloc(((w + 7) / 8) * h, 1);
+    }
+    
+    ~GFXcanvas1() { free(buffer); }
+    
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override {
+        if (!buffer || x < 0 || y < 0 || x >= _width || y >= _height) return;
+        uint8_t* p = &buffer[(x / 8) + y * ((WIDTH + 7) / 8)];
+        if (color) *p |= 0x80 >> (x & 7);
+        else       *p &= ~(0x80 >> (x & 7));
+    }
+    
+    bool getPixel(int16_t x, int16_t y) const {
+        if (!buffer || x < 0 || y < 0 || x >= _width || y >= _height) return false;
+        return buffer[(x / 8) + y * ((WIDTH + 7) / 8)] & (0x80 >> (x & 7));
+    }
+    
+    void fillScreen(uint16_t color) override {
+        if (buffer) memset(buffer, color ? 0xFF : 0x00, ((WIDTH + 7) / 8) * HEIGHT);
+    }
+    
+    uint8_t* getBuffer() const { return buffer; }
+
+private:
+    uint8_t* buffer;
+};
+
+/**
+ * 16-bit canvas (band buffer)
+ */
+class GFXcanvas16 : public Adafruit_GFX {
+public:
+    GFXcanvas16(uint16_t w, uint16_t h, bool allocate_buffer = true) :
+        Adafruit_GFX(w, h),
+        buffer(allocate_buffer ? (uint16_t*)calloc(w * h, sizeof(uint16_t)) : nullptr),
+        buffer_owned(allocate_buffer) {}
+    
+    ~GFXcanvas16() {
+        if (buffer_owned) free(buffer);
+    }
+    
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override {
+        if (!buffer || x < 0 || y < 0 || x >= _width || y >= _height) return;
+        buffer[x + y * WIDTH] = color;
+    }
+    
+    uint16_t getPixel(int16_t x, int16_t y) const {
+        if (!buffer || x < 0 || y < 0 || x >= _width || y >= _height) return 0;
+        return buffer[x + y * WIDTH];
+    }
+    
+    void fillScreen(uint16_t color) override {
+        if (!buffer) return;
+        for (int32_t i = 0; i < (int32_t)WIDTH * HEIGHT; i++) buffer[i] = color;
+    }
+    
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override {
+        if (!buffer || y < 0 || y >= _height) return;
+        int16_t x0 = max(x, (int16_t)0);
+        int16_t x1 = min((int16_t)(x + w), _width);
+        for (int16_t i = x0; i < x1; i++) buffer[i + y * WIDTH] = color;
+    }
+    
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override {
+        if (!buffer || x < 0 || x >= _width) return;
+        int16_t y0 = max(y, (int16_t)0);
+        int16_t y1 = min((int16_t)(y + h), _height);
+        for (int16_t j = y0; j < y1; j++) buffer[x + j * WIDTH] = color;
+    }
+    
+    uint16_t* getBuffer() const { return buffer; }
+
+protected:
+    uint16_t* buffer;       // Subclasses may supply their own (allocate_buffer = false)
+    bool buffer_owned;
+};
+
+#endif // HOST_ADAFRUIT_GFX_H
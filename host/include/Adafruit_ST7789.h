@@ -0,0 +1,159 @@
+/*
+ * Host Shim: Adafruit ST7789
+ * The panel is an in-memory RGB565 framebuffer in rotated (logical)
+ * coordinates; pixel and address-window counts stand in for SPI traffic
+ */
+
+#ifndef HOST_ADAFRUIT_ST7789_H
+#define HOST_ADAFRUIT_ST7789_H
+
+#include <Adafruit_GFX.h>
+#include <SPI.h>
+#include <vector>
+
+#define ST77XX_BLACK    0x0000
+#define ST77XX_WHITE    0xFFFF
+#define ST77XX_RED      0xF800
+#define ST77XX_GREEN    0x07E0
+#define ST77XX_BLUE     0x001F
+#define ST77XX_CYAN     0x07FF
+#define ST77XX_MAGENTA  0xF81F
+#define ST77XX_YELLOW   0xFFE0
+#define ST77XX_ORANGE   0xFC00
+
+class Adafruit_SPITFT : public Adafruit_GFX {
+public:
+    Adafruit_SPITFT(uint16_t w, uint16_t h) :
+        Adafruit_GFX(w, h),
+        window_x(0), window_y(0), window_w(0), window_h(0), window_pos(0),
+        pixels_written(0),
+        windows_set(0) {}
+    
+    void setAddrWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+        window_x = x;
+        window_y = y;
+        window_w = w;
+        window_h = h;
+        window_pos = 0;
+        windows_set++;
+    }
+    
+    /**
+     * Stream pixels into the address window (row-major, wraps like RAMWR)
+     */
+    void writePixels(uint16_t* colors, uint32_t len, bool block = true, bool bigEndian = false) {
+        for (uint32_t i = 0; i < len; i++) {
+            storeWindowPixel(colors[i]);
+        }
+    }
+    
+    void writeColor(uint16_t color, uint32_t len) {
+        for (uint32_t i = 0; i < len; i++) {
+            storeWindowPixel(color);
+        }
+    }
+    
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override {
+        if (x < 0 || y < 0 || x >= _width || y >= _height) return;
+        setAddrWindow(x, y, 1, 1);
+        storeWindowPixel(color);
+    }
+    
+    void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override {
+        fillRect(x, y, w, h, color);
+    }
+    
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override {
+        // Clip like the library, then one window for the whole rectangle
+        if (x < 0) { w += x; x = 0; }
+        if (y < 0) { h += y; y = 0; }
+        if (x + w > _width) w = _width - x;
+        if (y + h > _height) h = _height - y;
+        if (w <= 0 || h <= 0) return;
+        setAddrWindow(x, y, w, h);
+        writeColor(color, (uint32_t)w * h);
+    }
+    
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override {
+        fillRect(x, y, w, 1, color);
+    }
+    
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override {
+        fillRect(x, y, 1, h, color);
+    }
+    
+    void invertDisplay(bool) {}
+    void enableDisplay(bool) {}
+    void enableSleep(bool) {}
+    
+    uint16_t color565(uint8_t r, uint8_t g, uint8_t b) {
+        return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+    }
+    
+    // --- Host only ---
+    
+    const uint16_t* getFramebuffer() const { return framebuffer.data(); }
+    
+    uint16_t getPixel(int16_t x, int16_t y) const {
+        if (x < 0 || y < 0 || x >= _width || y >= _height) return 0;
+        return framebuffer[y * _width + x];
+    }
+    
+    /**
+     * Pixels sent since the last resetCounters() (SPI payload / 2 bytes)
+     */
+    uint32_t getPixelsWritten() const { return pixels_written; }
+    
+    /**
+     * Address windows set (each costs CASET/RASET/RAMWR on the wire)
+     */
+    uint32_t getWindowsSet() const { return windows_set; }
+    
+    void resetCounters() {
+        pixels_written = 0;
+        windows_set = 0;
+    }
+
+protected:
+    std::vector<uint16_t> framebuffer;
+    
+    void allocateFramebuffer() {
+        framebuffer.assign((size_t)WIDTH * HEIGHT, 0x0000);
+    }
+
+private:
+    int16_t window_x, window_y, window_w, window_h;
+    uint32_t window_pos;
+    uint32_t pixels_written;
+    uint32_t windows_set;
+    
+    void storeWindowPixel(uint16_t color) {
+        pixels_written++;
+        if (window_w <= 0 || window_h <= 0) return;
+        int32_t px = window_x + window_pos % window_w;
+        int32_t py = window_y + (window_pos / window_w) % window_h;
+        window_pos++;
+        if (px < _width && py < _height && !framebuffer.empty()) {
+            framebuffer[py * _width + px] = color;
+        }
+    }
+};
+
+class Adafruit_ST7789 : public Adafruit_SPITFT {
+public:
+    Adafruit_ST7789(int8_t cs, int8_t dc, int8_t rst) : Adafruit_SPITFT(240, 320) {}
+    Adafruit_ST7789(int8_t cs, int8_t dc, int8_t mosi, int8_t sclk, int8_t rst) : Adafruit_SPITFT(240, 320) {}
+    
+    void init(uint16_t width, uint16_t height, uint8_t spiMode = SPI_MODE0) {
+        WIDTH = width;
+        HEIGHT = height;
+        setRotation(0);
+        allocateFramebuffer();
+    }
+    
+    void setRotation(uint8_t m) override {
+        Adafruit_GFX::setRotation(m);
+    }
+};
+
+#endif // HOST_ADAFRUIT_ST7789_H
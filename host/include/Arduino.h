@@ -0,0 +1,280 @@
+/*
+ * Host Shim: Arduino Core
+ * Just enough of the ESP32 Arduino core to compile the v3 headers on a
+ * desktop: String, Print/Stream, Serial on stdout and a monotonic clock
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <thread>
+
+#define HOST_BUILD 1
+
+// ArduinoJson only adapts String when told so (ARDUINO is not defined here)
+#ifndef ARDUINOJSON_ENABLE_ARDUINO_STRING
+#define ARDUINOJSON_ENABLE_ARDUINO_STRING 1
+#endif
+
+#define PROGMEM
+#define F(s) (s)
+
+#define LOW     0
+#define HIGH    1
+#define INPUT   0
+#define OUTPUT  1
+
+// Same as the ESP32 core: std::min/max, so mixed-type calls fail here too
+using std::abs;
+using std::max;
+using std::min;
+using ::round;
+
+#ifndef constrain
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#endif
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+// =========================================================================
+// ===                             TIME                                  ===
+// =========================================================================
+
+inline std::chrono::steady_clock::time_point hostBootTime() {
+    static const std::chrono::steady_clock::time_point boot = std::chrono::steady_clock::now();
+    return boot;
+}
+
+inline unsigned long millis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - hostBootTime()).count();
+}
+
+inline unsigned long micros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - hostBootTime()).count();
+}
+
+inline void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+inline void delayMicroseconds(unsigned int us) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+inline void yield() {}
+
+// =========================================================================
+// ===                            GPIO / SOC                             ===
+// =========================================================================
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+
+/**
+ * Fixed so that screens showing the chip temperature are reproducible
+ */
+inline float temperatureRead() {
+    return 42.0f;
+}
+
+class EspClass {
+public:
+    uint32_t getFreeHeap() { return 200000; }
+    uint32_t getMinFreeHeap() { return 180000; }
+    uint32_t getMaxAllocHeap() { return 110000; }
+    uint32_t getCpuFreqMHz() { return 160; }
+    
+    /**
+     * Nanoseconds scaled to a 160 MHz cycle count (the profiler divides
+     * by getCpuFreqMHz() again)
+     */
+    uint32_t getCycleCount() {
+        uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - hostBootTime()).count();
+        return (uint32_t)(ns * getCpuFreqMHz() / 1000);
+    }
+    
+    void restart() { exit(0); }
+};
+
+inline EspClass ESP;
+
+// =========================================================================
+// ===                             STRING                                ===
+// =========================================================================
+
+class String {
+public:
+    String(const char* s = "") : value(s ? s : "") {}
+    String(const std::string& s) : value(s) {}
+    String(char c) : value(1, c) {}
+    String(int v) : value(std::to_string(v)) {}
+    String(unsigned int v) : value(std::to_string(v)) {}
+    String(long v) : value(std::to_string(v)) {}
+    String(unsigned long v) : value(std::to_string(v)) {}
+    String(double v, unsigned int decimals = 2) {
+        char buffer[48];
+        snprintf(buffer, sizeof(buffer), "%.*f", decimals, v);
+        value = buffer;
+    }
+    
+    const char* c_str() const { return value.c_str(); }
+    unsigned int length() const { return value.size(); }
+    bool isEmpty() const { return value.empty(); }
+    
+    char operator[](unsigned int i) const { return i < value.size() ? value[i] : '\0'; }
+    char charAt(unsigned int i) const { return (*this)[i]; }
+    
+    bool concat(const String& s) { value += s.value; return true; }
+    bool concat(const char* s) { if (s) value += s; return true; }
+    bool concat(char c) { value += c; return true; }
+    
+    String& operator+=(const String& s) { concat(s); return *this; }
+    String& operator+=(const char* s) { concat(s); return *this; }
+    String& operator+=(char c) { concat(c); return *this; }
+    
+    bool operator==(const String& s) const { return value == s.value; }
+    bool operator!=(const String& s) const { return value != s.value; }
+    bool operator==(const char* s) const { return value == (s ? s : ""); }
+    bool operator!=(const char* s) const { return !(*this == s); }
+    
+    int indexOf(char c, unsigned int from = 0) const {
+        size_t pos = value.find(c, from);
+        return pos == std::string::npos ? -1 : (int)pos;
+    }
+    
+    String substring(unsigned int from, unsigned int to = UINT32_MAX) const {
+        if (from >= value.size()) return String();
+        return String(value.substr(from, min((size_t)to, value.size()) - from));
+    }
+    
+    long toInt() const { return atol(value.c_str()); }
+    float toFloat() const { return atof(value.c_str()); }
+    
+    // Used by ArduinoJson's String adapter
+    bool reserve(unsigned int size) { value.reserve(size); return true; }
+
+private:
+    std::string value;
+};
+
+inline String operator+(const String& a, const String& b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, const char* b) { String r(a); r += b; return r; }
+inline String operator+(const char* a, const String& b) { String r(a); r += b; return r; }
+
+// =========================================================================
+// ===                          PRINT / STREAM                           ===
+// =========================================================================
+
+class Print {
+public:
+    virtual ~Print() {}
+    
+    virtual size_t write(uint8_t c) = 0;
+    
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        size_t n = 0;
+        while (size--) n += write(*buffer++);
+        return n;
+    }
+    
+    size_t write(const char* s) { return s ? write((const uint8_t*)s, strlen(s)) : 0; }
+    
+    size_t print(const char* s) { return write(s); }
+    size_t print(const String& s) { return write((const uint8_t*)s.c_str(), s.length()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int v) { return printf("%d", v); }
+    size_t print(unsigned int v) { return printf("%u", v); }
+    size_t print(long v) { return printf("%ld", v); }
+    size_t print(unsigned long v) { return printf("%lu", v); }
+    size_t print(double v, int decimals = 2) { return printf("%.*f", decimals, v); }
+    
+    size_t println() { return write("\r\n"); }
+    template<typename T> size_t println(T v) { size_t n = print(v); return n + println(); }
+    size_t println(double v, int decimals) { size_t n = print(v, decimals); return n + println(); }
+    
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        char buffer[512];
+        va_list args;
+        va_start(args, format);
+        int len = vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        if (len < 0) return 0;
+        return write((const uint8_t*)buffer, min((size_t)len, sizeof(buffer) - 1));
+    }
+};
+
+/**
+ * Non-blocking: reads return what is buffered, there is no timeout to wait on
+ */
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() { return -1; }
+    virtual void flush() {}
+    
+    void setTimeout(unsigned long) {}
+    
+    size_t readBytes(char* buffer, size_t length) {
+        size_t n = 0;
+        while (n < length) {
+            int c = read();
+            if (c < 0) break;
+            buffer[n++] = (char)c;
+        }
+        return n;
+    }
+    
+    size_t readBytes(uint8_t* buffer, size_t length) {
+        return readBytes((char*)buffer, length);
+    }
+};
+
+/**
+ * Serial goes to stdout; setOutput(nullptr) discards it (host only)
+ */
+class HardwareSerial : public Stream {
+public:
+    HardwareSerial() : out(stdout) {}
+    
+    void begin(unsigned long) {}
+    void setOutput(FILE* file) { out = file; }
+    
+    size_t write(uint8_t c) override {
+        if (out) fputc(c, out);
+        return 1;
+    }
+    
+    size_t write(const uint8_t* buffer, size_t size) override {
+        if (out) fwrite(buffer, 1, size, out);
+        return size;
+    }
+    
+    int available() override { return 0; }
+    int read() override { return -1; }
+    void flush() override { if (out) fflush(out); }
+    
+    using Print::write;
+
+private:
+    FILE* out;
+};
+
+inline HardwareSerial Serial;
+
+#endif // HOST_ARDUINO_H
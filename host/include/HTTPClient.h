@@ -0,0 +1,108 @@
+/*
+ * Host Shim: HTTPClient
+ * Every GET is answered from hostHttpResponse without touching the network
+ */
+
+#ifndef HOST_HTTP_CLIENT_H
+#define HOST_HTTP_CLIENT_H
+
+#include <WiFi.h>
+
+#define HTTP_CODE_OK                     200
+
+#define HTTPC_ERROR_CONNECTION_REFUSED   (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED   (-2)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED  (-3)
+#define HTTPC_ERROR_NOT_CONNECTED        (-4)
+#define HTTPC_ERROR_CONNECTION_LOST      (-5)
+#define HTTPC_ERROR_READ_TIMEOUT         (-11)
+
+/**
+ * Canned response (host only)
+ */
+struct HostHttpResponse {
+    int code = HTTP_CODE_OK;
+    std::string body = "{\"voltage\":230.4,\"current\":3.12,\"power_active\":734.0}";
+    bool chunked = false;       // No Content-Length: getSize() returns -1
+    bool keep_alive = true;     // Server keeps the connection open after the response
+    uint32_t latency_us = 0;    // Simulated time to first byte
+};
+
+inline HostHttpResponse hostHttpResponse;
+
+class HTTPClient {
+public:
+    HTTPClient() : client(nullptr), reuse(true) {}
+    
+    bool begin(WiFiClient& wifi_client, const String& url) {
+        client = &wifi_client;
+        return true;
+    }
+    
+    bool begin(const String& url) {
+        client = &own_client;
+        return true;
+    }
+    
+    void end() {
+        if (client && !(reuse && hostHttpResponse.keep_alive)) {
+            client->stop();
+        }
+        client = nullptr;
+    }
+    
+    void setReuse(bool enable) { reuse = enable; }
+    void setTimeout(uint16_t) {}
+    void setConnectTimeout(int32_t) {}
+    void addHeader(const String&, const String&) {}
+    
+    int GET() {
+        if (!client) return HTTPC_ERROR_NOT_CONNECTED;
+        if (!client->connected() && !client->connect("host", 80)) {
+            return HTTPC_ERROR_CONNECTION_REFUSED;
+        }
+        if (hostHttpResponse.latency_us) {
+            delayMicroseconds(hostHttpResponse.latency_us);
+        }
+        client->load(hostHttpResponse.body);
+        return hostHttpResponse.code;
+    }
+    
+    int getSize() {
+        return hostHttpResponse.chunked ? -1 : (int)hostHttpResponse.body.size();
+    }
+    
+    String getString() {
+        if (!client) return String();
+        std::string rest;
+        int c;
+        while ((c = client->read()) >= 0) rest += (char)c;
+        return String(rest);
+    }
+    
+    /**
+     * The canned body is never chunk-encoded, so this copies what is left
+     */
+    int writeToStream(Stream* stream) {
+        if (!client || !stream) return HTTPC_ERROR_NOT_CONNECTED;
+        int total = 0;
+        int c;
+        while ((c = client->read()) >= 0) total += stream->write((uint8_t)c);
+        return total;
+    }
+    
+    WiFiClient* getStreamPtr() { return client; }
+    WiFiClient& getStream() { return *client; }
+    bool connected() { return client && client->connected(); }
+    
+    static String errorToString(int error) {
+        return String("host error ") + String(error);
+    }
+
+private:
+    WiFiClient* client;
+    WiFiClient own_client;
+    bool reuse;
+};
+
+#endif // HOST_HTTP_CLIENT_H
@@ -0,0 +1,20 @@
+/*
+ * Host Shim: SPI
+ */
+
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+
+#include <Arduino.h>
+
+#define SPI_MODE0  0
+
+class SPIClass {
+public:
+    void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1) {}
+    void end() {}
+};
+
+inline SPIClass SPI;
+
+#endif // HOST_SPI_H
@@ -0,0 +1,123 @@
+/*
+ * Host Shim: WiFi
+ * Always connected; WiFiClient serves whatever HTTPClient loaded into it
+ */
+
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include <Arduino.h>
+
+#define WL_IDLE_STATUS   0
+#define WL_NO_SSID_AVAIL 1
+#define WL_CONNECTED     3
+#define WL_CONNECT_FAILED 4
+#define WL_DISCONNECTED  6
+
+#define WIFI_OFF  0
+#define WIFI_STA  1
+
+typedef int wl_status_t;
+
+class IPAddress {
+public:
+    IPAddress() : address(0) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) :
+        address((uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)c << 16) | ((uint32_t)d << 24)) {}
+    
+    uint8_t operator[](int i) const { return (address >> (8 * i)) & 0xFF; }
+    operator uint32_t() const { return address; }
+    
+    String toString() const {
+        char buffer[16];
+        snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u",
+                 (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+        return String(buffer);
+    }
+
+private:
+    uint32_t address;
+};
+
+class WiFiClient : public Stream {
+public:
+    WiFiClient() : is_connected(false), position(0) {}
+    
+    /**
+     * Succeeds unless hostWiFiClientRefuse is set (host only)
+     */
+    int connect(const char* host, uint16_t port, int32_t timeout_ms = 0);
+    int connect(IPAddress ip, uint16_t port) { return connect(ip.toString().c_str(), port); }
+    
+    uint8_t connected() { return is_connected; }
+    operator bool() { return is_connected; }
+    
+    void stop() {
+        is_connected = false;
+        body.clear();
+        position = 0;
+    }
+    
+    int available() override { return (int)(body.size() - position); }
+    
+    int read() override {
+        return position < body.size() ? (uint8_t)body[position++] : -1;
+    }
+    
+    int read(uint8_t* buffer, size_t size) {
+        size_t n = min(size, body.size() - position);
+        memcpy(buffer, body.data() + position, n);
+        position += n;
+        return (int)n;
+    }
+    
+    int peek() override {
+        return position < body.size() ? (uint8_t)body[position] : -1;
+    }
+    
+    size_t write(uint8_t) override { return is_connected ? 1 : 0; }
+    size_t write(const uint8_t*, size_t size) override { return is_connected ? size : 0; }
+    using Print::write;
+    
+    int setNoDelay(bool) { return 0; }
+    IPAddress remoteIP() { return IPAddress(127, 0, 0, 1); }
+    
+    // --- Host only ---
+    
+    /**
+     * Queue a response body for the reads that follow
+     */
+    void load(const std::string& data) {
+        body = data;
+        position = 0;
+    }
+
+private:
+    bool is_connected;
+    std::string body;
+    size_t position;
+};
+
+inline bool hostWiFiClientRefuse = false;
+
+inline int WiFiClient::connect(const char* host, uint16_t port, int32_t timeout_ms) {
+    is_connected = !hostWiFiClientRefuse;
+    return is_connected;
+}
+
+class WiFiClass {
+public:
+    wl_status_t status() { return WL_CONNECTED; }
+    bool mode(int) { return true; }
+    bool setHostname(const char*) { return true; }
+    wl_status_t begin(const char*, const char* = nullptr) { return WL_CONNECTED; }
+    bool disconnect(bool = false) { return true; }
+    bool reconnect() { return true; }
+    
+    int8_t RSSI() { return -60; }
+    IPAddress localIP() { return IPAddress(192, 168, 1, 50); }
+};
+
+inline WiFiClass WiFi;
+
+#endif // HOST_WIFI_H
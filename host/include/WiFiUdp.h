@@ -0,0 +1,29 @@
+/*
+ * Host Shim: WiFiUdp
+ * Nothing is ever received
+ */
+
+#ifndef HOST_WIFI_UDP_H
+#define HOST_WIFI_UDP_H
+
+#include <WiFi.h>
+
+class WiFiUDP : public Stream {
+public:
+    uint8_t begin(uint16_t port) { return 1; }
+    void stop() {}
+    
+    int parsePacket() { return 0; }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int read(char* buffer, size_t size) { return 0; }
+    int read(unsigned char* buffer, size_t size) { return 0; }
+    
+    size_t write(uint8_t) override { return 1; }
+    using Print::write;
+    
+    IPAddress remoteIP() { return IPAddress(); }
+    uint16_t remotePort() { return 0; }
+};
+
+#endif // HOST_WIFI_UDP_H
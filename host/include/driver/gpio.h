@@ -0,0 +1,17 @@
+/*
+ * Host Shim: GPIO driver
+ */
+
+#ifndef HOST_DRIVER_GPIO_H
+#define HOST_DRIVER_GPIO_H
+
+#include <stdint.h>
+
+typedef int esp_err_t;
+typedef int gpio_num_t;
+
+inline esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level) {
+    return 0;
+}
+
+#endif // HOST_DRIVER_GPIO_H
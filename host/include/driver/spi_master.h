@@ -0,0 +1,105 @@
+/*
+ * Host Shim: SPI master driver
+ * Bus initialisation fails, so DmaFlusher reports DMA unavailable and
+ * DisplayManager takes the blocking flush into the mock panel
+ */
+
+#ifndef HOST_DRIVER_SPI_MASTER_H
+#define HOST_DRIVER_SPI_MASTER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <freertos/FreeRTOS.h>
+
+typedef int esp_err_t;
+
+#define ESP_OK                 0
+#define ESP_FAIL               (-1)
+#define ESP_ERR_INVALID_STATE  0x103
+#define ESP_ERR_NOT_SUPPORTED  0x106
+
+typedef enum {
+    SPI1_HOST = 0,
+    SPI2_HOST = 1
+} spi_host_device_t;
+
+#define SPI_DMA_CH_AUTO       3
+#define SPI_TRANS_USE_TXDATA  (1 << 3)
+#define SPI_DEVICE_NO_DUMMY   (1 << 6)
+
+struct spi_transaction_t;
+typedef void (*transaction_cb_t)(spi_transaction_t* trans);
+
+typedef struct {
+    int mosi_io_num;
+    int miso_io_num;
+    int sclk_io_num;
+    int quadwp_io_num;
+    int quadhd_io_num;
+    int max_transfer_sz;
+    uint32_t flags;
+    int intr_flags;
+} spi_bus_config_t;
+
+typedef struct {
+    uint8_t command_bits;
+    uint8_t address_bits;
+    uint8_t dummy_bits;
+    uint8_t mode;
+    uint16_t duty_cycle_pos;
+    uint16_t cs_ena_pretrans;
+    uint8_t cs_ena_posttrans;
+    int clock_speed_hz;
+    int input_delay_ns;
+    int spics_io_num;
+    uint32_t flags;
+    int queue_size;
+    transaction_cb_t pre_cb;
+    transaction_cb_t post_cb;
+} spi_device_interface_config_t;
+
+struct spi_transaction_t {
+    uint32_t flags;
+    uint16_t cmd;
+    uint64_t addr;
+    size_t length;
+    size_t rxlength;
+    void* user;
+    union {
+        const void* tx_buffer;
+        uint8_t tx_data[4];
+    };
+    union {
+        void* rx_buffer;
+        uint8_t rx_data[4];
+    };
+};
+
+typedef struct spi_device_t* spi_device_handle_t;
+
+inline esp_err_t spi_bus_initialize(spi_host_device_t, const spi_bus_config_t*, int) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+inline esp_err_t spi_bus_free(spi_host_device_t) {
+    return ESP_ERR_INVALID_STATE;
+}
+
+inline esp_err_t spi_bus_add_device(spi_host_device_t, const spi_device_interface_config_t*,
+                                    spi_device_handle_t*) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+inline esp_err_t spi_bus_remove_device(spi_device_handle_t) {
+    return ESP_ERR_INVALID_STATE;
+}
+
+inline esp_err_t spi_device_queue_trans(spi_device_handle_t, spi_transaction_t*, TickType_t) {
+    return ESP_ERR_INVALID_STATE;
+}
+
+inline esp_err_t spi_device_get_trans_result(spi_device_handle_t, spi_transaction_t**, TickType_t) {
+    return ESP_ERR_INVALID_STATE;
+}
+
+#endif // HOST_DRIVER_SPI_MASTER_H
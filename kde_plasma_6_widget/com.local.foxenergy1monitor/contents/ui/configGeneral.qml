@@ -8,6 +8,8 @@ ScrollView {
     
     // Map the UI elements to the settings in main.xml
     property alias cfg_apiUrl: apiUrlField.text
+    property alias cfg_streamUrl: streamUrlField.text
+    property alias cfg_historyUrl: historyUrlField.text
     property alias cfg_textSize: textSizeField.value
     property alias cfg_desktopTextSize: desktopTextSizeField.value
     property alias cfg_thresholdOrange: orangeField.value
@@ -28,6 +30,20 @@ ScrollView {
         Layout.minimumWidth: Kirigami.Units.gridUnit * 28
     }
 
+    TextField {
+        id: streamUrlField
+        Kirigami.FormData.label: "Stream URL (optional):"
+        placeholderText: "http://DISPLAY_IP/api/stream"
+        Layout.fillWidth: true
+    }
+
+    TextField {
+        id: historyUrlField
+        Kirigami.FormData.label: "History URL (optional):"
+        placeholderText: "http://DISPLAY_IP/api/history.bin?tier=minutes"
+        Layout.fillWidth: true
+    }
+
     SpinBox {
         id: textSizeField
         Kirigami.FormData.label: "Taskbar Text Size:"
@@ -15,17 +15,128 @@ PlasmoidItem {
     property string frequency: "0.0"
     property string powerFactor: "0.0"
     
+    // Server-Sent Events stream state (used when streamUrl is set)
+    readonly property bool streaming: Plasmoid.configuration.streamUrl !== ""
+    property var streamXhr: null
+    property int streamOffset: 0
+    property int streamEvents: 0
+    property int lastSeq: 0
+    
+    // Power history from the display's binary endpoint (used when historyUrl is set)
+    property var historyPower: []
+    property int historyInterval: 60
+    readonly property real historyPeak: historyPower.length > 0 ? Math.max.apply(null, historyPower) : 0
+    
     Layout.minimumWidth: 200
     Layout.minimumHeight: 200
 
     Timer {
         id: dataTimer
         interval: 5000 
-        running: true
+        running: !root.streaming
         repeat: true
         triggeredOnStart: true
         onTriggered: fetchData()
     }
+    
+    Timer {
+        id: historyTimer
+        interval: 300000
+        running: Plasmoid.configuration.historyUrl !== ""
+        repeat: true
+        triggeredOnStart: true
+        onTriggered: fetchHistory()
+    }
+    
+    Timer {
+        id: reconnectTimer
+        interval: 5000
+        repeat: false
+        onTriggered: root.openStream()
+    }
+    
+    Component.onCompleted: {
+        if (streaming) openStream();
+    }
+    
+    onStreamingChanged: {
+        if (streaming) {
+            openStream();
+        } else if (streamXhr) {
+            var xhr = streamXhr;
+            streamXhr = null;
+            xhr.abort();
+        }
+    }
+    
+    function applyData(data) {
+        if (data.status === "ok") {
+            root.statusText = "Online";
+            root.voltage = field(data, "voltage");
+            root.current = field(data, "current");
+            root.powerActive = parseFloat(data.power_active) || 0;
+            // Not provided by the display's local API
+            root.powerReactive = field(data, "power_reactive");
+            root.frequency = field(data, "frequency");
+            root.powerFactor = field(data, "power_factor");
+        } else {
+            root.statusText = "Error: " + data.status;
+        }
+    }
+    
+    // One long-lived request; events are parsed as they arrive (LOADING)
+    function openStream() {
+        reconnectTimer.stop();
+        if (streamXhr) {
+            var old = streamXhr;
+            streamXhr = null;
+            old.abort();
+        }
+        
+        var xhr = new XMLHttpRequest();
+        streamXhr = xhr;
+        streamOffset = 0;
+        streamEvents = 0;
+        xhr.open("GET", Plasmoid.configuration.streamUrl, true);
+        xhr.onreadystatechange = function() {
+            if (xhr !== root.streamXhr) return;
+            if (xhr.readyState === XMLHttpRequest.LOADING) {
+                consumeStream(xhr.responseText);
+            } else if (xhr.readyState === XMLHttpRequest.DONE) {
+                root.statusText = "Offline";
+                root.streamXhr = null;
+                reconnectTimer.start();
+            }
+        }
+        xhr.send();
+    }
+    
+    function consumeStream(text) {
+        var end = text.lastIndexOf("\n\n");
+        if (end < streamOffset) return;
+        
+        var events = text.substring(streamOffset, end).split("\n\n");
+        streamOffset = end + 2;
+        
+        for (var i = 0; i < events.length; i++) {
+            var lines = events[i].split("\n");
+            for (var j = 0; j < lines.length; j++) {
+                if (lines[j].indexOf("id: ") === 0) {
+                    root.lastSeq = parseInt(lines[j].substring(4));
+                } else if (lines[j].indexOf("data: ") === 0) {
+                    try {
+                        applyData(JSON.parse(lines[j].substring(6)));
+                    } catch(e) {
+                        root.statusText = "JSON Parse Error";
+                    }
+                    streamEvents++;
+                }
+            }
+        }
+        
+        // responseText keeps growing; start a fresh request now and then
+        if (streamEvents >= 1000) Qt.callLater(openStream);
+    }
 
     function fetchData() {
         var xhr = new XMLHttpRequest();
@@ -35,18 +146,7 @@ PlasmoidItem {
             if (xhr.readyState === XMLHttpRequest.DONE) {
                 if (xhr.status === 200) {
                     try {
-                        var data = JSON.parse(xhr.responseText);
-                        if (data.status === "ok") {
-                            root.statusText = "Online";
-                            root.voltage = data.voltage;
-                            root.current = data.current;
-                            root.powerActive = parseFloat(data.power_active);
-                            root.powerReactive = data.power_reactive;
-                            root.frequency = data.frequency;
-                            root.powerFactor = data.power_factor;
-                        } else {
-                            root.statusText = "Error: " + data.status;
-                        }
+                        applyData(JSON.parse(xhr.responseText));
                     } catch(e) {
                         root.statusText = "JSON Parse Error";
                     }
@@ -58,6 +158,43 @@ PlasmoidItem {
         xhr.send();
     }
 
+    // One request for the whole tier; a day of minutes is about 8.6 KB
+    function fetchHistory() {
+        var xhr = new XMLHttpRequest();
+        xhr.open("GET", Plasmoid.configuration.historyUrl, true);
+        xhr.responseType = "arraybuffer";
+        xhr.onreadystatechange = function() {
+            if (xhr.readyState === XMLHttpRequest.DONE && xhr.status === 200 && xhr.response) {
+                parseHistory(xhr.response);
+            }
+        }
+        xhr.send();
+    }
+    
+    // Version 1 of the display's binary history: 16-byte header, then
+    // little-endian uint16 records of voltage, current and power
+    function parseHistory(buffer) {
+        if (buffer.byteLength < 16) return;
+        var view = new DataView(buffer);
+        var magic = String.fromCharCode(view.getUint8(0), view.getUint8(1), view.getUint8(2));
+        if (magic !== "FXH" || view.getUint8(3) !== 1) return;
+        
+        var count = view.getUint16(6, true);
+        var size = view.getUint8(12);
+        if (size < 6 || buffer.byteLength < 16 + count * size) return;
+        
+        var power = new Array(count);
+        for (var i = 0; i < count; i++) {
+            power[i] = view.getUint16(16 + i * size + 4, true);
+        }
+        root.historyInterval = view.getUint16(4, true);
+        root.historyPower = power;
+    }
+
+    function field(data, key) {
+        return data[key] !== undefined ? data[key] : "--";
+    }
+
     function formatPowerText(watts) {
         if (watts >= 1000) {
             return (watts / 1000).toFixed(1).replace(".", ",") + " kW";
@@ -96,7 +233,7 @@ PlasmoidItem {
     // DESKTOP MODE (Full)
     fullRepresentation: Item {
         Layout.minimumWidth: 250
-        Layout.minimumHeight: 220
+        Layout.minimumHeight: historyCanvas.visible ? 320 : 220
 
         ColumnLayout {
             anchors.fill: parent
@@ -172,6 +309,48 @@ PlasmoidItem {
                     font.pixelSize: Plasmoid.configuration.desktopTextSize
                 }
             }
+            Canvas {
+                id: historyCanvas
+                visible: root.historyPower.length > 1
+                Layout.fillWidth: true
+                Layout.preferredHeight: 70
+                
+                property var samples: root.historyPower
+                onSamplesChanged: requestPaint()
+                onWidthChanged: requestPaint()
+                
+                onPaint: {
+                    var ctx = getContext("2d");
+                    ctx.clearRect(0, 0, width, height);
+                    var n = samples.length;
+                    if (n < 2) return;
+                    
+                    var peak = Math.max(root.historyPeak, 1);
+                    ctx.strokeStyle = root.getPowerColor(root.historyPeak);
+                    ctx.lineWidth = 1;
+                    ctx.beginPath();
+                    for (var i = 0; i < n; i++) {
+                        var x = i * (width - 1) / (n - 1);
+                        var y = height - 1 - samples[i] / peak * (height - 2);
+                        if (i === 0) {
+                            ctx.moveTo(x, y);
+                        } else {
+                            ctx.lineTo(x, y);
+                        }
+                    }
+                    ctx.stroke();
+                }
+            }
+            
+            PlasmaComponents.Label {
+                visible: historyCanvas.visible
+                text: "Last " + (root.historyPower.length * root.historyInterval / 3600).toFixed(1) +
+                      " h, peak " + root.formatPowerText(root.historyPeak)
+                font.pixelSize: Plasmoid.configuration.desktopTextSize
+                opacity: 0.7
+                Layout.alignment: Qt.AlignHCenter
+            }
+            
             Item { Layout.fillHeight: true }
         }
     }